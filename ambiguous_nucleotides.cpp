@@ -0,0 +1,217 @@
+#include "ambiguous_nucleotides.hpp"
+#include "nucleotide_kernels.hpp"
+#include "packed_search.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+/* ----- Ambiguous Nucleotides Utility Functions ----- */
+
+/*
+    * Returns the first run ending after 'index', the runs before it lie entirely before 'index'.
+*/
+static inline std::vector<AmbiguousRun>::const_iterator runAfter(const std::vector<AmbiguousRun> &runs, size_t index) {
+    return std::partition_point(runs.begin(), runs.end(),
+        [index](const AmbiguousRun &run) { return run.start + run.size <= index; });
+}
+
+
+char ambiguityCode(char character) {
+    switch(character) {
+        case 'n': case 'N': return 'N';
+        case 'r': case 'R': return 'R';
+        case 'y': case 'Y': return 'Y';
+        case 's': case 'S': return 'S';
+        case 'w': case 'W': return 'W';
+        case 'k': case 'K': return 'K';
+        case 'm': case 'M': return 'M';
+        case 'b': case 'B': return 'B';
+        case 'd': case 'D': return 'D';
+        case 'h': case 'H': return 'H';
+        case 'v': case 'V': return 'V';
+        default: return 0;
+    }
+}
+
+
+char complementAmbiguityCode(char symbol) {
+    switch(symbol) {
+        case 'R': return 'Y';
+        case 'Y': return 'R';
+        case 'K': return 'M';
+        case 'M': return 'K';
+        case 'B': return 'V';
+        case 'V': return 'B';
+        case 'D': return 'H';
+        case 'H': return 'D';
+        default: return symbol;
+    }
+}
+
+
+size_t validateAmbiguousNucleotides(const char *nucleotides, size_t count) {
+    size_t done = 0;
+
+    while(done < count) {
+        done += validateNucleotides(nucleotides + done, count - done);
+        if(done == count || ambiguityCode(nucleotides[done]) == 0)
+            return done;
+        while(done < count && ambiguityCode(nucleotides[done]))
+            ++done;
+    }
+    return count;
+}
+
+
+size_t packAmbiguousNucleotides(const char *nucleotides, size_t count, unsigned char *sequence, size_t size,
+                                size_t index, std::vector<AmbiguousRun> &runs) {
+    size_t done = 0;
+
+    while(done < count) {
+        /* The Nucleotides up to the next other character are packed in bulk */
+        size_t valid = validateNucleotides(nucleotides + done, count - done);
+        storePackedNucleotides(sequence, size, index + done, nucleotides + done, valid);
+        done += valid;
+
+        /* Then the run of identical ambiguous characters, packed as 'A' */
+        if(done == count)
+            break;
+
+        char symbol = ambiguityCode(nucleotides[done]);
+        if(symbol == 0)
+            return done;
+
+        size_t run = 1;
+        while(done + run < count && ambiguityCode(nucleotides[done + run]) == symbol)
+            ++run;
+        clearPackedNucleotides(sequence, size, index + done, run);
+
+        appendAmbiguousRun(runs, {index + done, run, symbol});
+        done += run;
+    }
+    return count;
+}
+
+
+void clearPackedNucleotides(unsigned char *sequence, size_t size, size_t index, size_t count) {
+    if(index >= size)
+        return;
+    if(count > size - index)
+        count = size - index;
+
+    /* The partial bytes at both ends keep their other Nucleotides */
+    size_t head = (4 - index % 4) % 4;
+    if(head > count)
+        head = count;
+    storePackedWord(sequence, size, index, 0, head);
+    index += head;
+    count -= head;
+
+    std::memset(sequence + index / 4, 0, count / 4);
+    storePackedWord(sequence, size, index + count / 4 * 4, 0, count % 4);
+}
+
+
+void appendAmbiguousRun(std::vector<AmbiguousRun> &runs, const AmbiguousRun &run) {
+    if(run.size == 0)
+        return;
+
+    if(!runs.empty() && runs.back().symbol == run.symbol && runs.back().start + runs.back().size == run.start)
+        runs.back().size += run.size;
+    else
+        runs.push_back(run);
+}
+
+
+void copyAmbiguousRuns(const std::vector<AmbiguousRun> &runs, size_t start, size_t end, size_t to,
+                       std::vector<AmbiguousRun> &out) {
+    for(auto run = runAfter(runs, start); run != runs.end() && run->start < end; ++run) {
+        size_t run_start = run->start > start ? run->start : start;
+        size_t run_end = run->start + run->size < end ? run->start + run->size : end;
+
+        appendAmbiguousRun(out, {to + (run_start - start), run_end - run_start, run->symbol});
+    }
+}
+
+
+void spliceAmbiguousRuns(std::vector<AmbiguousRun> &runs, size_t index, size_t removed, size_t inserted,
+                         const std::vector<AmbiguousRun> &inserted_runs) {
+    if(runs.empty() && inserted_runs.empty())
+        return;
+
+    std::vector<AmbiguousRun> spliced;
+    spliced.reserve(runs.size() + inserted_runs.size() + 1);
+
+    copyAmbiguousRuns(runs, 0, index, 0, spliced);
+    copyAmbiguousRuns(inserted_runs, 0, inserted, index, spliced);
+    copyAmbiguousRuns(runs, index + removed, -1, index + inserted, spliced);
+    runs.swap(spliced);
+}
+
+
+void reverseAmbiguousRuns(std::vector<AmbiguousRun> &runs, size_t start, size_t end, bool complement) {
+    if(runs.empty())
+        return;
+
+    std::vector<AmbiguousRun> inside;
+    copyAmbiguousRuns(runs, start, end, start, inside);
+
+    std::vector<AmbiguousRun> reversed;
+    reversed.reserve(runs.size() + 2);
+    copyAmbiguousRuns(runs, 0, start, 0, reversed);
+    for(auto run = inside.rbegin(); run != inside.rend(); ++run) {
+        char symbol = complement ? complementAmbiguityCode(run->symbol) : run->symbol;
+        appendAmbiguousRun(reversed, {start + end - run->start - run->size, run->size, symbol});
+    }
+    copyAmbiguousRuns(runs, end, -1, end, reversed);
+    runs.swap(reversed);
+}
+
+
+void complementAmbiguousRuns(std::vector<AmbiguousRun> &runs) {
+    for(AmbiguousRun &run : runs)
+        run.symbol = complementAmbiguityCode(run.symbol);
+}
+
+
+char ambiguousSymbol(const std::vector<AmbiguousRun> &runs, size_t index) {
+    auto run = runAfter(runs, index);
+    return run != runs.end() && run->start <= index ? run->symbol : 0;
+}
+
+
+bool overlapsAmbiguousRun(const std::vector<AmbiguousRun> &runs, size_t start, size_t end) {
+    if(start >= end)
+        return false;
+
+    auto run = runAfter(runs, start);
+    return run != runs.end() && run->start < end;
+}
+
+
+size_t countAmbiguousNucleotides(const std::vector<AmbiguousRun> &runs, size_t start, size_t end) {
+    size_t count = 0;
+
+    for(auto run = runAfter(runs, start); run != runs.end() && run->start < end; ++run) {
+        size_t run_start = run->start > start ? run->start : start;
+        size_t run_end = run->start + run->size < end ? run->start + run->size : end;
+        count += run_end - run_start;
+    }
+    return count;
+}
+
+
+void unpackAmbiguousRuns(const std::vector<AmbiguousRun> &runs, size_t start, size_t count, char *out) {
+    for(auto run = runAfter(runs, start); run != runs.end() && run->start < start + count; ++run) {
+        size_t run_start = run->start > start ? run->start : start;
+        size_t run_end = run->start + run->size < start + count ? run->start + run->size : start + count;
+        std::memset(out + (run_start - start), run->symbol, run_end - run_start);
+    }
+}
+
+
+/* ---------- AmbiguousRun Methods ---------- */
+
+bool AmbiguousRun::operator==(const AmbiguousRun &run) const {
+    return this->start == run.start && this->size == run.size && this->symbol == run.symbol;
+}
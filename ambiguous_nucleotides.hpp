@@ -0,0 +1,103 @@
+#ifndef AMBIGUOUS_NUCLEOTIDES
+#define AMBIGUOUS_NUCLEOTIDES
+
+#include <cstddef>
+#include <vector>
+
+/*
+    * Ambiguous Nucleotides are kept out of the 2-bit packed sequence, in a sorted side table of runs.
+    * The symbols are 'N' (any Nucleotide) and the IUPAC codes:
+        R (A/G)  Y (C/T)  S (G/C)  W (A/T)  K (G/T)  M (A/C)  B (not A)  D (not C)  H (not G)  V (not T)
+    * The packed sequence holds an 'A' ('00') at every ambiguous index, a long run of 'N's
+     costs a single entry of the table.
+*/
+
+/*
+    * 'size' ambiguous Nucleotides with the same symbol starting at index 'start'.
+    * The runs of a table are sorted by 'start', never overlap and two touching runs have different symbols.
+*/
+struct AmbiguousRun {
+    size_t start;
+    size_t size;
+    char symbol;
+
+    bool operator==(const AmbiguousRun &run) const;
+};
+
+/*
+    * Returns the upper case symbol of an ambiguous Nucleotide character ('n' or 'N', 'r' or 'R', ...),
+     or 0 if the character is not one.
+*/
+char ambiguityCode(char character);
+
+/*
+    * Returns the symbol of the complementary strand: R <-> Y, K <-> M, B <-> V, D <-> H, 'N', 'S' and 'W' are unchanged.
+*/
+char complementAmbiguityCode(char symbol);
+
+/*
+    * Returns the index of the first character that is neither a Nucleotide nor an ambiguous Nucleotide,
+     or 'count' if every character is valid.
+*/
+size_t validateAmbiguousNucleotides(const char *nucleotides, size_t count);
+
+/*
+    * Validates and packs 'count' characters at index 'index' of a packed sequence holding 'size' Nucleotides.
+    * The Nucleotides are packed by the vectorized kernels, the ambiguous characters are packed as 'A'
+     and appended to 'runs', the indexes of the runs are indexes of the packed sequence.
+    * Returns the index of the first character that is neither a Nucleotide nor an ambiguous Nucleotide,
+     or 'count' if every character is valid.
+*/
+size_t packAmbiguousNucleotides(const char *nucleotides, size_t count, unsigned char *sequence, size_t size,
+                                size_t index, std::vector<AmbiguousRun> &runs);
+
+/*
+    * Packs 'count' Nucleotides at index 'index' of a packed sequence holding 'size' Nucleotides as 'A',
+     the placeholder of the ambiguous Nucleotides. The whole bytes in between are cleared with memset.
+*/
+void clearPackedNucleotides(unsigned char *sequence, size_t size, size_t index, size_t count);
+
+/*
+    * Appends a run after the last one, merging it with the last run when they touch and have the same symbol.
+*/
+void appendAmbiguousRun(std::vector<AmbiguousRun> &runs, const AmbiguousRun &run);
+
+/*
+    * Appends the runs overlapping [start, end), clipped to it and moved so 'start' becomes 'to', to 'out'.
+*/
+void copyAmbiguousRuns(const std::vector<AmbiguousRun> &runs, size_t start, size_t end, size_t to,
+                       std::vector<AmbiguousRun> &out);
+
+/*
+    * Updates the runs after the Nucleotides [index, index + removed) are replaced by 'inserted' Nucleotides:
+     the runs inside the removed range are dropped and the runs after it are moved.
+    * 'inserted_runs' are the runs of the inserted Nucleotides, with indexes relative to 'index'.
+*/
+void spliceAmbiguousRuns(std::vector<AmbiguousRun> &runs, size_t index, size_t removed, size_t inserted,
+                         const std::vector<AmbiguousRun> &inserted_runs = std::vector<AmbiguousRun>());
+
+/*
+    * Updates the runs after the Nucleotides [start, end) are reversed, complementing the symbols
+     of the range if 'complement' is set.
+*/
+void reverseAmbiguousRuns(std::vector<AmbiguousRun> &runs, size_t start, size_t end, bool complement);
+
+/* Complements the symbols of every run (see complementAmbiguityCode). */
+void complementAmbiguousRuns(std::vector<AmbiguousRun> &runs);
+
+/* Returns the symbol at 'index', or 0 if the Nucleotide at 'index' is not ambiguous. */
+char ambiguousSymbol(const std::vector<AmbiguousRun> &runs, size_t index);
+
+/* Returns true if one of the Nucleotides [start, end) is ambiguous. */
+bool overlapsAmbiguousRun(const std::vector<AmbiguousRun> &runs, size_t start, size_t end);
+
+/* Returns the number of ambiguous Nucleotides in [start, end). */
+size_t countAmbiguousNucleotides(const std::vector<AmbiguousRun> &runs, size_t start, size_t end);
+
+/*
+    * Writes the symbols of the ambiguous Nucleotides of [start, start + count) over the unpacked
+     Nucleotides 'out', where out[0] is the Nucleotide at 'start'.
+*/
+void unpackAmbiguousRuns(const std::vector<AmbiguousRun> &runs, size_t start, size_t count, char *out);
+
+#endif
@@ -0,0 +1,196 @@
+#include "approximate_search.hpp"
+#include "packed_search.hpp"
+
+/* ----- Approximate Search Utility Functions ----- */
+
+/*
+    * Returns the number of Nucleotides that differ between two words, only the Nucleotides in 'mask' are compared.
+*/
+static inline size_t countMismatches(uint64_t word, uint64_t pattern, uint64_t mask) {
+    uint64_t diff = (word ^ pattern) & mask;
+    return __builtin_popcountll((diff | (diff >> 1)) & 0x5555555555555555ull);
+}
+
+
+/*
+    * Returns the 2-bit code of the Nucleotide at 'index' of a packed sequence.
+*/
+static inline unsigned packedCode(const unsigned char *sequence, size_t index) {
+    return (sequence[index / 4] >> (6 - (index % 4) * 2)) & 0b11;
+}
+
+
+/*
+    * The columns of Myers' bit-vector edit distance matrix, for a pattern split in blocks of 64 Nucleotides.
+    * Bit r of block b stands for pattern row b * 64 + r, m_positive/m_negative hold the vertical
+     +1/-1 score deltas between consecutive rows of the current column.
+*/
+class MyersColumns {
+public:
+    MyersColumns(const std::vector<unsigned char> &codes) {
+        this->m_blocks = codes.size() ? (codes.size() + 63) / 64 : 1;
+        this->m_last_bit = codes.size() ? (codes.size() - 1) % 64 : 0;
+        this->m_peq.assign(this->m_blocks * 4, 0);
+        this->m_positive.assign(this->m_blocks, 0);
+        this->m_negative.assign(this->m_blocks, 0);
+
+        for(size_t row = 0; row < codes.size(); ++row)
+            this->m_peq[(row / 64) * 4 + codes[row]] |= uint64_t(1) << (row % 64);
+        this->reset();
+    }
+
+    /* Back to the first column, where the score grows by one per pattern row */
+    void reset() {
+        for(size_t block = 0; block < this->m_blocks; ++block) {
+            this->m_positive[block] = ~uint64_t(0);
+            this->m_negative[block] = 0;
+        }
+    }
+
+    /*
+        * Moves to the next column for the text Nucleotide 'code' and returns the change of the score of the last row.
+        * 'top' is the horizontal delta of the first row: 0 lets an alignment start anywhere in the text,
+         +1 anchors it at the first Nucleotide.
+    */
+    int advance(unsigned code, int top) {
+        int horizontal = top;
+        int last_delta = 0;
+
+        for(size_t block = 0; block < this->m_blocks; ++block) {
+            uint64_t positive = this->m_positive[block];
+            uint64_t negative = this->m_negative[block];
+            uint64_t equal = this->m_peq[block * 4 + code];
+            uint64_t carry_negative = horizontal < 0;
+            uint64_t carry_positive = horizontal > 0;
+
+            uint64_t vertical = equal | negative;
+            equal |= carry_negative;
+            uint64_t diagonal = (((equal & positive) + positive) ^ positive) | equal;
+            uint64_t h_positive = negative | ~(diagonal | positive);
+            uint64_t h_negative = positive & diagonal;
+
+            if(block == this->m_blocks - 1)
+                last_delta = int((h_positive >> this->m_last_bit) & 1) - int((h_negative >> this->m_last_bit) & 1);
+            horizontal = int(h_positive >> 63) - int(h_negative >> 63);
+
+            h_positive = (h_positive << 1) | carry_positive;
+            h_negative = (h_negative << 1) | carry_negative;
+            this->m_positive[block] = h_negative | ~(vertical | h_positive);
+            this->m_negative[block] = h_positive & vertical;
+        }
+        return last_delta;
+    }
+
+private:
+    size_t m_blocks;
+    unsigned m_last_bit;
+
+    /* m_peq[block * 4 + code]: the rows of the block holding the Nucleotide 'code' */
+    std::vector<uint64_t> m_peq;
+    std::vector<uint64_t> m_positive;
+    std::vector<uint64_t> m_negative;
+};
+
+
+std::vector<ApproximateMatch> findHammingMatches(const unsigned char *sequence, size_t size, const PackedPattern &pattern,
+                                                 size_t max_mismatches, size_t n) {
+    std::vector<ApproximateMatch> matches;
+
+    if(n == 0 || pattern.size > size)
+        return matches;
+
+    const size_t candidates = size - pattern.size + 1;
+    const size_t last_word = pattern.words.size() - 1;
+    const uint64_t first = pattern.words[0];
+    const uint64_t first_mask = last_word == 0 ? pattern.last_mask : ~uint64_t(0);
+
+    /* As in scanPackedSequence, the first pattern word is compared against shifts of the loaded word pair */
+    for(size_t index = 0; index < candidates; index += 32) {
+        uint64_t current = loadPackedWord(sequence, size, index);
+        uint64_t next = loadPackedWord(sequence, size, index + 32);
+        size_t count = candidates - index < 32 ? candidates - index : 32;
+
+        for(size_t shift = 0; shift < count; ++shift) {
+            uint64_t window = shift ? (current << (shift * 2)) | (next >> (64 - shift * 2)) : current;
+            size_t mismatches = countMismatches(window, first, first_mask);
+
+            for(size_t i = 1; i <= last_word && mismatches <= max_mismatches; ++i) {
+                uint64_t mask = i == last_word ? pattern.last_mask : ~uint64_t(0);
+                mismatches += countMismatches(loadPackedWord(sequence, size, index + shift + i * 32), pattern.words[i], mask);
+            }
+            if(mismatches > max_mismatches)
+                continue;
+
+            matches.push_back({index + shift, pattern.size, mismatches});
+            if(matches.size() == n)
+                return matches;
+        }
+    }
+    return matches;
+}
+
+
+std::vector<ApproximateMatch> findLevenshteinMatches(const unsigned char *sequence, size_t size, const PackedPattern &pattern,
+                                                     size_t max_edits, size_t n) {
+    std::vector<ApproximateMatch> matches;
+    const size_t m = pattern.size;
+
+    if(n == 0)
+        return matches;
+
+    /* The empty pattern occurs without edits at every index */
+    if(m == 0) {
+        for(size_t index = 0; index <= size && matches.size() < n; ++index)
+            matches.push_back({index, 0, 0});
+        return matches;
+    }
+
+    /* The pattern, and the reversed pattern used to find where an occurrence starts */
+    std::vector<unsigned char> codes(m);
+    for(size_t row = 0; row < m; ++row)
+        codes[row] = (pattern.words[row / 32] >> (62 - (row % 32) * 2)) & 0b11;
+    MyersColumns forward(codes);
+    std::vector<unsigned char> reversed(codes.rbegin(), codes.rend());
+    MyersColumns backward(reversed);
+
+    /*
+        * Returns the size of the shortest substring ending at 'end' that is 'edits' edits away from the pattern.
+        * The reversed pattern is aligned from 'end' backwards, anchored at 'end'.
+    */
+    auto occurrenceSize = [&](size_t end, size_t edits) {
+        size_t score = m;
+        size_t longest = m + edits < end ? m + edits : end;
+
+        if(score <= edits)
+            return size_t(0);
+
+        backward.reset();
+        for(size_t length = 1; length <= longest; ++length) {
+            score += backward.advance(packedCode(sequence, end - length), 1);
+            if(score <= edits)
+                return length;
+        }
+        return longest;
+    };
+
+    /* The score of a column is the distance of the best alignment ending at that column */
+    size_t score = m;
+    uint64_t buffer = 0;
+
+    for(size_t end = 0; end <= size; ++end) {
+        if(end) {
+            if((end - 1) % 32 == 0)
+                buffer = loadPackedWord(sequence, size, end - 1);
+            score += forward.advance(unsigned(buffer >> 62), 0);
+            buffer <<= 2;
+        }
+        if(score > max_edits)
+            continue;
+
+        size_t length = occurrenceSize(end, score);
+        matches.push_back({end - length, length, score});
+        if(matches.size() == n)
+            break;
+    }
+    return matches;
+}
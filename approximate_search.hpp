@@ -0,0 +1,50 @@
+#ifndef APPROXIMATE_SEARCH
+#define APPROXIMATE_SEARCH
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+struct PackedPattern;
+
+/*
+    * Bit-parallel approximate search over 2-bit packed Nucleotides (see packed_search.hpp).
+    * Hamming distance (substitutions only): the pattern is xor'ed with the sequence 32 Nucleotides
+     at a time and the differing Nucleotides are counted with a popcount, so each candidate costs
+     the same word operations as an exact comparison, whatever the number of allowed mismatches.
+    * Levenshtein distance (substitutions, insertions and deletions): Myers' bit-vector algorithm
+     in blocks of 64 pattern Nucleotides, one text Nucleotide is processed per block in a few
+     word operations.
+*/
+
+enum class EditDistance {
+    Hamming,
+    Levenshtein
+};
+
+/*
+    * An approximate occurrence of a pattern, covering the Nucleotides [index, index + size)
+     of the searched sequence with 'errors' mismatches or edits.
+*/
+struct ApproximateMatch {
+    size_t index;
+    size_t size;
+    size_t errors;
+};
+
+/*
+    * Returns the first 'n' occurrences of the pattern with at most 'max_mismatches' mismatches,
+     sorted by starting index. Every occurrence has the size of the pattern.
+*/
+std::vector<ApproximateMatch> findHammingMatches(const unsigned char *sequence, size_t size, const PackedPattern &pattern,
+                                                 size_t max_mismatches, size_t n = -1);
+
+/*
+    * Returns the first 'n' occurrences of the pattern with at most 'max_edits' edits, sorted by end index.
+    * One occurrence is reported per end index, it is the shortest substring ending there with the
+     fewest edits, so the occurrences of a single alignment overlap when 'max_edits' is not 0.
+*/
+std::vector<ApproximateMatch> findLevenshteinMatches(const unsigned char *sequence, size_t size, const PackedPattern &pattern,
+                                                     size_t max_edits, size_t n = -1);
+
+#endif
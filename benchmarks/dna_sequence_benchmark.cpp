@@ -0,0 +1,542 @@
+#include "dna_sequence.hpp"
+#include "dna_sequence_n.hpp"
+#include "dna_sequence_view.hpp"
+#include "fasta_writer.hpp"
+#include "sketch.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <unordered_set>
+#include <vector>
+
+#ifndef DNA_SEQUENCE_BENCHMARK_MAX_LENGTH
+#define DNA_SEQUENCE_BENCHMARK_MAX_LENGTH (size_t(1) << 30)
+#endif
+
+static const size_t MIN_LENGTH = size_t(1) << 10;
+static const size_t MAX_LENGTH = DNA_SEQUENCE_BENCHMARK_MAX_LENGTH;
+static const int LENGTH_MULTIPLIER = 32;
+
+/* ----- Benchmark Utility Functions ----- */
+
+/*
+    * Returns 'size' random Nucleotides, the same ones for the same size and seed (xorshift64*).
+*/
+static std::string randomNucleotides(size_t size, uint64_t seed) {
+    std::string nucleotides(size, 'A');
+    uint64_t state = seed * 0x9E3779B97F4A7C15ull + 1;
+
+    for(size_t i = 0; i < size; i += 32) {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        uint64_t bits = state * 0x2545F4914F6CDD1Dull;
+
+        for(size_t j = i; j < size && j < i + 32; ++j, bits >>= 2)
+            nucleotides[j] = "ATGC"[bits & 0b11];
+    }
+    return nucleotides;
+}
+
+
+/*
+    * The text and the sequence the benchmarks run on: 'size' random Nucleotides with the pattern planted
+     'density' times per million Nucleotides, evenly spaced.
+    * Only the last ones are kept, the benchmarks of a size and pattern share them.
+*/
+struct BenchmarkData {
+    std::tuple<size_t, std::string, size_t> key;
+    std::string text;
+    DNASequence sequence;
+};
+
+
+static const BenchmarkData& benchmarkData(size_t size, const std::string &pattern, size_t density) {
+    static BenchmarkData data;
+    auto key = std::make_tuple(size, pattern, density);
+
+    if(data.key == key && data.text.size() == size)
+        return data;
+
+    data.text = randomNucleotides(size, size);
+    size_t hits = size / 1000000 * density + (size % 1000000) * density / 1000000;
+    if(hits && pattern.size() <= size) {
+        size_t spacing = (size - pattern.size()) / hits;
+        for(size_t hit = 0; spacing >= pattern.size() && hit < hits; ++hit)
+            data.text.replace(hit * spacing, pattern.size(), pattern);
+    }
+
+    data.sequence = DNASequence(data.text);
+    data.key = key;
+    return data;
+}
+
+
+static const std::string& benchmarkText(size_t size) {
+    return benchmarkData(size, "", 0).text;
+}
+
+
+static const DNASequence& benchmarkSequence(size_t size, const std::string &pattern = "", size_t density = 0) {
+    return benchmarkData(size, pattern, density).sequence;
+}
+
+
+/*
+    * Reports the throughput in Nucleotides per second, 'bases/s' in the console and in the JSON output.
+*/
+static void setThroughput(benchmark::State &state, size_t bases) {
+    state.SetItemsProcessed(int64_t(state.iterations()) * bases);
+    state.counters["bases/s"] = benchmark::Counter(double(bases), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+
+/* A stream buffer discarding what is written to it, to time the exports without the I/O */
+class DiscardBuffer : public std::streambuf {
+protected:
+    std::streamsize xsputn(const char*, std::streamsize count) override {
+        return count;
+    }
+
+    int overflow(int character) override {
+        return traits_type::not_eof(character);
+    }
+};
+
+
+/* Sequence lengths from 1 kb to MAX_LENGTH, multiplied by 32 each step */
+static void lengthArguments(benchmark::internal::Benchmark *benchmark) {
+    size_t length = MIN_LENGTH;
+
+    benchmark->ArgName("length");
+    for(; length < MAX_LENGTH; length *= LENGTH_MULTIPLIER)
+        benchmark->Arg(length);
+    benchmark->Arg(MAX_LENGTH);
+}
+
+
+/* Sequence lengths, pattern lengths and hits per million Nucleotides */
+static void searchArguments(benchmark::internal::Benchmark *benchmark) {
+    benchmark->ArgNames({"length", "pattern", "hits_per_Mb"});
+    for(size_t length = MIN_LENGTH; ; length *= LENGTH_MULTIPLIER) {
+        length = length < MAX_LENGTH ? length : MAX_LENGTH;
+        for(int64_t pattern : {8, 32, 100}) {
+            for(int64_t density : {0, 10, 1000})
+                benchmark->Args({int64_t(length), pattern, density});
+        }
+        if(length == MAX_LENGTH)
+            break;
+    }
+}
+
+
+/* ---------- Construction and Export Benchmarks ---------- */
+
+static void BM_Construct(benchmark::State &state) {
+    const std::string &text = benchmarkText(state.range(0));
+
+    for(auto _ : state) {
+        DNASequence sequence(text);
+        benchmark::DoNotOptimize(sequence.getPackedSequence());
+    }
+    setThroughput(state, text.size());
+}
+BENCHMARK(BM_Construct)->Apply(lengthArguments);
+
+
+static void BM_TryParse(benchmark::State &state) {
+    const std::string &text = benchmarkText(state.range(0));
+
+    for(auto _ : state) {
+        ParseResult result = DNASequence::tryParse(text);
+        benchmark::DoNotOptimize(result.sequence.getPackedSequence());
+    }
+    setThroughput(state, text.size());
+}
+BENCHMARK(BM_TryParse)->Apply(lengthArguments);
+
+
+static void BM_GetSequenceStr(benchmark::State &state) {
+    DNASequence sequence = benchmarkSequence(state.range(0));
+
+    for(auto _ : state) {
+        std::string text = sequence.getSequenceStr();
+        benchmark::DoNotOptimize(text.data());
+    }
+    setThroughput(state, sequence.getSize());
+}
+BENCHMARK(BM_GetSequenceStr)->Apply(lengthArguments);
+
+
+static void BM_GetSequenceCStr(benchmark::State &state) {
+    DNASequence sequence = benchmarkSequence(state.range(0));
+
+    for(auto _ : state) {
+        char *text = sequence.getSequenceCStr();
+        benchmark::DoNotOptimize(text);
+        delete[] text;
+    }
+    setThroughput(state, sequence.getSize());
+}
+BENCHMARK(BM_GetSequenceCStr)->Apply(lengthArguments);
+
+
+static void BM_DecodeTo(benchmark::State &state) {
+    const DNASequence &sequence = benchmarkSequence(state.range(0));
+    std::unique_ptr<char[]> text(new char[sequence.getSize()]);
+
+    for(auto _ : state) {
+        sequence.decodeTo(text.get());
+        benchmark::DoNotOptimize(text.get());
+    }
+    setThroughput(state, sequence.getSize());
+}
+BENCHMARK(BM_DecodeTo)->Apply(lengthArguments);
+
+
+static void BM_StreamInsert(benchmark::State &state) {
+    const DNASequence &sequence = benchmarkSequence(state.range(0));
+    DiscardBuffer buffer;
+    std::ostream stream(&buffer);
+
+    for(auto _ : state)
+        stream << sequence;
+    setThroughput(state, sequence.getSize());
+}
+BENCHMARK(BM_StreamInsert)->Apply(lengthArguments);
+
+
+static void BM_FastaWriter(benchmark::State &state) {
+    const DNASequence &sequence = benchmarkSequence(state.range(0));
+    DiscardBuffer buffer;
+    std::ostream stream(&buffer);
+    FastaWriter writer(stream);
+
+    for(auto _ : state)
+        writer.write("chr1", sequence);
+    writer.flush();
+    setThroughput(state, sequence.getSize());
+}
+BENCHMARK(BM_FastaWriter)->Apply(lengthArguments);
+
+
+static void BM_Copy(benchmark::State &state) {
+    const DNASequence &sequence = benchmarkSequence(state.range(0));
+
+    for(auto _ : state) {
+        DNASequence copy(sequence);
+        benchmark::DoNotOptimize(copy.getPackedSequence());
+    }
+    setThroughput(state, sequence.getSize());
+}
+BENCHMARK(BM_Copy)->Apply(lengthArguments);
+
+
+/* ---------- Transformation Benchmarks ---------- */
+
+static void BM_ReverseSequence(benchmark::State &state) {
+    DNASequence sequence = benchmarkSequence(state.range(0));
+
+    for(auto _ : state) {
+        sequence.reverseSequence();
+        benchmark::ClobberMemory();
+    }
+    setThroughput(state, sequence.getSize());
+}
+BENCHMARK(BM_ReverseSequence)->Apply(lengthArguments);
+
+
+/* A range starting and ending in the middle of bytes, reversed word by word from both ends */
+static void BM_ReverseRange(benchmark::State &state) {
+    DNASequence sequence = benchmarkSequence(state.range(0));
+    size_t start = 3;
+    size_t end = sequence.getSize() - 5;
+
+    for(auto _ : state) {
+        sequence.reverseSequence(start, end);
+        benchmark::ClobberMemory();
+    }
+    setThroughput(state, end - start);
+}
+BENCHMARK(BM_ReverseRange)->Apply(lengthArguments);
+
+
+static void BM_Complement(benchmark::State &state) {
+    DNASequence sequence = benchmarkSequence(state.range(0));
+
+    for(auto _ : state) {
+        sequence.complement();
+        benchmark::ClobberMemory();
+    }
+    setThroughput(state, sequence.getSize());
+}
+BENCHMARK(BM_Complement)->Apply(lengthArguments);
+
+
+static void BM_ReverseComplement(benchmark::State &state) {
+    DNASequence sequence = benchmarkSequence(state.range(0));
+
+    for(auto _ : state) {
+        sequence.reverseComplement();
+        benchmark::ClobberMemory();
+    }
+    setThroughput(state, sequence.getSize());
+}
+BENCHMARK(BM_ReverseComplement)->Apply(lengthArguments);
+
+
+/* The middle half of the sequence, starting in the middle of a byte */
+static void BM_Slice(benchmark::State &state) {
+    DNASequence sequence = benchmarkSequence(state.range(0));
+    size_t start = sequence.getSize() / 4 + 1;
+    size_t end = start + sequence.getSize() / 2;
+
+    for(auto _ : state) {
+        DNASequence slice = sequence.slice(start, end);
+        benchmark::DoNotOptimize(slice.getPackedSequence());
+    }
+    setThroughput(state, end - start);
+}
+BENCHMARK(BM_Slice)->Apply(lengthArguments);
+
+
+/* ---------- Search Benchmarks ---------- */
+
+static void BM_FindSubsequence(benchmark::State &state) {
+    std::string pattern = randomNucleotides(state.range(1), 7);
+    DNASequence sequence = benchmarkSequence(state.range(0), pattern, state.range(2));
+    size_t hits = 0;
+
+    for(auto _ : state) {
+        std::vector<size_t> occurrences = sequence.findSubsequence(pattern);
+        hits = occurrences.size();
+        benchmark::DoNotOptimize(occurrences.data());
+    }
+    setThroughput(state, sequence.getSize());
+    state.counters["hits"] = double(hits);
+}
+BENCHMARK(BM_FindSubsequence)->Apply(searchArguments);
+
+
+static void BM_CountSubsequence(benchmark::State &state) {
+    std::string pattern = randomNucleotides(state.range(1), 7);
+    DNASequence sequence = benchmarkSequence(state.range(0), pattern, state.range(2));
+    size_t hits = 0;
+
+    for(auto _ : state) {
+        hits = sequence.countSubsequence(pattern);
+        benchmark::DoNotOptimize(hits);
+    }
+    setThroughput(state, sequence.getSize());
+    state.counters["hits"] = double(hits);
+}
+BENCHMARK(BM_CountSubsequence)->Apply(searchArguments);
+
+
+static void BM_FindSubsequenceParallel(benchmark::State &state) {
+    std::string pattern = randomNucleotides(state.range(1), 7);
+    DNASequence sequence = benchmarkSequence(state.range(0), pattern, state.range(2));
+    size_t hits = 0;
+
+    for(auto _ : state) {
+        std::vector<size_t> occurrences = sequence.findSubsequenceParallel(pattern);
+        hits = occurrences.size();
+        benchmark::DoNotOptimize(occurrences.data());
+    }
+    setThroughput(state, sequence.getSize());
+    state.counters["hits"] = double(hits);
+}
+BENCHMARK(BM_FindSubsequenceParallel)->Apply(searchArguments)->UseRealTime();
+
+
+static void BM_ViewFindSubsequence(benchmark::State &state) {
+    std::string pattern = randomNucleotides(state.range(1), 7);
+    const DNASequence &sequence = benchmarkSequence(state.range(0), pattern, state.range(2));
+    DNASequenceView view = sequence.view(1, sequence.getSize() - 1);
+    size_t hits = 0;
+
+    for(auto _ : state) {
+        std::vector<size_t> occurrences = view.findSubsequence(pattern);
+        hits = occurrences.size();
+        benchmark::DoNotOptimize(occurrences.data());
+    }
+    setThroughput(state, view.getSize());
+    state.counters["hits"] = double(hits);
+}
+BENCHMARK(BM_ViewFindSubsequence)->Apply(searchArguments);
+
+
+/* ---------- Composition and Comparison Benchmarks ---------- */
+
+static void BM_GetComposition(benchmark::State &state) {
+    const DNASequence &sequence = benchmarkSequence(state.range(0));
+
+    for(auto _ : state) {
+        NucleotideComposition composition = sequence.getComposition();
+        benchmark::DoNotOptimize(composition);
+    }
+    setThroughput(state, sequence.getSize());
+}
+BENCHMARK(BM_GetComposition)->Apply(lengthArguments);
+
+
+static void BM_Equal(benchmark::State &state) {
+    const DNASequence &sequence = benchmarkSequence(state.range(0));
+    DNASequence copy(sequence);
+
+    for(auto _ : state) {
+        bool equal = sequence == copy;
+        benchmark::DoNotOptimize(equal);
+    }
+    setThroughput(state, sequence.getSize());
+}
+BENCHMARK(BM_Equal)->Apply(lengthArguments);
+
+
+static void BM_Hash(benchmark::State &state) {
+    const DNASequence &sequence = benchmarkSequence(state.range(0));
+
+    for(auto _ : state) {
+        size_t hash = sequence.hash();
+        benchmark::DoNotOptimize(hash);
+    }
+    setThroughput(state, sequence.getSize());
+}
+BENCHMARK(BM_Hash)->Apply(lengthArguments);
+
+
+/* Every 32-mer of the sequence as a fixed length sequence, its reverse complement hashed */
+static void BM_SequenceNReverseComplement(benchmark::State &state) {
+    const DNASequence &sequence = benchmarkSequence(state.range(0));
+    size_t kmers = sequence.getSize() - 32 + 1;
+
+    for(auto _ : state) {
+        size_t hash = 0;
+        DNASequenceN<32> kmer;
+        for(size_t index = 0; index < kmers; ++index) {
+            if(DNASequenceN<32>::tryLoad(sequence, index, kmer))
+                hash ^= kmer.reverseComplement().hash();
+        }
+        benchmark::DoNotOptimize(hash);
+    }
+    setThroughput(state, kmers);
+}
+BENCHMARK(BM_SequenceNReverseComplement)->Apply(lengthArguments);
+
+
+/* Looks up 16 Nucleotide barcodes in a set of 4096, keyed by DNASequenceN or by DNASequence */
+static void BM_BarcodeLookup(benchmark::State &state) {
+    const std::string &text = benchmarkText(size_t(1) << 16);
+    bool fixed_length = state.range(0);
+    std::unordered_set<DNASequenceN<16>> fixed_barcodes;
+    std::unordered_set<DNASequence> barcodes;
+
+    for(size_t index = 0; index < text.size(); index += 16) {
+        fixed_barcodes.insert(DNASequenceN<16>(text.data() + index, 16));
+        barcodes.insert(DNASequence(text.substr(index, 16)));
+    }
+
+    std::vector<DNASequenceN<16>> fixed_queries;
+    std::vector<DNASequence> queries;
+    for(size_t index = 0; index + 16 <= text.size(); index += 5) {
+        fixed_queries.push_back(DNASequenceN<16>(text.data() + index, 16));
+        queries.push_back(DNASequence(text.substr(index, 16)));
+    }
+
+    for(auto _ : state) {
+        size_t found = 0;
+        if(fixed_length) {
+            for(const DNASequenceN<16> &query : fixed_queries)
+                found += fixed_barcodes.count(query);
+        }
+        else {
+            for(const DNASequence &query : queries)
+                found += barcodes.count(query);
+        }
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * queries.size());
+}
+BENCHMARK(BM_BarcodeLookup)->ArgName("fixed_length")->Arg(0)->Arg(1);
+
+
+/* ---------- Sketch Benchmarks ---------- */
+
+static void BM_Minimizers(benchmark::State &state) {
+    const DNASequence &sequence = benchmarkSequence(state.range(0));
+
+    for(auto _ : state) {
+        std::vector<SketchKmer> minimizers = findMinimizers(sequence, 10, 21);
+        benchmark::DoNotOptimize(minimizers.data());
+    }
+    setThroughput(state, sequence.getSize());
+}
+BENCHMARK(BM_Minimizers)->Apply(lengthArguments);
+
+
+static void BM_OpenSyncmers(benchmark::State &state) {
+    const DNASequence &sequence = benchmarkSequence(state.range(0));
+
+    for(auto _ : state) {
+        std::vector<SketchKmer> syncmers = findOpenSyncmers(sequence, 21, 11, 5);
+        benchmark::DoNotOptimize(syncmers.data());
+    }
+    setThroughput(state, sequence.getSize());
+}
+BENCHMARK(BM_OpenSyncmers)->Apply(lengthArguments);
+
+
+static void BM_MinHashSketch(benchmark::State &state) {
+    const DNASequence &sequence = benchmarkSequence(state.range(0));
+
+    for(auto _ : state) {
+        MinHashSketch sketch(21, 1000);
+        sketch.add(sequence);
+        benchmark::DoNotOptimize(sketch.getHashes().data());
+    }
+    setThroughput(state, sequence.getSize());
+}
+BENCHMARK(BM_MinHashSketch)->Apply(lengthArguments);
+
+
+/* ---------- Edit Benchmarks ---------- */
+
+/* Inserting in the middle shifts the second half of the sequence, erasing it back keeps the size */
+static void BM_InsertErase(benchmark::State &state) {
+    DNASequence sequence = benchmarkSequence(state.range(0));
+    std::string inserted = randomNucleotides(33, 3);
+    size_t middle = sequence.getSize() / 2 + 1;
+
+    sequence.reserve(sequence.getSize() + inserted.size());
+    for(auto _ : state) {
+        sequence.insert(middle, inserted);
+        sequence.erase(middle, middle + inserted.size());
+        benchmark::ClobberMemory();
+    }
+    setThroughput(state, sequence.getSize());
+}
+BENCHMARK(BM_InsertErase)->Apply(lengthArguments);
+
+
+/* Appending reads of 150 Nucleotides, up to the sequence length */
+static void BM_Append(benchmark::State &state) {
+    size_t length = state.range(0);
+    std::string read = randomNucleotides(150, 5);
+
+    for(auto _ : state) {
+        DNASequence sequence;
+        for(size_t size = 0; size < length; size += read.size())
+            sequence.append(read);
+        benchmark::DoNotOptimize(sequence.getPackedSequence());
+    }
+    setThroughput(state, (length + read.size() - 1) / read.size() * read.size());
+}
+BENCHMARK(BM_Append)->Apply(lengthArguments);
+
+
+BENCHMARK_MAIN();
@@ -1,6 +1,19 @@
 #include "dna_sequence.hpp"
+#include "instrumentation.hpp"
+#include "dna_sequence_view.hpp"
+#include "nucleotide_kernels.hpp"
+#include "packed_search.hpp"
+#include "thread_pool.hpp"
 
+#include <atomic>
 #include <iostream>
+#include <mutex>
+
+/* Candidate starting indexes per chunk of the parallel search, 256KB of packed sequence */
+static const size_t PARALLEL_SEARCH_CHUNK = 1 << 20;
+
+/* Granularity at which a chunk of the parallel search checks for cancellation */
+static const size_t PARALLEL_SEARCH_STEP = 1 << 16;
 
 /* ----- DNASequence Utility Functions ----- */
 
@@ -9,60 +22,10 @@
     * A sequence is valid if it contains only the characters ['a', 'A', 't', 'T', 'g', 'G', 'c', 'C'].
 */
 bool verifySequence(const char *sequence, size_t length) {
-    while(length--) {
-        switch(*sequence) {
-            case 'a':
-            case 'A':
-            case 't':
-            case 'T':
-            case 'g':
-            case 'G':
-            case 'c':
-            case 'C':
-                break;
-            default:
-                return false;
-        }
-        ++sequence;
-    }
-    return true;
+    return validateNucleotides(sequence, length) == length;
 }
 
 
-/*
-    * compresses 4 nucleotides into 1 character from left to right
-    * 'A' or 'a' become '00' in binary
-    * 'T' or 't' become '01' in binary
-    * 'G' or 'g' become '10' in binary
-    * 'C' or 'c' become '11' in binary
-*/
-char compressNucleotides(const char *patch, size_t len = 4) {
-    char compressed = 0;
-
-    for(size_t i = 0; i < len; ++i) {
-        switch(*patch) {
-            // case 'A':
-            // case 'a':
-                // hash += 6 - i << 0;
-                // break;
-            case 'T':
-            case 't':
-                compressed += 1 << (6 - i*2);
-                break;
-            case 'G':
-            case 'g':
-                compressed += 2 << (6 - i*2);
-                break;
-            case 'C':
-            case 'c':
-                compressed += 3 << (6 - i*2);
-                break;            
-        }
-        ++patch;
-    }
-    return compressed;
-}
-
 /*
     * Compress a single Nucleotide
 */
@@ -91,82 +54,72 @@ char compressNucleotide(const char nucleotide) {
 
 
 /*
-    * Decompresses a patch of up to 4 Nucleotides from 1 char to a string
-    * '00' becomes 'A'
-    * '01' becomes 'T'
-    * '10' becomes 'G'
-    * '11' becomes 'C'
-    * Example: 0b00011011 becomes "ATGC"
+    * Clears the unused bits of the last byte of a packed sequence.
 */
-std::string decompressNucleotides(const char compressed, size_t len = 4) {
-    std::string decompressed(len, ' ');
-    unsigned char offset = 6;
-    char value;
-
-    for(size_t i = 0; i < len; ++i) {
-        value = (compressed >> offset) & 0b11;
-        offset -= 2;
-
-        switch(value) {
-            case 0b00:
-                decompressed[i] = 'A';
-                break;
-            case 0b01:
-                decompressed[i] = 'T';
-                break;
-            case 0b10:
-                decompressed[i] = 'G';
-                break;
-            case 0b11:
-                decompressed[i] = 'C';
-                break;
-        }
-    }
-    return decompressed;
+static inline void clearPadding(unsigned char *sequence, size_t size) {
+    if(size % 4)
+        sequence[size / 4] &= 0xFF << (8 - (size % 4) * 2);
 }
 
 
 /*
-
+    * Validates and packs the Nucleotides into the allocated packed sequence in a single pass.
+    * The ambiguous Nucleotides are packed as 'A' and their runs are stored in 'ambiguous',
+     the slower pass building the runs only runs when the string is not plain 'A', 'T', 'G', 'C'.
+    * Returns the index of the first invalid Nucleotide value, or 'size' if the string is valid.
 */
-void fillSequence(std::unique_ptr<char> &sequence, const char *sequence_string, size_t size) {
-    char *seq_ptr;
-    
-    /* Initialize DNA Sequence size and allocate memory for the sequence */
-    sequence = std::unique_ptr<char>(new char[(size + 3) / 4]);
-    seq_ptr = sequence.get();
+size_t fillSequence(char *sequence, const char *sequence_string, size_t size, std::vector<AmbiguousRun> &ambiguous) {
+    DNA_INSTRUMENT(FillSequence, size);
+    unsigned char *packed = reinterpret_cast<unsigned char*>(sequence);
 
     /* Copy and Compress DNA Sequence */
-    for(; size > 3; size -= 4) {
-        *seq_ptr = compressNucleotides(sequence_string);
-        ++seq_ptr;
-        sequence_string += 4;
-    }
+    if(packNucleotides(sequence_string, size, packed) == size)
+        return size;
+
+    ambiguous.clear();
+    size_t valid = packAmbiguousNucleotides(sequence_string, size, packed, size, 0, ambiguous);
+    if(valid == size)
+        clearPadding(packed, size);
+    return valid;
+}
+
+
+/*
+    * Unpacks the whole sequence into 'out', with its ambiguous Nucleotides.
+*/
+static void unpackSequence(const DNASequence &sequence, char *out) {
+    unpackNucleotides(sequence.getPackedSequence(), 0, sequence.getSize(), out);
+    unpackAmbiguousRuns(sequence.getAmbiguousRuns(), 0, sequence.getSize(), out);
+}
 
-    /* Check if we need nucleotides with padding at the end add them */
-    if(size > 0)
-        *seq_ptr = compressNucleotides(sequence_string, size);
+
+/*
+    * Packs a DNASequence used as a pattern.
+    * Returns false if it has ambiguous Nucleotides, such a pattern matches nowhere.
+*/
+static bool packSequencePattern(const DNASequence &subsequence, PackedPattern &pattern) {
+    packPattern(subsequence.getPackedSequence(), 0, subsequence.getSize(), pattern);
+    return !subsequence.hasAmbiguousNucleotides();
 }
 
 /* ---------- DNASequence Methods ---------- */
 
 DNASequence::DNASequence() {
-    this->m_sequence = nullptr;
     this->m_size = 0;
 }
 
 
 DNASequence::DNASequence(const std::string &sequence) {
-    /* Check if the DNA Sequence is valid */
-    if(verifySequence(&sequence[0], sequence.size()) == false) {
+    DNA_INSTRUMENT(Construct, sequence.size());
+
+    /* Fill in the sequence with Nuclutides and set its size, fails if the DNA Sequence is not valid */
+    if(fillSequence(this->allocateSequence(sequence.size()), &sequence[0], sequence.size(), this->m_ambiguous) != sequence.size()) {
         printf("DNASequence Error: the provided sequence string has an invalid Nucleotide value!\n");
-        this->m_size = 0;
         this->m_sequence = nullptr;
+        this->m_ambiguous.clear();
+        this->m_size = 0;
         return;
     }
-
-    /* Fill in the sequence with Nuclutides and set its size */
-    fillSequence(this->m_sequence, &sequence[0], sequence.size());
     this->m_size = sequence.size();
 }
 
@@ -175,7 +128,7 @@ DNASequence::DNASequence(const char* sequence, size_t size = -1) {
     const char *seq_ptr;
 
     /* Get the sequence size */
-    if(size == -1) {
+    if(size == size_t(-1)) {
         size = 0;
         seq_ptr = sequence;
         while(*seq_ptr != '\0') {
@@ -183,143 +136,172 @@ DNASequence::DNASequence(const char* sequence, size_t size = -1) {
             ++seq_ptr;
         }
     }
+    DNA_INSTRUMENT(Construct, size);
 
-    /* Check if the DNA Sequence is valid */
-    if(verifySequence(sequence, size) == false) {
+    /* Fill in the sequence with Nuclutides and set its size, fails if the DNA Sequence is not valid */
+    if(fillSequence(this->allocateSequence(size), sequence, size, this->m_ambiguous) != size) {
         printf("DNASequence Error: the provided sequence string has an invalid Nucleotide value!\n");
-        this->m_size = 0;
         this->m_sequence = nullptr;
+        this->m_ambiguous.clear();
+        this->m_size = 0;
         return;
     }
-
-    /* Fill in the sequence with Nuclutides and set its size */
-    fillSequence(this->m_sequence, sequence, size);
     this->m_size = size;
 }
 
 
 DNASequence::DNASequence(const DNASequence &sequence) {
-    size_t seq_size = (sequence.m_size + 3) / 4;
+    this->m_size = sequence.m_size;
+    this->m_ambiguous = sequence.m_ambiguous;
 
+    /* A read-only sequence shares the packed data instead of copying it */
+    if(sequence.m_borrowed) {
+        this->m_borrowed = sequence.m_borrowed;
+        this->m_owner = sequence.m_owner;
+        return;
+    }
+
+    std::memcpy(this->allocateSequence(sequence.m_size), sequence.getPackedSequence(), (sequence.m_size + 3) / 4);
+}
+
+
+DNASequence::DNASequence(DNASequence &&sequence) noexcept {
+    this->m_sequence = std::move(sequence.m_sequence);
+    this->m_capacity = sequence.m_capacity;
     this->m_size = sequence.m_size;
-    this->m_sequence = std::unique_ptr<char>(new char[seq_size]);
+    std::memcpy(this->m_inline, sequence.m_inline, INLINE_BYTES);
+    this->m_borrowed = sequence.m_borrowed;
+    this->m_owner = std::move(sequence.m_owner);
+    this->m_ambiguous = std::move(sequence.m_ambiguous);
+
+    sequence.m_size = 0;
+    sequence.m_borrowed = nullptr;
+    sequence.m_ambiguous.clear();
+}
 
-    char *copy_seq_ptr = sequence.m_sequence.get();
-    char *seq_ptr = this->m_sequence.get();
 
-    for(size_t i = 0; i < seq_size; ++i) {
-        *seq_ptr = *copy_seq_ptr;
-        ++seq_ptr;
-        ++copy_seq_ptr;
-    }
+DNASequence::DNASequence(const unsigned char *packed, size_t size, std::shared_ptr<const void> owner) {
+    this->m_size = size;
+    this->m_borrowed = packed;
+    this->m_owner = std::move(owner);
 }
 
 
 DNASequence::~DNASequence() {}
 
-DNASequence DNASequence::pairSequence() {
-    DNASequence pair_sequence(*this);
 
-    char *seq_ptr = pair_sequence.m_sequence.get();
-    size_t seq_end = (pair_sequence.m_size + 3) / 4;
-    
-    for(size_t i = 0; i < seq_end; ++i) {
-        *seq_ptr ^= 85;
-        ++seq_ptr;
+ParseResult DNASequence::tryParse(const std::string &sequence) {
+    return tryParse(&sequence[0], sequence.size());
+}
+
+
+ParseResult DNASequence::tryParse(const char* sequence, size_t size) {
+    ParseResult result;
+    DNASequence &parsed = result.sequence;
+
+    if(size == size_t(-1))
+        size = std::strlen(sequence);
+    DNA_INSTRUMENT(Parse, size);
+
+    size_t valid = fillSequence(parsed.allocateSequence(size), sequence, size, parsed.m_ambiguous);
+    if(valid != size) {
+        parsed = DNASequence();
+        result.error = ParseError::InvalidNucleotide;
+        result.error_offset = valid;
+        result.error_character = sequence[valid];
+        return result;
     }
+    parsed.m_size = size;
+    return result;
+}
+
+DNASequence DNASequence::pairSequence() {
+    DNASequence pair_sequence(*this);
 
+    pair_sequence.complement();
     return pair_sequence;
 }
 
 
 void DNASequence::reverseSequence(size_t start, size_t end) {
-    if(start >= this->m_size)
+    if(end > this->m_size)
+        end = this->m_size;
+    if(start >= end || end - start < 2)
         return;
 
-    char *sequence = this->m_sequence.get();
-    size_t pos_start, pos_end, offset_start, offset_end;
-    char start_val, end_val;
+    unsigned char *sequence = reinterpret_cast<unsigned char*>(this->writableData());
+    reverseAmbiguousRuns(this->m_ambiguous, start, end, false);
 
-    /* make sure end points to the last specified element in the reversed subsequence */
-    end = (end > this->m_size ? this->m_size : end) - 1;
+    if(start == 0 && end == this->m_size) {
+        reverseNucleotides(sequence, this->m_size, false);
+        return;
+    }
 
-    for(; start < end; ++start, --end) {
-        pos_start = start / 4;
-        pos_end = end / 4;
-        offset_start = 6 - (start % 4) * 2;
-        offset_end = 6 - (end % 4) * 2;
+    /* Swap reversed words of 32 Nucleotides from both ends of the range */
+    for(; end - start >= 64; start += 32, end -= 32) {
+        uint64_t first = loadPackedWord(sequence, this->m_size, start);
+        uint64_t last = loadPackedWord(sequence, this->m_size, end - 32);
+        storePackedWord(sequence, this->m_size, start, reversePackedWord(last), 32);
+        storePackedWord(sequence, this->m_size, end - 32, reversePackedWord(first), 32);
+    }
 
-        start_val = (sequence[pos_start] >> offset_start) & 0b11;
-        end_val = (sequence[pos_end] >> offset_end) &0b11;
+    /* Less than 64 Nucleotides are left, the last of them move to the front */
+    size_t left = end > start ? end - start : 0;
+    if(left == 0)
+        return;
+    if(left <= 32) {
+        uint64_t word = reversePackedWord(loadPackedWord(sequence, this->m_size, start));
+        storePackedWord(sequence, this->m_size, start, word << (64 - left * 2), left);
+    }
+    else {
+        uint64_t first = reversePackedWord(loadPackedWord(sequence, this->m_size, start));
+        uint64_t last = reversePackedWord(loadPackedWord(sequence, this->m_size, start + 32));
+        storePackedWord(sequence, this->m_size, start, last << (128 - left * 2), left - 32);
+        storePackedWord(sequence, this->m_size, start + left - 32, first, 32);
+    }
+}
 
-        start_val ^= end_val;
-        end_val ^= start_val;
-        start_val ^= end_val;
 
-        sequence[pos_start] = (sequence[pos_start] & (0b11111111 ^ (0b11 << offset_start))) | (start_val << offset_start);
-        sequence[pos_end] = (sequence[pos_end] & (0b11111111 ^ (0b11 << offset_end))) | (end_val << offset_end);
-    }
+void DNASequence::complement() {
+    if(this->m_size == 0)
+        return;
+
+    complementNucleotides(reinterpret_cast<unsigned char*>(this->writableData()), this->m_size);
+    complementAmbiguousRuns(this->m_ambiguous);
+    this->clearAmbiguousNucleotides();
 }
 
 
-DNASequence DNASequence::slice(size_t start, size_t end) {
-    std::string seq_slice;
-    size_t i;
-    const char *sequence = this->m_sequence.get();
+void DNASequence::reverseComplement() {
+    if(this->m_size == 0)
+        return;
 
-    end = (end >= this->m_size ? this->m_size : end) - 1;
+    reverseNucleotides(reinterpret_cast<unsigned char*>(this->writableData()), this->m_size, true);
+    reverseAmbiguousRuns(this->m_ambiguous, 0, this->m_size, true);
+    this->clearAmbiguousNucleotides();
+}
 
-    if(start >= end) {
-        return DNASequence();
-    }
 
-    i = start / 4;
-    if(start % 4) {
-        seq_slice.append(decompressNucleotides(sequence[i] << ((start % 4) * 2), 4 - start % 4));
-        start += 4 - start % 4;
-        ++i;
-    }
+DNASequence DNASequence::slice(size_t start, size_t end) {
+    DNASequenceView view = this->view(start, end);
+    DNA_INSTRUMENT(Slice, (view.getSize() + 3) / 4);
 
-    for(size_t loop_end = end - 3; start < loop_end; start += 4, i) {
-        seq_slice.append(decompressNucleotides(sequence[i++]));
-    }
+    return view.toSequence();
+}
 
-    if(start != end) {
-        seq_slice.append(decompressNucleotides(sequence[i], end + 1 - start));
-    }
 
-    return DNASequence(seq_slice);
+DNASequenceView DNASequence::view(size_t start, size_t end) const {
+    return DNASequenceView(*this).view(start, end);
 }
 
 
 bool DNASequence::matchSubsequence(const char* subsequence, size_t size, size_t start_index) {
-    // passed subsequence size is longer than the sequence slice length starting at start_index
-    if(this->m_size - start_index < size)
-        return false;
-    
-    for(size_t subseq_end = start_index + size; start_index < subseq_end; ++start_index) {
-        char nucleotide = *(subsequence++);
-        // Get upper case nucleotides
-        switch(nucleotide) {
-            case 'a':
-                nucleotide = 'A';
-                break;
-            case 't':
-                nucleotide = 'T';
-                break;
-            case 'c':
-                nucleotide = 'C';
-                break;
-            case 'g':
-                nucleotide = 'G';
-                break;
-        }
+    DNA_INSTRUMENT(Match, size);
+    PackedPattern pattern;
 
-        // Compare
-        if((*this)[start_index] != nucleotide)
-            return false;
-    }
-    return true;
+    if(!packPattern(subsequence, size, pattern) || overlapsAmbiguousRun(this->m_ambiguous, start_index, start_index + size))
+        return false;
+    return matchPackedPattern(this->getPackedSequence(), this->m_size, pattern, start_index);
 }
 
 
@@ -329,62 +311,91 @@ bool DNASequence::matchSubsequence(const std::string &subsequence, size_t start_
 
 
 bool DNASequence::matchSubsequence(const DNASequence &subsequence, size_t start_index) {
-    if(subsequence.m_size > this->m_size - start_index) {
-        return false;
-    }
+    DNA_INSTRUMENT(Match, (subsequence.m_size + 3) / 4);
+    PackedPattern pattern;
 
-    for(size_t subseq_i = 0; subseq_i < subsequence.m_size; ++subseq_i, ++start_index) {
-        if(subsequence[subseq_i] != (*this)[start_index])
-            return false;
-    }
-    return true;
+    if(!packSequencePattern(subsequence, pattern) ||
+       overlapsAmbiguousRun(this->m_ambiguous, start_index, start_index + subsequence.m_size))
+        return false;
+    return matchPackedPattern(this->getPackedSequence(), this->m_size, pattern, start_index);
 }
 
 
-std::vector<size_t> DNASequence::findSubsequence(const char* subsequence, const size_t size, size_t n) {
+std::vector<size_t> DNASequence::findPattern(const PackedPattern &pattern, size_t n) {
+    DNA_INSTRUMENT(Find, (this->m_size + 3) / 4);
     std::vector<size_t> subsequence_occurances;
 
-    for(size_t subseq_start = 0, loop_end = this->m_size + 1 - size; subseq_start < loop_end && n; ++subseq_start) {
-        if(matchSubsequence(subsequence, size, subseq_start)) {
-            subsequence_occurances.push_back(subseq_start);
-            --n;
-        }
-    }
+    if(n == 0)
+        return subsequence_occurances;
 
+    scanPackedSequence(this->getPackedSequence(), this->m_size, pattern, 0, this->m_size + 1,
+        [&](size_t index) {
+            if(overlapsAmbiguousRun(this->m_ambiguous, index, index + pattern.size))
+                return true;
+            subsequence_occurances.push_back(index);
+            return --n != 0;
+        });
     return subsequence_occurances;
 }
 
 
+size_t DNASequence::countPattern(const PackedPattern &pattern) {
+    DNA_INSTRUMENT(Count, (this->m_size + 3) / 4);
+    size_t count = 0;
+
+    scanPackedSequence(this->getPackedSequence(), this->m_size, pattern, 0, this->m_size + 1,
+        [&](size_t index) {
+            if(!overlapsAmbiguousRun(this->m_ambiguous, index, index + pattern.size))
+                ++count;
+            return true;
+        });
+    return count;
+}
+
+
+std::vector<size_t> DNASequence::findSubsequence(const char* subsequence, const size_t size, size_t n) {
+    PackedPattern pattern;
+
+    if(!packPattern(subsequence, size, pattern))
+        return std::vector<size_t>();
+    return findPattern(pattern, n);
+}
+
+
 std::vector<size_t> DNASequence::findSubsequence(const std::string &subsequence, size_t n) {
     return findSubsequence(&subsequence[0], subsequence.size(), n);
 }
 
 
 std::vector<size_t> DNASequence::findSubsequence(const DNASequence &subsequence, size_t n) {
-    std::vector<size_t> subsequence_occurances;
+    PackedPattern pattern;
 
-    for(size_t subseq_start = 0, loop_end = this->m_size + 1 - subsequence.m_size; subseq_start < loop_end && n; ++subseq_start) {
-        if(matchSubsequence(subsequence, subseq_start)) {
-            subsequence_occurances.push_back(subseq_start);
-            --n;
-        }
-    }
-    return subsequence_occurances;
+    if(!packSequencePattern(subsequence, pattern))
+        return std::vector<size_t>();
+    return findPattern(pattern, n);
 }
 
 
 size_t DNASequence::countSubsequence(const char* subsequence, size_t size) {
-    return findSubsequence(subsequence, size).size();
+    PackedPattern pattern;
+
+    if(!packPattern(subsequence, size, pattern))
+        return 0;
+    return countPattern(pattern);
 }
 
 
 size_t DNASequence::countSubsequence(const std::string &subsequence) {
-    return findSubsequence(subsequence).size();
+    return countSubsequence(&subsequence[0], subsequence.size());
 }
 
 
 size_t DNASequence::countSubsequence(const DNASequence &subsequence) {
-    return findSubsequence(subsequence).size();
+    PackedPattern pattern;
+
+    if(!packSequencePattern(subsequence, pattern))
+        return 0;
+    return countPattern(pattern);
 }
 
 
@@ -405,7 +416,7 @@ bool DNASequence::hasSubsequence(const DNASequence &subsequence) {
 
 size_t DNASequence::findNthSubsequence(const std::string &subsequence, size_t n) {
     std::vector<size_t> first_n_occurances = findSubsequence(subsequence, n);
-    if(first_n_occurances.size() != n)
+    if(n == 0 || first_n_occurances.size() != n)
         return -1;
     return first_n_occurances.back();
 }
@@ -413,7 +424,7 @@ size_t DNASequence::findNthSubsequence(const std::string &subsequence, size_t n)
 
 size_t DNASequence::findNthSubsequence(const char* subsequence, size_t size, size_t n) {
     std::vector<size_t> first_n_occurances = findSubsequence(subsequence, size, n);
-    if(first_n_occurances.size() != n)
+    if(n == 0 || first_n_occurances.size() != n)
         return -1;
     return first_n_occurances.back();
 }
@@ -421,24 +432,460 @@ size_t DNASequence::findNthSubsequence(const char* subsequence, size_t size, siz
 
 size_t DNASequence::findNthSubsequence(const DNASequence &subsequence, size_t n) {
     std::vector<size_t> first_n_occurances = findSubsequence(subsequence, n);
-    if(first_n_occurances.size() != n)
+    if(n == 0 || first_n_occurances.size() != n)
         return -1;
     return first_n_occurances.back();
 }
 
 
+/*
+    * Runs the packed search on every chunk of candidate starting indexes in parallel.
+    * Once the chunks [0, k) are complete and hold 'n' matches, 'limit' is set to k
+     and the chunks from k on stop at their next check.
+*/
+std::vector<size_t> DNASequence::findPatternParallel(const PackedPattern &pattern, size_t n, ThreadPool *pool) {
+    DNA_INSTRUMENT(FindParallel, (this->m_size + 3) / 4);
+    std::vector<size_t> subsequence_occurances;
+
+    if(n == 0 || pattern.size > this->m_size)
+        return subsequence_occurances;
+
+    const unsigned char *sequence = this->getPackedSequence();
+    const size_t size = this->m_size;
+    const size_t candidates = size - pattern.size + 1;
+    const size_t chunks = (candidates + PARALLEL_SEARCH_CHUNK - 1) / PARALLEL_SEARCH_CHUNK;
+
+    std::vector<std::vector<size_t>> chunk_occurances(chunks);
+    std::vector<bool> chunk_done(chunks, false);
+    std::atomic<size_t> limit(chunks);
+    std::mutex progress_mutex;
+    size_t done_prefix = 0;
+    size_t prefix_occurances = 0;
+
+    (pool ? *pool : ThreadPool::shared()).parallelFor(chunks, [&](size_t chunk) {
+        std::vector<size_t> &occurances = chunk_occurances[chunk];
+        size_t begin = chunk * PARALLEL_SEARCH_CHUNK;
+        size_t end = begin + PARALLEL_SEARCH_CHUNK < candidates ? begin + PARALLEL_SEARCH_CHUNK : candidates;
+
+        for(size_t step = begin; step < end && chunk < limit.load(std::memory_order_relaxed); step += PARALLEL_SEARCH_STEP) {
+            size_t step_end = end - step < PARALLEL_SEARCH_STEP ? end : step + PARALLEL_SEARCH_STEP;
+            bool more = scanPackedSequence(sequence, size, pattern, step, step_end,
+                [&](size_t index) {
+                    if(overlapsAmbiguousRun(this->m_ambiguous, index, index + pattern.size))
+                        return true;
+                    occurances.push_back(index);
+                    return occurances.size() < n;
+                });
+            if(!more)
+                break;
+        }
+
+        /* Extend the completed prefix of chunks and cancel what is after 'n' matches */
+        std::lock_guard<std::mutex> lock(progress_mutex);
+        chunk_done[chunk] = true;
+        while(done_prefix < limit.load() && chunk_done[done_prefix]) {
+            prefix_occurances += chunk_occurances[done_prefix].size();
+            ++done_prefix;
+            if(prefix_occurances >= n)
+                limit.store(done_prefix);
+        }
+    });
+
+    for(size_t chunk = 0; chunk < limit.load() && subsequence_occurances.size() < n; ++chunk) {
+        const std::vector<size_t> &occurances = chunk_occurances[chunk];
+        size_t take = n - subsequence_occurances.size() < occurances.size() ? n - subsequence_occurances.size() : occurances.size();
+        subsequence_occurances.insert(subsequence_occurances.end(), occurances.begin(), occurances.begin() + take);
+    }
+    return subsequence_occurances;
+}
+
+
+size_t DNASequence::countPatternParallel(const PackedPattern &pattern, ThreadPool *pool) {
+    DNA_INSTRUMENT(CountParallel, (this->m_size + 3) / 4);
+
+    if(pattern.size > this->m_size)
+        return 0;
+
+    const unsigned char *sequence = this->getPackedSequence();
+    const size_t size = this->m_size;
+    const size_t candidates = size - pattern.size + 1;
+    const size_t chunks = (candidates + PARALLEL_SEARCH_CHUNK - 1) / PARALLEL_SEARCH_CHUNK;
+    std::atomic<size_t> count(0);
+
+    (pool ? *pool : ThreadPool::shared()).parallelFor(chunks, [&](size_t chunk) {
+        size_t begin = chunk * PARALLEL_SEARCH_CHUNK;
+        size_t chunk_count = 0;
+
+        scanPackedSequence(sequence, size, pattern, begin, begin + PARALLEL_SEARCH_CHUNK,
+            [&](size_t index) {
+                if(!overlapsAmbiguousRun(this->m_ambiguous, index, index + pattern.size))
+                    ++chunk_count;
+                return true;
+            });
+        count.fetch_add(chunk_count, std::memory_order_relaxed);
+    });
+    return count.load();
+}
+
+
+std::vector<size_t> DNASequence::findSubsequenceParallel(const char* subsequence, size_t size, size_t n, ThreadPool *pool) {
+    PackedPattern pattern;
+
+    if(!packPattern(subsequence, size, pattern))
+        return std::vector<size_t>();
+    return findPatternParallel(pattern, n, pool);
+}
+
+
+std::vector<size_t> DNASequence::findSubsequenceParallel(const std::string &subsequence, size_t n, ThreadPool *pool) {
+    return findSubsequenceParallel(&subsequence[0], subsequence.size(), n, pool);
+}
+
+
+std::vector<size_t> DNASequence::findSubsequenceParallel(const DNASequence &subsequence, size_t n, ThreadPool *pool) {
+    PackedPattern pattern;
+
+    if(!packSequencePattern(subsequence, pattern))
+        return std::vector<size_t>();
+    return findPatternParallel(pattern, n, pool);
+}
+
+
+size_t DNASequence::countSubsequenceParallel(const char* subsequence, size_t size, ThreadPool *pool) {
+    PackedPattern pattern;
+
+    if(!packPattern(subsequence, size, pattern))
+        return 0;
+    return countPatternParallel(pattern, pool);
+}
+
+
+size_t DNASequence::countSubsequenceParallel(const std::string &subsequence, ThreadPool *pool) {
+    return countSubsequenceParallel(&subsequence[0], subsequence.size(), pool);
+}
+
+
+size_t DNASequence::countSubsequenceParallel(const DNASequence &subsequence, ThreadPool *pool) {
+    PackedPattern pattern;
+
+    if(!packSequencePattern(subsequence, pattern))
+        return 0;
+    return countPatternParallel(pattern, pool);
+}
+
+
+size_t DNASequence::findNthSubsequenceParallel(const std::string &subsequence, size_t n, ThreadPool *pool) {
+    std::vector<size_t> first_n_occurances = findSubsequenceParallel(subsequence, n, pool);
+    if(n == 0 || first_n_occurances.size() != n)
+        return -1;
+    return first_n_occurances.back();
+}
+
+
+size_t DNASequence::findNthSubsequenceParallel(const char* subsequence, size_t size, size_t n, ThreadPool *pool) {
+    std::vector<size_t> first_n_occurances = findSubsequenceParallel(subsequence, size, n, pool);
+    if(n == 0 || first_n_occurances.size() != n)
+        return -1;
+    return first_n_occurances.back();
+}
+
+
+size_t DNASequence::findNthSubsequenceParallel(const DNASequence &subsequence, size_t n, ThreadPool *pool) {
+    std::vector<size_t> first_n_occurances = findSubsequenceParallel(subsequence, n, pool);
+    if(n == 0 || first_n_occurances.size() != n)
+        return -1;
+    return first_n_occurances.back();
+}
+
+
+std::vector<ApproximateMatch> DNASequence::findApproximatePattern(const PackedPattern &pattern, size_t max_errors,
+                                                                  EditDistance distance, size_t n) {
+    DNA_INSTRUMENT(FindApproximate, (this->m_size + 3) / 4);
+
+    /* With ambiguous Nucleotides every match is found first, those covering one are dropped */
+    size_t limit = this->m_ambiguous.empty() ? n : -1;
+    std::vector<ApproximateMatch> matches = distance == EditDistance::Levenshtein
+        ? findLevenshteinMatches(this->getPackedSequence(), this->m_size, pattern, max_errors, limit)
+        : findHammingMatches(this->getPackedSequence(), this->m_size, pattern, max_errors, limit);
+
+    if(!this->m_ambiguous.empty()) {
+        size_t kept = 0;
+        for(const ApproximateMatch &match : matches) {
+            if(kept < n && !overlapsAmbiguousRun(this->m_ambiguous, match.index, match.index + match.size))
+                matches[kept++] = match;
+        }
+        matches.resize(kept);
+    }
+    return matches;
+}
+
+
+std::vector<ApproximateMatch> DNASequence::findApproximate(const char* subsequence, size_t size, size_t max_errors,
+                                                           EditDistance distance, size_t n) {
+    PackedPattern pattern;
+
+    if(!packPattern(subsequence, size, pattern))
+        return std::vector<ApproximateMatch>();
+    return findApproximatePattern(pattern, max_errors, distance, n);
+}
+
+
+std::vector<ApproximateMatch> DNASequence::findApproximate(const std::string &subsequence, size_t max_errors,
+                                                           EditDistance distance, size_t n) {
+    return findApproximate(&subsequence[0], subsequence.size(), max_errors, distance, n);
+}
+
+
+std::vector<ApproximateMatch> DNASequence::findApproximate(const DNASequence &subsequence, size_t max_errors,
+                                                           EditDistance distance, size_t n) {
+    PackedPattern pattern;
+
+    if(!packSequencePattern(subsequence, pattern))
+        return std::vector<ApproximateMatch>();
+    return findApproximatePattern(pattern, max_errors, distance, n);
+}
+
+
+NucleotideComposition DNASequence::getComposition(size_t start_index, size_t end_index) const {
+    if(end_index > this->m_size)
+        end_index = this->m_size;
+
+    NucleotideComposition composition = countComposition(this->getPackedSequence(), start_index, end_index);
+
+    /* The ambiguous Nucleotides are packed as 'A' */
+    composition.n = countAmbiguousNucleotides(this->m_ambiguous, start_index, end_index);
+    composition.a -= composition.n;
+    return composition;
+}
+
+
+double DNASequence::getGCContent(size_t start_index, size_t end_index) const {
+    return this->getComposition(start_index, end_index).getGCContent();
+}
+
+
+std::vector<NucleotideComposition> DNASequence::getCompositionProfile(size_t window, size_t step) const {
+    if(window == 0 || step == 0) {
+        printf("DNASequence Error: the window and the step of a profile must not be 0!\n");
+        return std::vector<NucleotideComposition>();
+    }
+    std::vector<NucleotideComposition> profile = compositionProfile(this->getPackedSequence(), this->m_size, window, step);
+
+    for(size_t i = 0; i < profile.size() && !this->m_ambiguous.empty(); ++i) {
+        profile[i].n = countAmbiguousNucleotides(this->m_ambiguous, i * step, i * step + window);
+        profile[i].a -= profile[i].n;
+    }
+    return profile;
+}
+
+
+std::vector<double> DNASequence::getGCProfile(size_t window, size_t step) const {
+    std::vector<double> profile;
+
+    for(const NucleotideComposition &composition : this->getCompositionProfile(window, step))
+        profile.push_back(composition.getGCContent());
+    return profile;
+}
+
+
+std::vector<double> DNASequence::getGCSkewProfile(size_t window, size_t step) const {
+    std::vector<double> profile;
+
+    for(const NucleotideComposition &composition : this->getCompositionProfile(window, step))
+        profile.push_back(composition.getGCSkew());
+    return profile;
+}
+
+
+void DNASequence::erase(size_t start_index, size_t end_index) {
+    if(end_index > this->m_size)
+        end_index = this->m_size;
+    if(start_index >= end_index)
+        return;
+
+    this->spliceSequence(start_index, end_index - start_index, 0);
+}
+
+
+void DNASequence::erase(const char* subsequence, size_t size, size_t n) {
+    PackedPattern pattern;
+
+    if(size == 0 || n == 0 || !packPattern(subsequence, size, pattern))
+        return;
+    erasePattern(pattern, n);
+}
+
+
+void DNASequence::erase(const std::string &subsequence, size_t n) {
+    erase(&subsequence[0], subsequence.size(), n);
+}
+
+
+void DNASequence::erase(const DNASequence &subsequence, size_t n) {
+    PackedPattern pattern;
+
+    if(subsequence.m_size == 0 || n == 0 || !packSequencePattern(subsequence, pattern))
+        return;
+    erasePattern(pattern, n);
+}
+
+
+bool DNASequence::insert(size_t index, const char* subsequence, size_t size) {
+    return spliceNucleotides(index < this->m_size ? index : this->m_size, 0, subsequence, size);
+}
+
+
+bool DNASequence::insert(size_t index, const std::string &subsequence) {
+    return insert(index, &subsequence[0], subsequence.size());
+}
+
+
+void DNASequence::insert(size_t index, const DNASequence &subsequence) {
+    spliceNucleotides(index < this->m_size ? index : this->m_size, 0, subsequence);
+}
+
+
+bool DNASequence::append(const char* subsequence, size_t size) {
+    return spliceNucleotides(this->m_size, 0, subsequence, size);
+}
+
+
+bool DNASequence::append(const std::string &subsequence) {
+    return append(&subsequence[0], subsequence.size());
+}
+
+
+void DNASequence::append(const DNASequence &subsequence) {
+    spliceNucleotides(this->m_size, 0, subsequence);
+}
+
+
+bool DNASequence::replace(size_t start_index, size_t end_index, const char* subsequence, size_t size) {
+    if(end_index > this->m_size)
+        end_index = this->m_size;
+    if(start_index > end_index)
+        start_index = end_index;
+
+    return spliceNucleotides(start_index, end_index - start_index, subsequence, size);
+}
+
+
+bool DNASequence::replace(size_t start_index, size_t end_index, const std::string &subsequence) {
+    return replace(start_index, end_index, &subsequence[0], subsequence.size());
+}
+
+
+void DNASequence::replace(size_t start_index, size_t end_index, const DNASequence &subsequence) {
+    if(end_index > this->m_size)
+        end_index = this->m_size;
+    if(start_index > end_index)
+        start_index = end_index;
+
+    spliceNucleotides(start_index, end_index - start_index, subsequence);
+}
+
+
+void DNASequence::reserve(size_t size) {
+    size_t seq_size = (size + 3) / 4;
+
+    if(size <= this->getCapacity())
+        return;
+
+    const unsigned char *sequence = this->getPackedSequence();
+    DNA_INSTRUMENT_ALLOCATION(seq_size);
+    std::unique_ptr<char[]> grown(new char[seq_size]);
+
+    std::memcpy(grown.get(), sequence, (this->m_size + 3) / 4);
+    this->m_borrowed = nullptr;
+    this->m_owner = nullptr;
+    this->m_sequence = std::move(grown);
+    this->m_capacity = seq_size;
+}
+
+
+size_t DNASequence::getCapacity() const {
+    if(this->m_borrowed)
+        return this->m_size;
+    return (this->m_sequence ? this->m_capacity : INLINE_BYTES) * 4;
+}
+
+
 /* -- Operators -- */
 
+DNASequence& DNASequence::operator=(const DNASequence &sequence) {
+    if(this == &sequence)
+        return *this;
+
+    this->m_ambiguous = sequence.m_ambiguous;
+
+    if(sequence.m_borrowed) {
+        this->m_sequence = nullptr;
+        this->m_size = sequence.m_size;
+        this->m_borrowed = sequence.m_borrowed;
+        this->m_owner = sequence.m_owner;
+        return *this;
+    }
+
+    /* Reuse the heap memory when it is big enough */
+    size_t seq_size = (sequence.m_size + 3) / 4;
+    char *seq_ptr;
+
+    if(this->m_sequence && seq_size <= this->m_capacity)
+        seq_ptr = this->m_sequence.get();
+    else
+        seq_ptr = this->allocateSequence(sequence.m_size);
+
+    std::memcpy(seq_ptr, sequence.getPackedSequence(), seq_size);
+    this->m_size = sequence.m_size;
+    return *this;
+}
+
+
+DNASequence& DNASequence::operator=(DNASequence &&sequence) noexcept {
+    if(this == &sequence)
+        return *this;
+
+    this->m_sequence = std::move(sequence.m_sequence);
+    this->m_capacity = sequence.m_capacity;
+    this->m_size = sequence.m_size;
+    std::memcpy(this->m_inline, sequence.m_inline, INLINE_BYTES);
+    this->m_borrowed = sequence.m_borrowed;
+    this->m_owner = std::move(sequence.m_owner);
+    this->m_ambiguous = std::move(sequence.m_ambiguous);
+
+    sequence.m_size = 0;
+    sequence.m_borrowed = nullptr;
+    sequence.m_ambiguous.clear();
+    return *this;
+}
+
+
+DNASequence& DNASequence::operator+=(const std::string &subsequence) {
+    this->append(subsequence);
+    return *this;
+}
+
+
+DNASequence& DNASequence::operator+=(const DNASequence &subsequence) {
+    this->append(subsequence);
+    return *this;
+}
+
+
 char DNASequence::operator[](size_t index) const {
     if(index >= this->m_size)
         return '-';
 
+    char symbol = ambiguousSymbol(this->m_ambiguous, index);
+    if(symbol)
+        return symbol;
+
     char val = '-';
     size_t pos = index % 4;
     index /= 4;
 
 
-    switch((this->m_sequence.get()[index] >> (6 - pos * 2)) & 3) {
+    switch((this->getPackedSequence()[index] >> (6 - pos * 2)) & 3) {
         case 0:
             val = 'A';
             break;
@@ -458,13 +905,23 @@ char DNASequence::operator[](size_t index) const {
 
 
 bool DNASequence::operator==(const DNASequence &dnaseq) const {
-    if(dnaseq.m_size != this->m_size) {
+    if(dnaseq.m_size != this->m_size || dnaseq.m_ambiguous != this->m_ambiguous) {
         return false;
     }
 
-    for(size_t index = 0; index < this->m_size; ++index) {
-        if((*this)[index] != dnaseq[index])
-            return false;
+    const unsigned char *sequence = this->getPackedSequence();
+    const unsigned char *other = dnaseq.getPackedSequence();
+    size_t whole_bytes = this->m_size / 4;
+
+    if(sequence == other)
+        return true;
+    if(std::memcmp(sequence, other, whole_bytes) != 0)
+        return false;
+
+    /* Only the used bits of the last byte are compared */
+    if(this->m_size % 4) {
+        unsigned char mask = 0xFF << (8 - (this->m_size % 4) * 2);
+        return ((sequence[whole_bytes] ^ other[whole_bytes]) & mask) == 0;
     }
     return true;
 }
@@ -475,6 +932,43 @@ bool DNASequence::operator!=(const DNASequence &dnaseq) const {
 }
 
 
+std::strong_ordering DNASequence::operator<=>(const DNASequence &dnaseq) const {
+    /* Ambiguous Nucleotides are ordered by their symbol, as in the strings */
+    if(!this->m_ambiguous.empty() || !dnaseq.m_ambiguous.empty()) {
+        std::string sequence(this->m_size, '\0');
+        std::string other(dnaseq.m_size, '\0');
+
+        unpackSequence(*this, &sequence[0]);
+        unpackSequence(dnaseq, &other[0]);
+        return sequence.compare(other) <=> 0;
+    }
+
+    const unsigned char *sequence = this->getPackedSequence();
+    const unsigned char *other = dnaseq.getPackedSequence();
+    size_t common = this->m_size < dnaseq.m_size ? this->m_size : dnaseq.m_size;
+
+    for(size_t index = 0; index < common; index += 32) {
+        uint64_t word = loadPackedWord(sequence, this->m_size, index);
+        uint64_t other_word = loadPackedWord(other, dnaseq.m_size, index);
+        size_t count = common - index;
+
+        if(count < 32) {
+            uint64_t mask = ~uint64_t(0) << (64 - count * 2);
+            word &= mask;
+            other_word &= mask;
+        }
+        if(word == other_word)
+            continue;
+
+        /* Flip the high bit of T ('01') and C ('11') so the codes follow 'A' < 'C' < 'G' < 'T' */
+        word ^= (word & 0x5555555555555555ull) << 1;
+        other_word ^= (other_word & 0x5555555555555555ull) << 1;
+        return word <=> other_word;
+    }
+    return this->m_size <=> dnaseq.m_size;
+}
+
+
 bool DNASequence::operator==(const std::string &dnaseq) const {
     if(this->m_size != dnaseq.size())
         return false;
@@ -508,14 +1002,13 @@ bool DNASequence::operator!=(const char *dnaseq) const {
 
 
 void DNASequence::setNucleotide(size_t index, char value) {
-    char* sequence = this->m_sequence.get();
+    char* sequence;
     unsigned char pos = index % 4;
+    char symbol = ambiguityCode(value);
 
     if(index >= this->m_size)
         return;
 
-    index /= 4;
-
     // Verify Nucleotide value
     switch(value) {
         case 'a':
@@ -528,9 +1021,20 @@ void DNASequence::setNucleotide(size_t index, char value) {
         case 'C':
             break;
         default:
-            return;
+            if(symbol == 0)
+                return;
     }
 
+    /* An ambiguous Nucleotide is packed as 'A' and recorded in the runs */
+    if(symbol || !this->m_ambiguous.empty()) {
+        std::vector<AmbiguousRun> inserted;
+        if(symbol)
+            inserted.push_back({0, 1, symbol});
+        spliceAmbiguousRuns(this->m_ambiguous, index, 1, 1, inserted);
+    }
+
+    index /= 4;
+    sequence = this->writableData();
     value = compressNucleotide(value);
     switch(pos) {
         case 0:
@@ -546,53 +1050,312 @@ void DNASequence::setNucleotide(size_t index, char value) {
             sequence[index] &= 0b11111100;
             break;
     }
-    sequence[index] |= value >> (pos * 2);
+    sequence[index] |= static_cast<unsigned char>(value) >> (pos * 2);
 }
 
 
 /* -- Getters -- */
 
-size_t DNASequence::getSize() {
+size_t DNASequence::getSize() const {
     return this->m_size;
 }
 
 std::string DNASequence::getSequenceStr() {
+    DNA_INSTRUMENT(GetSequenceStr, this->m_size);
+    DNA_INSTRUMENT_ALLOCATION(this->m_size + 1);
     std::string sequence_str(this->m_size, '\0');
-    size_t size = this->m_size;
-    char *seq_ptr = this->m_sequence.get();
-    size_t i, loop_end;
-
-
-    for(i = 0, loop_end = size - 3; i < loop_end; i += 4) {
-        sequence_str.replace(i, 4, decompressNucleotides(*seq_ptr));
-        ++seq_ptr;
-    }
-    if(i != size)
-        sequence_str.replace(i, size - i, decompressNucleotides(*seq_ptr, size - i));
 
+    unpackSequence(*this, &sequence_str[0]);
     return sequence_str;
 }
 
 char* DNASequence::getSequenceCStr() {
+    DNA_INSTRUMENT(GetSequenceCStr, this->m_size);
+    DNA_INSTRUMENT_ALLOCATION(this->m_size + 1);
     char *sequence_str =  new char[this->m_size + 1];
 
-    size_t size = this->m_size;
-    std::string nucleotides_patch(4, ' ');
-    char *seq_ptr = this->m_sequence.get();
-    size_t i, j, loop_end;
+    unpackSequence(*this, sequence_str);
+    sequence_str[this->m_size] = '\0';
 
-    for(i = 0, loop_end = size - 3; i < loop_end;) {
-        nucleotides_patch.replace(0, 4, decompressNucleotides(*seq_ptr));
-        for(j = 0; j < 4; ++j, ++i)
-            sequence_str[i] = nucleotides_patch[j];
-        ++seq_ptr;
+    return sequence_str;
+}
+
+
+size_t DNASequence::decodeTo(char *out, size_t start, size_t length) const {
+    if(start >= this->m_size)
+        return 0;
+    if(length > this->m_size - start)
+        length = this->m_size - start;
+
+    DNA_INSTRUMENT(Decode, length);
+    unpackNucleotides(this->getPackedSequence(), start, length, out);
+    unpackAmbiguousRuns(this->m_ambiguous, start, length, out);
+    return length;
+}
+
+
+const std::vector<AmbiguousRun>& DNASequence::getAmbiguousRuns() const {
+    return this->m_ambiguous;
+}
+
+
+bool DNASequence::hasAmbiguousNucleotides() const {
+    return !this->m_ambiguous.empty();
+}
+
+
+const unsigned char* DNASequence::getPackedSequence() const {
+    if(this->m_borrowed)
+        return this->m_borrowed;
+    if(this->m_sequence)
+        return reinterpret_cast<const unsigned char*>(this->m_sequence.get());
+    return reinterpret_cast<const unsigned char*>(this->m_inline);
+}
+
+
+size_t DNASequence::hash() const {
+    const unsigned char *sequence = this->getPackedSequence();
+    size_t whole_bytes = this->m_size / 4;
+    uint64_t hash = 0x9E3779B97F4A7C15ull ^ this->m_size;
+    size_t i = 0;
+
+    auto mix = [&](uint64_t word) {
+        hash ^= word * 0x9E3779B97F4A7C15ull;
+        hash = ((hash << 31) | (hash >> 33)) * 0xBF58476D1CE4E5B9ull;
+    };
+
+    for(; i + 8 <= whole_bytes; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, sequence + i, 8);
+        mix(word);
     }
-    if(i != size) {
-        nucleotides_patch = decompressNucleotides(*seq_ptr, size - i);
-        for(j = 0; i < size; ++j, ++i)
-            sequence_str[i] = nucleotides_patch[j];
+
+    /* The remaining whole bytes and the used bits of the last byte */
+    if(i < (this->m_size + 3) / 4) {
+        uint64_t word = 0;
+        for(size_t shift = 0; i < whole_bytes; ++i, shift += 8)
+            word |= uint64_t(sequence[i]) << shift;
+        if(this->m_size % 4)
+            word |= uint64_t(sequence[whole_bytes] & (0xFF << (8 - (this->m_size % 4) * 2))) << 56;
+        mix(word);
     }
-    sequence_str[this->m_size] = '\0';
 
-    return sequence_str;
+    for(const AmbiguousRun &run : this->m_ambiguous) {
+        mix(run.start);
+        mix(run.size ^ (uint64_t(run.symbol) << 56));
+    }
+
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+
+/* -- Private -- */
+
+/*
+    * Allocates the packed storage of 'size' Nucleotides, inside the object when they fit in it.
+    * The previous content is released, 'm_size' is left to the caller.
+*/
+char* DNASequence::allocateSequence(size_t size) {
+    size_t seq_size = (size + 3) / 4;
+
+    this->m_borrowed = nullptr;
+    this->m_owner = nullptr;
+
+    if(seq_size <= INLINE_BYTES) {
+        this->m_sequence = nullptr;
+        return this->m_inline;
+    }
+    DNA_INSTRUMENT_ALLOCATION(seq_size);
+    this->m_sequence = std::unique_ptr<char[]>(new char[seq_size]);
+    this->m_capacity = seq_size;
+    return this->m_sequence.get();
+}
+
+
+/*
+    * Replaces the Nucleotides [index, index + removed) with 'inserted' Nucleotides left for the caller to write.
+    * The following Nucleotides are moved once, word-wise. When the packed sequence outgrows its storage it is
+     moved to a heap buffer of at least twice the previous capacity, so repeated growth is amortized.
+    * Returns the packed sequence for writing.
+*/
+unsigned char* DNASequence::spliceSequence(size_t index, size_t removed, size_t inserted) {
+    size_t size = this->m_size - removed + inserted;
+    size_t seq_size = (size + 3) / 4;
+    unsigned char *sequence = reinterpret_cast<unsigned char*>(this->writableData());
+
+    if(size > this->getCapacity()) {
+        size_t capacity = (this->m_sequence ? this->m_capacity : INLINE_BYTES) * 2;
+        capacity = capacity > seq_size ? capacity : seq_size;
+
+        DNA_INSTRUMENT_ALLOCATION(capacity);
+        std::unique_ptr<char[]> grown(new char[capacity]);
+        std::memcpy(grown.get(), sequence, (this->m_size + 3) / 4);
+        this->m_sequence = std::move(grown);
+        this->m_capacity = capacity;
+        sequence = reinterpret_cast<unsigned char*>(this->m_sequence.get());
+    }
+
+    size_t bound = size > this->m_size ? size : this->m_size;
+    movePackedNucleotides(sequence, bound, index + removed, index + inserted, this->m_size - index - removed);
+    spliceAmbiguousRuns(this->m_ambiguous, index, removed, inserted);
+
+    this->m_size = size;
+    clearPadding(sequence, size);
+    return sequence;
+}
+
+
+/*
+    * Replaces the Nucleotides [index, index + removed) with the passed Nucleotides, packed straight into place.
+    * Returns false and changes nothing if the string has an invalid Nucleotide value.
+*/
+bool DNASequence::spliceNucleotides(size_t index, size_t removed, const char *subsequence, size_t size) {
+    if(validateAmbiguousNucleotides(subsequence, size) != size) {
+        printf("DNASequence Error: the provided sequence string has an invalid Nucleotide value!\n");
+        return false;
+    }
+
+    unsigned char *sequence = this->spliceSequence(index, removed, size);
+    std::vector<AmbiguousRun> ambiguous;
+
+    packAmbiguousNucleotides(subsequence, size, sequence, this->m_size, index, ambiguous);
+    if(!ambiguous.empty()) {
+        for(AmbiguousRun &run : ambiguous)
+            run.start -= index;
+        spliceAmbiguousRuns(this->m_ambiguous, index, size, size, ambiguous);
+    }
+    return true;
+}
+
+
+void DNASequence::spliceNucleotides(size_t index, size_t removed, const DNASequence &subsequence) {
+    /* The subsequence may be this sequence, which is about to move */
+    if(&subsequence == this) {
+        DNASequence copy(subsequence);
+        this->spliceNucleotides(index, removed, copy);
+        return;
+    }
+
+    unsigned char *sequence = this->spliceSequence(index, removed, subsequence.m_size);
+    copyPackedNucleotides(subsequence.getPackedSequence(), subsequence.m_size, 0,
+                          sequence, this->m_size, index, subsequence.m_size);
+    spliceAmbiguousRuns(this->m_ambiguous, index, subsequence.m_size, subsequence.m_size, subsequence.m_ambiguous);
+}
+
+
+/*
+    * Removes the first 'n' non-overlapping occurrences of the pattern, each kept part is moved once.
+*/
+void DNASequence::erasePattern(const PackedPattern &pattern, size_t n) {
+    std::vector<size_t> occurances;
+    size_t next_free = 0;
+
+    scanPackedSequence(this->getPackedSequence(), this->m_size, pattern, 0, this->m_size + 1,
+        [&](size_t index) {
+            if(index < next_free || overlapsAmbiguousRun(this->m_ambiguous, index, index + pattern.size))
+                return true;
+            occurances.push_back(index);
+            next_free = index + pattern.size;
+            return occurances.size() < n;
+        });
+
+    if(occurances.empty())
+        return;
+
+    unsigned char *sequence = reinterpret_cast<unsigned char*>(this->writableData());
+    size_t write = occurances[0];
+    std::vector<AmbiguousRun> ambiguous;
+
+    /* The occurrences never cover an ambiguous Nucleotide, the runs move with the kept parts */
+    copyAmbiguousRuns(this->m_ambiguous, 0, write, 0, ambiguous);
+
+    for(size_t i = 0; i < occurances.size(); ++i) {
+        size_t keep_begin = occurances[i] + pattern.size;
+        size_t keep_end = i + 1 < occurances.size() ? occurances[i + 1] : this->m_size;
+
+        movePackedNucleotides(sequence, this->m_size, keep_begin, write, keep_end - keep_begin);
+        copyAmbiguousRuns(this->m_ambiguous, keep_begin, keep_end, write, ambiguous);
+        write += keep_end - keep_begin;
+    }
+
+    this->m_ambiguous.swap(ambiguous);
+    this->m_size = write;
+    clearPadding(sequence, write);
+}
+
+
+/*
+    * Sets the sequence to 'size' Nucleotides packed in 'packed'.
+    * A sequence that fits inline is copied and 'packed' is left to the caller, otherwise it is taken over.
+*/
+void DNASequence::adoptSequence(std::unique_ptr<char[]> &packed, size_t size, std::vector<AmbiguousRun> &ambiguous) {
+    size_t seq_size = (size + 3) / 4;
+
+    if(seq_size <= INLINE_BYTES) {
+        char *seq_ptr = this->allocateSequence(size);
+        if(seq_size)
+            std::memcpy(seq_ptr, packed.get(), seq_size);
+    }
+    else {
+        this->allocateSequence(0);
+        this->m_sequence = std::move(packed);
+        this->m_capacity = seq_size;
+    }
+    this->m_size = size;
+    this->m_ambiguous.swap(ambiguous);
+    ambiguous.clear();
+}
+
+
+/*
+    * Packs the ambiguous Nucleotides back as 'A' after the packed sequence was transformed (complement...).
+*/
+void DNASequence::clearAmbiguousNucleotides() {
+    if(this->m_ambiguous.empty())
+        return;
+
+    unsigned char *sequence = reinterpret_cast<unsigned char*>(this->writableData());
+    for(const AmbiguousRun &run : this->m_ambiguous)
+        clearPackedNucleotides(sequence, this->m_size, run.start, run.size);
+}
+
+
+/*
+    * Returns the packed sequence for writing,
+     a read-only sequence is first copied to its own memory (copy on write).
+*/
+char* DNASequence::writableData() {
+    if(this->m_borrowed) {
+        size_t seq_size = (this->m_size + 3) / 4;
+        const unsigned char *borrowed = this->m_borrowed;
+        std::shared_ptr<const void> owner = std::move(this->m_owner);
+
+        std::memcpy(this->allocateSequence(this->m_size), borrowed, seq_size);
+    }
+    if(this->m_sequence)
+        return this->m_sequence.get();
+    return this->m_inline;
+}
+
+
+/* ---------- ParseResult Methods ---------- */
+
+bool ParseResult::isValid() const {
+    return this->error == ParseError::None;
+}
+
+
+/* ----- Stream Operators ----- */
+
+std::ostream& operator<<(std::ostream &stream, const DNASequence &sequence) {
+    char buffer[4096];
+
+    for(size_t index = 0; index < sequence.getSize() && stream; index += sizeof(buffer)) {
+        size_t count = sequence.decodeTo(buffer, index, sizeof(buffer));
+        stream.write(buffer, count);
+    }
+    return stream;
 }
@@ -5,15 +5,35 @@
 
 #include <string>
 #include <cstring>
+#include <compare>
+#include <functional>
+#include <iosfwd>
 #include <memory>
 #include <vector>
 
+#include "ambiguous_nucleotides.hpp"
+#include "approximate_search.hpp"
+#include "nucleotide_composition.hpp"
+
+struct PackedPattern;
+struct ParseResult;
+class ThreadPool;
+class DNASequenceView;
+struct Variant;
+
 /*  
     * This class is a representation of a DNA Sequence,
     * A DNA Sequence is a sequence of Nucleotides each 
      Nucleotide can have one of the following values: A, T, G, C.
-    * The DNA Sequence is stored in the heap memory, and is deleted when the DNASequence
-     destructor is called.
+    * The DNA Sequence is stored packed, 4 Nucleotides per byte. Sequences of up to 64 Nucleotides
+     are stored inside the object, longer ones in the heap memory, which is deleted when the
+     DNASequence destructor is called.
+    * Moving a sequence never allocates, so DNASequences can be stored in std::vector by value.
+    * Ambiguous Nucleotides ('N' and the IUPAC codes, see ambiguous_nucleotides.hpp) are kept in a sorted
+     side table of runs and stored as 'A' in the packed sequence, so an assembly with long runs of 'N's stays
+     close to 2 bits per Nucleotide. operator[], the exports, the comparisons and the searches read the table,
+     an ambiguous Nucleotide is never part of an occurrence. Code reading the packed sequence directly
+     (getPackedSequence, FMIndex...) sees them as 'A'.
 */
 class DNASequence {
 public:
@@ -23,6 +43,7 @@ public:
     /* 
         * Create a DNA Sequence that equals the values presented in the string.
         * If the DNA Sequence has a character other than 'a', 't', 'g', 'c', 'A', 'T', 'G', 'C'
+         or an ambiguous Nucleotide ('N', 'R', 'Y'... in upper or lower case),
         * the created sequence will be empty and an error message will be printed/output
     */
     DNASequence(const std::string &sequence);
@@ -30,13 +51,41 @@ public:
     /* 
         * Create a DNA Sequence that equals the values presented in the c string.
         * If the size is not provided, the c string must end with a string termination character ('\0' or 0).
-        * If the DNA Sequence has a character other than 'a', 't', 'g', 'c', 'A', 'T', 'G', 'C'.
+        * If the DNA Sequence has a character other than 'a', 't', 'g', 'c', 'A', 'T', 'G', 'C'
+         or an ambiguous Nucleotide.
         * The created sequence will be empty and an error message will be printed/output.
     */
     DNASequence(const char* sequence, const size_t size);
+
+    /*
+        * Same as the constructors, without printing anything: the result holds the sequence, or an
+         error code and the offset of the first invalid character (see ParseResult).
+        * Meant for hot ingest loops, where a message per bad read would flood the output and
+         serialize the threads on the stdio lock.
+        * If the size is not provided, the c string must end with a string termination character ('\0' or 0).
+    */
+    static ParseResult tryParse(const std::string &sequence);
+    static ParseResult tryParse(const char* sequence, size_t size = -1);
     
+    /*
+        * Copying a read-only sequence shares its packed data, other sequences are deep copied.
+    */
     DNASequence(const DNASequence &sequence);
 
+    /*
+        * Moving takes over the packed data (or copies the inline Nucleotides), the moved-from
+         sequence is left empty.
+    */
+    DNASequence(DNASequence &&sequence) noexcept;
+
+    /*
+        * Create a read-only DNA Sequence over 'size' Nucleotides of already packed data, nothing is copied.
+        * 'owner' keeps the packed data alive (e.g. a memory mapped file, see packed_sequence_file.hpp),
+         it may be null if the caller keeps the data alive for the lifetime of the sequence.
+        * Modifying the sequence (setNucleotide, reverseSequence, complement...) first copies it to its own memory.
+    */
+    DNASequence(const unsigned char *packed, size_t size, std::shared_ptr<const void> owner);
+
     ~DNASequence();
 
     /* 
@@ -46,6 +95,7 @@ public:
             T is replaced with A
             G is replaced with C
             C is replaced with G
+         and ambiguous Nucleotides with their IUPAC complement (R <-> Y, K <-> M, B <-> V, D <-> H).
     */
     DNASequence pairSequence();
 
@@ -61,6 +111,17 @@ public:
     */
     void reverseSequence(size_t start = 0, size_t end = -1);
 
+    /*
+        * Replaces each Nucleotide with its pair in place (see pairSequence), 32 Nucleotides per word.
+    */
+    void complement();
+
+    /*
+        * Reverses and complements the whole sequence in place in a single pass over the packed bytes
+         (see reverseNucleotides in nucleotide_kernels.hpp).
+    */
+    void reverseComplement();
+
     /*
         * Returns a slice of the current DNASequence.
         * The slice starts at index 'start' and ends at index 'end', index 'end' is not included in the slice
@@ -70,6 +131,13 @@ public:
     */
     DNASequence slice(size_t start = 0, size_t end = -1);
 
+    /*
+        * Returns a read-only view of the range [start, end) of the sequence, nothing is copied
+         (see dna_sequence_view.hpp).
+        * The range is clamped as for slice, the view is invalidated when the sequence is modified or destroyed.
+    */
+    DNASequenceView view(size_t start = 0, size_t end = -1) const;
+
     /*
         * Returns true if the subsequence starting at index 'start_index' matches the passed subsequence
     */
@@ -79,6 +147,8 @@ public:
 
     /*
         * Returns a vector containing the starting index of the first 'n' subsequences matching the passed subsequence
+        * The search runs on the packed sequence, 32 Nucleotides are compared per 64-bit word (see packed_search.hpp).
+        * An occurrence never covers an ambiguous Nucleotide, the subsequence must be made of 'A', 'T', 'G', 'C'.
     */
     std::vector<size_t> findSubsequence(const std::string &subsequence, size_t n = -1);
     std::vector<size_t> findSubsequence(const char* subsequence, size_t size, size_t n = -1);
@@ -106,28 +176,124 @@ public:
     size_t findNthSubsequence(const char* subsequence, size_t size, size_t n);
     size_t findNthSubsequence(const DNASequence &subsequence, size_t n);
 
+    /*
+        * Parallel versions of findSubsequence, countSubsequence and findNthSubsequence.
+        * The candidate starting indexes are split into chunks of 1M Nucleotides (256KB packed) run on 'pool'
+         (ThreadPool::shared() if null), a match may extend past the end of its chunk.
+        * The chunk results are merged in ascending order. With a limit 'n', the chunks after the first
+         chunks holding 'n' matches are cancelled.
+    */
+    std::vector<size_t> findSubsequenceParallel(const std::string &subsequence, size_t n = -1, ThreadPool *pool = nullptr);
+    std::vector<size_t> findSubsequenceParallel(const char* subsequence, size_t size, size_t n = -1, ThreadPool *pool = nullptr);
+    std::vector<size_t> findSubsequenceParallel(const DNASequence &subsequence, size_t n = -1, ThreadPool *pool = nullptr);
+    size_t countSubsequenceParallel(const std::string &subsequence, ThreadPool *pool = nullptr);
+    size_t countSubsequenceParallel(const char* subsequence, size_t size, ThreadPool *pool = nullptr);
+    size_t countSubsequenceParallel(const DNASequence &subsequence, ThreadPool *pool = nullptr);
+    size_t findNthSubsequenceParallel(const std::string &subsequence, size_t n, ThreadPool *pool = nullptr);
+    size_t findNthSubsequenceParallel(const char* subsequence, size_t size, size_t n, ThreadPool *pool = nullptr);
+    size_t findNthSubsequenceParallel(const DNASequence &subsequence, size_t n, ThreadPool *pool = nullptr);
+
+    /*
+        * Returns the first 'n' occurrences of the passed subsequence with at most 'max_errors' errors.
+        * EditDistance::Hamming counts mismatches, every occurrence has the size of the subsequence and
+         they are sorted by starting index.
+        * EditDistance::Levenshtein counts substitutions, insertions and deletions, one occurrence (the shortest
+         with the fewest edits) is reported per end index and they are sorted by end index.
+        * Both run bit-parallel on the packed sequence (see approximate_search.hpp).
+    */
+    std::vector<ApproximateMatch> findApproximate(const std::string &subsequence, size_t max_errors,
+                                                  EditDistance distance = EditDistance::Hamming, size_t n = -1);
+    std::vector<ApproximateMatch> findApproximate(const char* subsequence, size_t size, size_t max_errors,
+                                                  EditDistance distance = EditDistance::Hamming, size_t n = -1);
+    std::vector<ApproximateMatch> findApproximate(const DNASequence &subsequence, size_t max_errors,
+                                                  EditDistance distance = EditDistance::Hamming, size_t n = -1);
+
+    /*
+        * Returns the number of each Nucleotide in the range [start_index, end_index), clamped as for erase.
+        * The packed words are counted with popcounts, see nucleotide_composition.hpp.
+    */
+    NucleotideComposition getComposition(size_t start_index = 0, size_t end_index = -1) const;
+    double getGCContent(size_t start_index = 0, size_t end_index = -1) const;
+
+    /*
+        * Returns the composition, the GC content or the GC skew of every window [i * step, i * step + window)
+         inside the sequence, computed incrementally in a single pass.
+        * If 'window' or 'step' is 0, an error message is printed/output and an empty vector is returned.
+    */
+    std::vector<NucleotideComposition> getCompositionProfile(size_t window, size_t step) const;
+    std::vector<double> getGCProfile(size_t window, size_t step) const;
+    std::vector<double> getGCSkewProfile(size_t window, size_t step) const;
+
     /*
         * Cut/Remove a part of the sequence,
         * The deleted part starts at 'start_index' and ends at 'end_index'(exclusive / end_index is not included).
         * If 'end_index' is bigger than the sequence size it's set to be the size of the sequence.
         * if 'start_index' is bigger or equeal to the sequence size, nothing happens.
     */
+    void erase(size_t start_index, size_t end_index = -1);
+
+    /*
+        * Removes the first 'n' non-overlapping occurrences of the passed subsequence, searched from the start.
+        * The kept parts are shifted down once each, so the cost is linear in the sequence size.
+        * An empty or invalid subsequence removes nothing.
+    */
     void erase(const std::string &subsequence, size_t n);
     void erase(const char* subsequence, size_t size, size_t n);
     void erase(const DNASequence &subsequence, size_t n);
 
     /*
-        * Sets the Nucleotide at index to value('A', 'T', 'C', or 'G')
+        * Inserts the passed Nucleotides before 'index', or at the end if 'index' is bigger than the sequence size.
+        * The following Nucleotides are shifted word-wise and the capacity grows geometrically,
+         so appending many times costs linear time overall.
+        * The inserted Nucleotides may be ambiguous. If the passed string has an invalid Nucleotide value,
+         nothing changes, an error message is printed/output and false is returned.
+    */
+    bool insert(size_t index, const std::string &subsequence);
+    bool insert(size_t index, const char* subsequence, size_t size);
+    void insert(size_t index, const DNASequence &subsequence);
+
+    /* Same as inserting at the end of the sequence */
+    bool append(const std::string &subsequence);
+    bool append(const char* subsequence, size_t size);
+    void append(const DNASequence &subsequence);
+    DNASequence& operator+=(const std::string &subsequence);
+    DNASequence& operator+=(const DNASequence &subsequence);
+
+    /*
+        * Replaces the range [start_index, end_index) with the passed Nucleotides, the range is clamped as for erase.
+        * If the passed string has an invalid Nucleotide value, nothing changes, an error message is
+         printed/output and false is returned.
+    */
+    bool replace(size_t start_index, size_t end_index, const std::string &subsequence);
+    bool replace(size_t start_index, size_t end_index, const char* subsequence, size_t size);
+    void replace(size_t start_index, size_t end_index, const DNASequence &subsequence);
+
+    /* Makes room for 'size' Nucleotides without reallocating */
+    void reserve(size_t size);
+    size_t getCapacity() const;
+
+    /*
+        * Sets the Nucleotide at index to value('A', 'T', 'C', or 'G', or an ambiguous Nucleotide such as 'N')
         * Passing an invalid Nucleotide value does not change the value at index
         * If the index is bigger or equal to the size of the sequence nothing happens
     */
     void setNucleotide(size_t index, char value);
 
     /* Operators */
+    DNASequence& operator=(const DNASequence &sequence);
+    DNASequence& operator=(DNASequence &&sequence) noexcept;
+
     // Only get by operator[]
     char operator[](size_t index) const;
+    /*
+        * Sequences are compared on their packed bytes: memcmp of the whole bytes then the masked last byte.
+        * The ordering is the lexicographic order of the Nucleotide strings ('A' < 'C' < 'G' < 'T'),
+         32 Nucleotides are compared per word and a prefix comes before the longer sequence.
+        * Sequences with ambiguous Nucleotides also compare their runs, and are ordered as strings.
+    */
     bool operator==(const DNASequence &dnaseq) const;
     bool operator!=(const DNASequence &dnaseq) const;
+    std::strong_ordering operator<=>(const DNASequence &dnaseq) const;
     bool operator==(const std::string &dnaseq) const;
     bool operator!=(const std::string &dnaseq) const;
     /* 
@@ -137,13 +303,103 @@ public:
     bool operator!=(const char *dnaseq) const;
 
     /* Getters */
-    size_t getSize();
+    size_t getSize() const;
     std::string getSequenceStr();
+    // The caller must delete[] the returned string, decodeTo writes into a buffer of the caller
     char* getSequenceCStr();
 
+    /*
+        * Writes the 'length' Nucleotides starting at index 'start' into 'out' as upper case characters,
+         with their ambiguous symbols, without allocating nor writing a string terminator.
+        * The bytes are decoded 4 Nucleotides at a time through a 256 entry table by the unpack kernels.
+        * If the range goes past the end of the sequence it is clipped, returns the number of characters written.
+    */
+    size_t decodeTo(char *out, size_t start = 0, size_t length = -1) const;
+
+    /* The runs of ambiguous Nucleotides, sorted by index */
+    const std::vector<AmbiguousRun>& getAmbiguousRuns() const;
+    bool hasAmbiguousNucleotides() const;
+
+    /*
+        * Returns the packed Nucleotides, 4 per byte from left to right, the first Nucleotide in the highest bits
+         ('00' A, '01' T, '10' G, '11' C), the unused bits of the last byte are unspecified.
+        * Ambiguous Nucleotides are packed as 'A'.
+    */
+    const unsigned char* getPackedSequence() const;
+
+    /*
+        * Returns a hash of the Nucleotides, mixed 32 Nucleotides (8 packed bytes) at a time.
+        * Equal sequences have equal hashes, whatever the unused bits of their last byte and
+         whether they are read-only or not.
+    */
+    size_t hash() const;
+
 private:
-    std::unique_ptr<char> m_sequence;
+    /* Number of packed bytes stored inside the object, 64 Nucleotides */
+    static const size_t INLINE_BYTES = 16;
+
+    char* allocateSequence(size_t size);
+    unsigned char* spliceSequence(size_t index, size_t removed, size_t inserted);
+    bool spliceNucleotides(size_t index, size_t removed, const char *subsequence, size_t size);
+    void spliceNucleotides(size_t index, size_t removed, const DNASequence &subsequence);
+    void adoptSequence(std::unique_ptr<char[]> &packed, size_t size, std::vector<AmbiguousRun> &ambiguous);
+    void clearAmbiguousNucleotides();
+    char* writableData();
+    std::vector<size_t> findPattern(const PackedPattern &pattern, size_t n);
+    size_t countPattern(const PackedPattern &pattern);
+    std::vector<size_t> findPatternParallel(const PackedPattern &pattern, size_t n, ThreadPool *pool);
+    size_t countPatternParallel(const PackedPattern &pattern, ThreadPool *pool);
+    void erasePattern(const PackedPattern &pattern, size_t n);
+    std::vector<ApproximateMatch> findApproximatePattern(const PackedPattern &pattern, size_t max_errors,
+                                                         EditDistance distance, size_t n);
+
+    /* Heap memory of the packed sequence, null when it is stored inline */
+    std::unique_ptr<char[]> m_sequence;
+    size_t m_capacity = 0;
     size_t m_size;
+    char m_inline[INLINE_BYTES] = {};
+
+    /* Runs of ambiguous Nucleotides, packed as 'A' */
+    std::vector<AmbiguousRun> m_ambiguous;
+
+    /* Read-only packed data and the object keeping it alive, only set for read-only sequences */
+    const unsigned char *m_borrowed = nullptr;
+    std::shared_ptr<const void> m_owner;
+
+    friend class FastxReader;
+    friend class DNASequenceView;
+    friend DNASequence applyVariants(const DNASequence &reference, const std::vector<Variant> &variants);
+};
+
+enum class ParseError {
+    None,
+    InvalidNucleotide
+};
+
+/*
+    * The result of DNASequence::tryParse.
+    * On error 'sequence' is empty, 'error_offset' is the index of the first invalid character
+     and 'error_character' that character.
+*/
+struct ParseResult {
+    DNASequence sequence;
+    ParseError error = ParseError::None;
+    size_t error_offset = 0;
+    char error_character = 0;
+
+    bool isValid() const;
+};
+
+/*
+    * Writes the Nucleotides of the sequence to 'stream', decoded in chunks through a fixed buffer on the stack.
+*/
+std::ostream& operator<<(std::ostream &stream, const DNASequence &sequence);
+
+template<>
+struct std::hash<DNASequence> {
+    size_t operator()(const DNASequence &sequence) const {
+        return sequence.hash();
+    }
 };
 
 #endif
\ No newline at end of file
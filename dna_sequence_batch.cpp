@@ -0,0 +1,262 @@
+#include "dna_sequence_batch.hpp"
+#include "nucleotide_kernels.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+/* Size in bytes of an arena block, a sequence bigger than a quarter of it gets a block of its own */
+static const size_t BATCH_BLOCK_SIZE = 1 << 20;
+static const size_t BATCH_DEDICATED_SIZE = BATCH_BLOCK_SIZE / 4;
+
+
+/* ----- DNASequence Batch Utility Functions ----- */
+
+std::vector<InvalidRead> validateReads(const char *buffer, const size_t *offsets, size_t count,
+                                       bool allow_ambiguous) {
+    size_t (*validate)(const char*, size_t) = allow_ambiguous ? validateAmbiguousNucleotides : validateNucleotides;
+    std::vector<InvalidRead> invalid;
+
+    for(size_t read = 0; read < count; ++read) {
+        size_t size = offsets[read + 1] - offsets[read];
+        size_t valid = validate(buffer + offsets[read], size);
+
+        if(valid != size)
+            invalid.push_back({read, valid, buffer[offsets[read] + valid]});
+    }
+    return invalid;
+}
+
+
+std::vector<InvalidRead> validateReadLines(const char *buffer, size_t size, bool allow_ambiguous) {
+    size_t (*validate)(const char*, size_t) = allow_ambiguous ? validateAmbiguousNucleotides : validateNucleotides;
+    std::vector<InvalidRead> invalid;
+    size_t read = 0;
+    size_t line_start = 0;
+    size_t index = 0;
+
+    while(index < size) {
+        index += validate(buffer + index, size - index);
+        if(index == size)
+            break;
+
+        /* The end of a line, '\r' only counts as part of a "\r\n" line end */
+        char character = buffer[index];
+        if(character == '\n') {
+            ++read;
+            line_start = ++index;
+            continue;
+        }
+        if(character == '\r' && (index + 1 == size || buffer[index + 1] == '\n')) {
+            ++index;
+            continue;
+        }
+
+        /* An invalid read, the rest of its line is skipped */
+        invalid.push_back({read, index - line_start, character});
+        const char *line_end = static_cast<const char*>(std::memchr(buffer + index, '\n', size - index));
+        if(!line_end)
+            break;
+
+        ++read;
+        line_start = index = line_end - buffer + 1;
+    }
+    return invalid;
+}
+
+
+/* ---------- DNASequenceBatch Methods ---------- */
+
+DNASequenceBatch::DNASequenceBatch() {
+    this->m_current_block = -1;
+    this->m_block_used = 0;
+    this->m_block_capacity = 0;
+    this->m_nucleotide_count = 0;
+}
+
+
+DNASequenceBatch::~DNASequenceBatch() {}
+
+
+void DNASequenceBatch::reserve(size_t sequences, size_t nucleotides) {
+    size_t bytes = (nucleotides + 3) / 4;
+
+    this->m_entries.reserve(this->m_entries.size() + sequences);
+
+    /* Start a block big enough for the reserved Nucleotides if the current one is not */
+    if(bytes > this->m_block_capacity - this->m_block_used) {
+        size_t capacity = bytes > BATCH_BLOCK_SIZE ? bytes : BATCH_BLOCK_SIZE;
+        this->m_blocks.emplace_back(new unsigned char[capacity]);
+        this->m_current_block = this->m_blocks.size() - 1;
+        this->m_block_used = 0;
+        this->m_block_capacity = capacity;
+    }
+}
+
+
+bool DNASequenceBatch::add(const char *sequence, size_t size) {
+    /* Get the sequence size */
+    if(size == size_t(-1))
+        size = std::strlen(sequence);
+
+    size_t block;
+    unsigned char *packed = this->allocate(size, block);
+
+    /* Give the space back if the DNA Sequence is not valid */
+    if(packNucleotides(sequence, size, packed) != size) {
+        printf("DNASequenceBatch Error: the provided sequence string has an invalid Nucleotide value!\n");
+        if(block == this->m_current_block)
+            this->m_block_used -= (size + 3) / 4;
+        else
+            this->m_blocks.pop_back();
+        return false;
+    }
+
+    this->m_entries.push_back({packed, size, block});
+    this->m_nucleotide_count += size;
+    return true;
+}
+
+
+bool DNASequenceBatch::add(const std::string &sequence) {
+    return this->add(&sequence[0], sequence.size());
+}
+
+
+bool DNASequenceBatch::add(const DNASequence &sequence) {
+    size_t size = sequence.getSize();
+    size_t block;
+
+    if(sequence.hasAmbiguousNucleotides()) {
+        printf("DNASequenceBatch Error: the sequence has ambiguous Nucleotides!\n");
+        return false;
+    }
+
+    unsigned char *packed = this->allocate(size, block);
+
+    if(size)
+        std::memcpy(packed, sequence.getPackedSequence(), (size + 3) / 4);
+
+    this->m_entries.push_back({packed, size, block});
+    this->m_nucleotide_count += size;
+    return true;
+}
+
+
+void DNASequenceBatch::clear() {
+    this->m_blocks.clear();
+    this->m_entries.clear();
+    this->m_current_block = -1;
+    this->m_block_used = 0;
+    this->m_block_capacity = 0;
+    this->m_nucleotide_count = 0;
+}
+
+
+size_t DNASequenceBatch::getSequenceCount() const {
+    return this->m_entries.size();
+}
+
+
+size_t DNASequenceBatch::getSequenceSize(size_t index) const {
+    if(index >= this->m_entries.size())
+        return 0;
+    return this->m_entries[index].size;
+}
+
+
+size_t DNASequenceBatch::getNucleotideCount() const {
+    return this->m_nucleotide_count;
+}
+
+
+const unsigned char* DNASequenceBatch::getPackedSequence(size_t index) const {
+    if(index >= this->m_entries.size())
+        return nullptr;
+    return this->m_entries[index].packed;
+}
+
+
+DNASequence DNASequenceBatch::getSequence(size_t index) const {
+    if(index >= this->m_entries.size() || this->m_entries[index].size == 0)
+        return DNASequence();
+
+    const Entry &entry = this->m_entries[index];
+    return DNASequence(entry.packed, entry.size, this->m_blocks[entry.block]);
+}
+
+
+std::string DNASequenceBatch::getSequenceStr(size_t index) const {
+    if(index >= this->m_entries.size())
+        return std::string();
+
+    const Entry &entry = this->m_entries[index];
+    std::string sequence_str(entry.size, '\0');
+
+    unpackNucleotides(entry.packed, 0, entry.size, &sequence_str[0]);
+    return sequence_str;
+}
+
+
+DNASequenceBatch::Iterator DNASequenceBatch::begin() const {
+    return Iterator(this, 0);
+}
+
+
+DNASequenceBatch::Iterator DNASequenceBatch::end() const {
+    return Iterator(this, this->m_entries.size());
+}
+
+
+/* -- Private -- */
+
+/*
+    * Returns room for 'size' packed Nucleotides in the arena and sets 'block' to the block holding it.
+*/
+unsigned char* DNASequenceBatch::allocate(size_t size, size_t &block) {
+    size_t bytes = (size + 3) / 4;
+
+    /* A big sequence gets its own block and leaves the current one open */
+    if(bytes > BATCH_DEDICATED_SIZE) {
+        this->m_blocks.emplace_back(new unsigned char[bytes]);
+        block = this->m_blocks.size() - 1;
+        return this->m_blocks.back().get();
+    }
+
+    if(this->m_current_block == size_t(-1) || bytes > this->m_block_capacity - this->m_block_used) {
+        this->m_blocks.emplace_back(new unsigned char[BATCH_BLOCK_SIZE]);
+        this->m_current_block = this->m_blocks.size() - 1;
+        this->m_block_used = 0;
+        this->m_block_capacity = BATCH_BLOCK_SIZE;
+    }
+
+    block = this->m_current_block;
+    unsigned char *packed = this->m_blocks[block].get() + this->m_block_used;
+    this->m_block_used += bytes;
+    return packed;
+}
+
+
+/* ---------- DNASequenceBatch::Iterator Methods ---------- */
+
+DNASequenceBatch::Iterator::Iterator(const DNASequenceBatch *batch, size_t index) : m_batch(batch), m_index(index) {}
+
+
+DNASequenceBatch::Iterator::reference DNASequenceBatch::Iterator::operator*() const {
+    return this->m_batch->getSequence(this->m_index);
+}
+
+
+DNASequenceBatch::Iterator& DNASequenceBatch::Iterator::operator++() {
+    ++this->m_index;
+    return *this;
+}
+
+
+bool DNASequenceBatch::Iterator::operator==(const Iterator &other) const {
+    return this->m_batch == other.m_batch && this->m_index == other.m_index;
+}
+
+
+bool DNASequenceBatch::Iterator::operator!=(const Iterator &other) const {
+    return !(*this == other);
+}
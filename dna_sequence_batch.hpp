@@ -0,0 +1,141 @@
+#ifndef DNA_SEQUENCE_BATCH
+#define DNA_SEQUENCE_BATCH
+
+#include "dna_sequence.hpp"
+
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+    * An invalid read found by validateReads: its number, the offset of its first invalid character
+     inside the read and that character.
+*/
+struct InvalidRead {
+    size_t read;
+    size_t offset;
+    char character;
+};
+
+/*
+    * Validates every read of a buffer in a single pass, without printing anything.
+    * Read i is buffer[offsets[i], offsets[i + 1]), 'offsets' holds 'count' + 1 entries.
+    * The reads are scanned by the vectorized kernels (see validateNucleotides), the scan of an invalid
+     read stops at its first invalid character.
+    * With 'allow_ambiguous' set, N and the IUPAC codes are valid as for DNASequence::tryParse,
+     otherwise only 'A', 'T', 'G', 'C' are, as for DNASequenceBatch::add.
+    * Returns the invalid reads in order, an empty vector if every read is valid.
+*/
+std::vector<InvalidRead> validateReads(const char *buffer, const size_t *offsets, size_t count,
+                                       bool allow_ambiguous = false);
+
+/*
+    * Same over a buffer of reads separated by line ends ("\n" or "\r\n"), read i is line i.
+    * The kernels run over the whole buffer at once: a scan stops at a line end and resumes right after it.
+*/
+std::vector<InvalidRead> validateReadLines(const char *buffer, size_t size, bool allow_ambiguous = false);
+
+/*
+    * Many DNA Sequences packed contiguously into a shared arena, with an offset table.
+    * The arena is made of blocks of 1MB (4M Nucleotides) which never move once allocated: a
+     sequence is packed at the next byte of the current block, a new block is started when it does
+     not fit, and a sequence bigger than a quarter of a block gets a block of its own.
+    * Building a batch costs one allocation per block instead of one per sequence, the sequences
+     are freed all at once with the batch and are laid out in the order they were added.
+    * getSequence returns read-only DNASequences pointing into the arena, they keep their block alive
+     after the batch is cleared or destroyed.
+*/
+class DNASequenceBatch {
+public:
+    class Iterator;
+
+    DNASequenceBatch();
+    ~DNASequenceBatch();
+
+    /* Reserves the offset table for 'sequences' sequences and the arena for 'nucleotides' Nucleotides. */
+    void reserve(size_t sequences, size_t nucleotides);
+
+    /*
+        * Validates and packs the sequence straight into the arena.
+        * If the sequence has a character other than 'a', 't', 'g', 'c', 'A', 'T', 'G', 'C'
+         nothing is added, an error message is printed and false is returned.
+        * The C string must end with a string termination character ('\0' or 0) if the size is not provided.
+    */
+    bool add(const std::string &sequence);
+    bool add(const char *sequence, size_t size = -1);
+
+    /*
+        * Copies the packed sequence into the arena.
+        * The batch only holds packed Nucleotides, a sequence with ambiguous Nucleotides is not added,
+         an error message is printed and false is returned.
+    */
+    bool add(const DNASequence &sequence);
+
+    /* Removes every sequence, the blocks still used by sequences returned by getSequence are kept alive by them. */
+    void clear();
+
+    size_t getSequenceCount() const;
+    size_t getSequenceSize(size_t index) const;
+
+    /* Total number of Nucleotides of the batch */
+    size_t getNucleotideCount() const;
+
+    /*
+        * Returns the packed Nucleotides of the sequence at 'index', in the layout of DNASequence::getPackedSequence.
+    */
+    const unsigned char* getPackedSequence(size_t index) const;
+
+    /*
+        * Returns a read-only DNASequence over the sequence at 'index' without copying it,
+         an empty sequence is returned if the index is out of range.
+    */
+    DNASequence getSequence(size_t index) const;
+    std::string getSequenceStr(size_t index) const;
+
+    /* Iterates over the sequences in order, as read-only DNASequences (see getSequence). */
+    Iterator begin() const;
+    Iterator end() const;
+
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = DNASequence;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const DNASequence*;
+        using reference = DNASequence;
+
+        Iterator(const DNASequenceBatch *batch = nullptr, size_t index = 0);
+
+        reference operator*() const;
+        Iterator& operator++();
+        bool operator==(const Iterator &other) const;
+        bool operator!=(const Iterator &other) const;
+
+    private:
+        const DNASequenceBatch *m_batch;
+        size_t m_index;
+    };
+
+private:
+    struct Entry {
+        const unsigned char *packed;
+        size_t size;
+        size_t block;
+    };
+
+    unsigned char* allocate(size_t size, size_t &block);
+
+    /* The arena blocks and the free space of the current (last shared) block */
+    std::vector<std::shared_ptr<unsigned char[]>> m_blocks;
+    size_t m_current_block;
+    size_t m_block_used;
+    size_t m_block_capacity;
+
+    /* The offset table, one entry per sequence in the order they were added */
+    std::vector<Entry> m_entries;
+    size_t m_nucleotide_count;
+};
+
+#endif
@@ -0,0 +1,286 @@
+#ifndef DNA_SEQUENCE_N
+#define DNA_SEQUENCE_N
+
+#include "dna_sequence.hpp"
+#include "dna_sequence_view.hpp"
+#include "packed_search.hpp"
+
+#include <compare>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+
+/*
+    * A fixed length sequence of K Nucleotides (1 <= K <= 64), for barcodes, UMIs and k-mers.
+    * The Nucleotides are packed 2 bits each in one or two uint64_t, in the k-mer layout of KmerIterator:
+     the first word holds the first K % 32 Nucleotides (32 if K is a multiple of 32) in its lowest bits,
+     the second word, if any, holds the last 32, the first Nucleotide is in the highest used bits.
+    * There is no heap buffer and no stored size: a DNASequenceN<K> is 8 or 16 bytes, trivially copyable,
+     and every loop runs over a compile-time count, so it makes a dense hash map key.
+    * Construction from a string literal is constexpr: an invalid literal is a compile error when it
+     initializes a constexpr variable. Anywhere else, as for the other constructors, an invalid string
+     prints an error message and leaves every Nucleotide 'A'.
+    * Ambiguous Nucleotides can not be stored.
+*/
+template<size_t K>
+class DNASequenceN {
+public:
+    static_assert(K >= 1 && K <= 64, "DNASequenceN holds 1 to 64 Nucleotides");
+
+    static constexpr size_t WORDS = (K + 31) / 32;
+
+    /* Create a sequence of K 'A'. */
+    constexpr DNASequenceN() {}
+
+    /* From a string literal of exactly K Nucleotides, upper or lower case. */
+    constexpr DNASequenceN(const char (&nucleotides)[K + 1]) {
+        if(!this->pack(nucleotides, K)) {
+            invalidSequence();
+            *this = DNASequenceN();
+        }
+    }
+
+    /* From 'size' characters, which must be exactly K valid Nucleotides. */
+    DNASequenceN(const char *nucleotides, size_t size) {
+        if(!this->pack(nucleotides, size)) {
+            printf("DNASequenceN Error: the provided sequence string is not %zu valid Nucleotides!\n", K);
+            *this = DNASequenceN();
+        }
+    }
+
+    DNASequenceN(const std::string &nucleotides) : DNASequenceN(nucleotides.data(), nucleotides.size()) {}
+
+    /*
+        * The K Nucleotides starting at index 'start' of a sequence or view, read from its packed words.
+        * The range must lie inside the sequence and hold no ambiguous Nucleotide, otherwise an error
+         message is printed and every Nucleotide is 'A', use tryLoad to tell a bad range from a real one.
+    */
+    explicit DNASequenceN(const DNASequence &sequence, size_t start = 0) {
+        if(!tryLoad(sequence, start, *this))
+            invalidRange();
+    }
+
+    explicit DNASequenceN(const DNASequenceView &sequence, size_t start = 0) {
+        if(!tryLoad(sequence, start, *this))
+            invalidRange();
+    }
+
+    /*
+        * Packs 'size' characters into 'sequence' without printing anything.
+        * Returns false if they are not exactly K valid Nucleotides, 'sequence' is then unchanged.
+    */
+    static bool tryParse(const char *nucleotides, size_t size, DNASequenceN &sequence) {
+        DNASequenceN parsed;
+
+        if(!parsed.pack(nucleotides, size))
+            return false;
+        sequence = parsed;
+        return true;
+    }
+
+    /*
+        * Loads the K Nucleotides starting at index 'start' of a sequence or view into 'loaded' without
+         printing anything, for the hot loops extracting barcodes or k-mers from reads.
+        * Returns false if the range is out of the sequence or holds an ambiguous Nucleotide,
+         'loaded' is then unchanged.
+    */
+    static bool tryLoad(const DNASequence &sequence, size_t start, DNASequenceN &loaded) {
+        if(start > sequence.getSize() || sequence.getSize() - start < K)
+            return false;
+        if(sequence.hasAmbiguousNucleotides() && overlapsAmbiguousRun(sequence.getAmbiguousRuns(), start, start + K))
+            return false;
+
+        loaded.load(sequence.getPackedSequence(), sequence.getSize(), start);
+        return true;
+    }
+
+    static bool tryLoad(const DNASequenceView &sequence, size_t start, DNASequenceN &loaded) {
+        if(start > sequence.getSize() || sequence.getSize() - start < K)
+            return false;
+        if(sequence.hasAmbiguousNucleotides() && sequence.view(start, start + K).hasAmbiguousNucleotides())
+            return false;
+
+        loaded.load(sequence.getPackedSequence(), sequence.getOffset() + sequence.getSize(), sequence.getOffset() + start);
+        return true;
+    }
+
+    /* From the words of a KmerIterator (getKmerWords) iterating over k-mers of size K. */
+    static constexpr DNASequenceN fromWords(const uint64_t *words) {
+        DNASequenceN sequence;
+
+        for(size_t word = 0; word < WORDS; ++word)
+            sequence.m_words[word] = words[word];
+        sequence.m_words[0] &= FIRST_WORD_MASK;
+        return sequence;
+    }
+
+    /* Copies the Nucleotides into an owning DNASequence. */
+    DNASequence toSequence() const {
+        unsigned char packed[WORDS * 8] = {};
+
+        storePackedWord(packed, K, 0, this->m_words[0] << (64 - FIRST_WORD_SIZE * 2), FIRST_WORD_SIZE);
+        if constexpr(WORDS == 2)
+            storePackedWord(packed, K, FIRST_WORD_SIZE, this->m_words[WORDS - 1], 32);
+        return DNASequenceView(packed, 0, K).toSequence();
+    }
+
+    /* Writes the K Nucleotides into 'out' as upper case characters, no string terminator is written. */
+    constexpr void decodeTo(char *out) const {
+        for(size_t index = 0; index < K; ++index)
+            out[index] = "ATGC"[this->code(index)];
+    }
+
+    std::string getSequenceStr() const {
+        std::string sequence_str(K, '\0');
+
+        this->decodeTo(&sequence_str[0]);
+        return sequence_str;
+    }
+
+    /*
+        * The reverse complement, computed on the words: complement every Nucleotide with a xor,
+         reverse the Nucleotides of each word, swap the words and shift the padding out.
+    */
+    constexpr DNASequenceN reverseComplement() const {
+        DNASequenceN reverse;
+        const uint64_t complement = 0x5555555555555555ull;
+        const unsigned shift = (WORDS * 32 - K) * 2;
+
+        if constexpr(WORDS == 1) {
+            reverse.m_words[0] = reversePackedWord(this->m_words[0] ^ complement) >> shift;
+        }
+        else {
+            uint64_t high = reversePackedWord(this->m_words[1] ^ complement);
+            uint64_t low = reversePackedWord(this->m_words[0] ^ complement);
+
+            /* A 128 bit shift right, the double shift keeps 'high' shifted by less than 64 */
+            reverse.m_words[0] = high >> shift;
+            reverse.m_words[1] = (low >> shift) | ((high << (63 - shift)) << 1);
+        }
+        reverse.m_words[0] &= FIRST_WORD_MASK;
+        return reverse;
+    }
+
+    /*
+        * The smallest of the sequence and its reverse complement, compared on the 2-bit codes
+         like KmerIterator::getCanonical and KmerCounter, not in the Nucleotide string order.
+    */
+    constexpr DNASequenceN canonical() const {
+        DNASequenceN reverse = this->reverseComplement();
+
+        for(size_t word = 0; word < WORDS; ++word) {
+            if(this->m_words[word] != reverse.m_words[word])
+                return this->m_words[word] < reverse.m_words[word] ? *this : reverse;
+        }
+        return *this;
+    }
+
+    /* Returns a hash of the words (MurmurHash3 finalizer), equal sequences have equal hashes. */
+    constexpr size_t hash() const {
+        uint64_t hash = K;
+
+        for(size_t word = 0; word < WORDS; ++word) {
+            hash ^= this->m_words[word];
+            hash ^= hash >> 33;
+            hash *= 0xFF51AFD7ED558CCDull;
+            hash ^= hash >> 33;
+            hash *= 0xC4CEB9FE1A85EC53ull;
+            hash ^= hash >> 33;
+        }
+        return hash;
+    }
+
+    /* Operators */
+    // Returns '-' if the index is out of the sequence
+    constexpr char operator[](size_t index) const {
+        return index < K ? "ATGC"[this->code(index)] : '-';
+    }
+
+    constexpr bool operator==(const DNASequenceN &sequence) const = default;
+
+    /*
+        * Ordered as the Nucleotide strings ('A' < 'C' < 'G' < 'T'), like DNASequence: the high bit of
+         T ('01') and C ('11') is flipped in every word and the words are compared as integers.
+    */
+    constexpr std::strong_ordering operator<=>(const DNASequenceN &sequence) const {
+        for(size_t word = 0; word < WORDS; ++word) {
+            uint64_t own = this->m_words[word] ^ ((this->m_words[word] & 0x5555555555555555ull) << 1);
+            uint64_t other = sequence.m_words[word] ^ ((sequence.m_words[word] & 0x5555555555555555ull) << 1);
+
+            if(own != other)
+                return own <=> other;
+        }
+        return std::strong_ordering::equal;
+    }
+
+    /* Getters */
+    static constexpr size_t getSize() {
+        return K;
+    }
+
+    /* The packed words, see the class comment for their layout */
+    constexpr const uint64_t* getWords() const {
+        return this->m_words;
+    }
+
+private:
+    /* Number of Nucleotides of the first word and the mask of its used bits */
+    static constexpr size_t FIRST_WORD_SIZE = K - (WORDS - 1) * 32;
+    static constexpr uint64_t FIRST_WORD_MASK = FIRST_WORD_SIZE == 32 ? ~uint64_t(0) :
+                                                (uint64_t(1) << (FIRST_WORD_SIZE * 2)) - 1;
+
+    /* Not constexpr, so an invalid string literal fails a constant evaluation */
+    static void invalidSequence() {
+        printf("DNASequenceN Error: the provided sequence string is not %zu valid Nucleotides!\n", K);
+    }
+
+    static void invalidRange() {
+        printf("DNASequenceN Error: the range is out of the sequence or has ambiguous Nucleotides!\n");
+    }
+
+    /* Loads the K Nucleotides at 'index' of a packed sequence holding 'size' Nucleotides */
+    void load(const unsigned char *packed, size_t size, size_t index) {
+        this->m_words[0] = loadPackedWord(packed, size, index) >> (64 - FIRST_WORD_SIZE * 2);
+        if constexpr(WORDS == 2)
+            this->m_words[WORDS - 1] = loadPackedWord(packed, size, index + FIRST_WORD_SIZE);
+    }
+
+    /* The 2-bit code of the Nucleotide at 'index' */
+    constexpr unsigned code(size_t index) const {
+        size_t from_end = K - 1 - index;
+        return (this->m_words[WORDS - 1 - from_end / 32] >> (from_end % 32 * 2)) & 0b11;
+    }
+
+    /* Packs exactly K Nucleotides, returns false (leaving the words partly written) otherwise */
+    constexpr bool pack(const char *nucleotides, size_t size) {
+        if(size != K)
+            return false;
+
+        for(size_t index = 0; index < K; ++index) {
+            unsigned code;
+            switch(nucleotides[index]) {
+                case 'A': case 'a': code = 0b00; break;
+                case 'T': case 't': code = 0b01; break;
+                case 'G': case 'g': code = 0b10; break;
+                case 'C': case 'c': code = 0b11; break;
+                default: return false;
+            }
+
+            size_t word = index < FIRST_WORD_SIZE ? 0 : WORDS - 1;
+            this->m_words[word] = (this->m_words[word] << 2) | code;
+        }
+        return true;
+    }
+
+    uint64_t m_words[WORDS] = {};
+};
+
+template<size_t K>
+struct std::hash<DNASequenceN<K>> {
+    size_t operator()(const DNASequenceN<K> &sequence) const {
+        return sequence.hash();
+    }
+};
+
+#endif
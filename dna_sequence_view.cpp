@@ -0,0 +1,332 @@
+#include "dna_sequence_view.hpp"
+#include "nucleotide_kernels.hpp"
+#include "packed_search.hpp"
+
+#include <ostream>
+
+/* ---------- DNASequenceView Methods ---------- */
+
+DNASequenceView::DNASequenceView() {
+    this->m_sequence = nullptr;
+    this->m_offset = 0;
+    this->m_size = 0;
+    this->m_ambiguous = nullptr;
+}
+
+
+DNASequenceView::DNASequenceView(const DNASequence &sequence) {
+    this->m_sequence = sequence.getPackedSequence();
+    this->m_offset = 0;
+    this->m_size = sequence.getSize();
+    this->m_ambiguous = sequence.hasAmbiguousNucleotides() ? &sequence.getAmbiguousRuns() : nullptr;
+}
+
+
+DNASequenceView::DNASequenceView(const unsigned char *packed, size_t offset, size_t size) {
+    this->m_sequence = packed;
+    this->m_offset = offset;
+    this->m_size = size;
+    this->m_ambiguous = nullptr;
+}
+
+
+DNASequenceView DNASequenceView::view(size_t start, size_t end) const {
+    if(end > this->m_size)
+        end = this->m_size;
+
+    if(start >= end)
+        return DNASequenceView();
+
+    DNASequenceView subview(this->m_sequence, this->m_offset + start, end - start);
+    if(this->m_ambiguous && overlapsAmbiguousRun(*this->m_ambiguous, subview.m_offset, subview.m_offset + subview.m_size))
+        subview.m_ambiguous = this->m_ambiguous;
+    return subview;
+}
+
+
+DNASequence DNASequenceView::toSequence() const {
+    DNASequence sequence;
+    size_t seq_size = (this->m_size + 3) / 4;
+    unsigned char *seq_ptr = reinterpret_cast<unsigned char*>(sequence.allocateSequence(this->m_size));
+
+    /* Realign the view on a byte boundary one word at a time, the bytes are stored big endian */
+    for(size_t byte = 0; byte < seq_size; byte += 8) {
+        uint64_t word = loadPackedWord(this->m_sequence, this->m_offset + this->m_size, this->m_offset + byte * 4);
+        size_t bytes = seq_size - byte < 8 ? seq_size - byte : 8;
+
+        for(size_t i = 0; i < bytes; ++i)
+            seq_ptr[byte + i] = word >> (56 - i * 8);
+    }
+
+    /* Clear the bits after the last Nucleotide */
+    if(this->m_size % 4)
+        seq_ptr[seq_size - 1] &= 0xFF << (8 - (this->m_size % 4) * 2);
+
+    sequence.m_size = this->m_size;
+    if(this->m_ambiguous)
+        copyAmbiguousRuns(*this->m_ambiguous, this->m_offset, this->m_offset + this->m_size, 0, sequence.m_ambiguous);
+    return sequence;
+}
+
+
+std::string DNASequenceView::getSequenceStr() const {
+    std::string sequence_str(this->m_size, '\0');
+
+    this->decodeTo(&sequence_str[0]);
+    return sequence_str;
+}
+
+
+size_t DNASequenceView::decodeTo(char *out, size_t start, size_t length) const {
+    if(start >= this->m_size)
+        return 0;
+    if(length > this->m_size - start)
+        length = this->m_size - start;
+
+    unpackNucleotides(this->m_sequence, this->m_offset + start, length, out);
+    if(this->m_ambiguous)
+        unpackAmbiguousRuns(*this->m_ambiguous, this->m_offset + start, length, out);
+    return length;
+}
+
+
+bool DNASequenceView::matchSubsequence(const char* subsequence, size_t size, size_t start_index) const {
+    PackedPattern pattern;
+
+    if(start_index > this->m_size || !packPattern(subsequence, size, pattern) ||
+       this->overlapsAmbiguous(start_index, start_index + size))
+        return false;
+    return matchPackedPattern(this->m_sequence, this->m_offset + this->m_size, pattern, this->m_offset + start_index);
+}
+
+
+bool DNASequenceView::matchSubsequence(const std::string &subsequence, size_t start_index) const {
+    return matchSubsequence(&subsequence[0], subsequence.size(), start_index);
+}
+
+
+bool DNASequenceView::matchSubsequence(const DNASequenceView &subsequence, size_t start_index) const {
+    PackedPattern pattern;
+
+    if(start_index > this->m_size || subsequence.hasAmbiguousNucleotides() ||
+       this->overlapsAmbiguous(start_index, start_index + subsequence.m_size))
+        return false;
+
+    packPattern(subsequence.m_sequence, subsequence.m_offset, subsequence.m_size, pattern);
+    return matchPackedPattern(this->m_sequence, this->m_offset + this->m_size, pattern, this->m_offset + start_index);
+}
+
+
+std::vector<size_t> DNASequenceView::findSubsequence(const char* subsequence, size_t size, size_t n) const {
+    PackedPattern pattern;
+
+    if(!packPattern(subsequence, size, pattern))
+        return std::vector<size_t>();
+    return findPattern(pattern, n);
+}
+
+
+std::vector<size_t> DNASequenceView::findSubsequence(const std::string &subsequence, size_t n) const {
+    return findSubsequence(&subsequence[0], subsequence.size(), n);
+}
+
+
+std::vector<size_t> DNASequenceView::findSubsequence(const DNASequenceView &subsequence, size_t n) const {
+    PackedPattern pattern;
+
+    if(subsequence.hasAmbiguousNucleotides())
+        return std::vector<size_t>();
+
+    packPattern(subsequence.m_sequence, subsequence.m_offset, subsequence.m_size, pattern);
+    return findPattern(pattern, n);
+}
+
+
+size_t DNASequenceView::countSubsequence(const char* subsequence, size_t size) const {
+    PackedPattern pattern;
+
+    if(!packPattern(subsequence, size, pattern))
+        return 0;
+    return countPattern(pattern);
+}
+
+
+size_t DNASequenceView::countSubsequence(const std::string &subsequence) const {
+    return countSubsequence(&subsequence[0], subsequence.size());
+}
+
+
+size_t DNASequenceView::countSubsequence(const DNASequenceView &subsequence) const {
+    PackedPattern pattern;
+
+    if(subsequence.hasAmbiguousNucleotides())
+        return 0;
+
+    packPattern(subsequence.m_sequence, subsequence.m_offset, subsequence.m_size, pattern);
+    return countPattern(pattern);
+}
+
+
+bool DNASequenceView::hasSubsequence(const std::string &subsequence) const {
+    return findSubsequence(subsequence, 1).size() == 1;
+}
+
+
+bool DNASequenceView::hasSubsequence(const char* subsequence, size_t size) const {
+    return findSubsequence(subsequence, size, 1).size() == 1;
+}
+
+
+bool DNASequenceView::hasSubsequence(const DNASequenceView &subsequence) const {
+    return findSubsequence(subsequence, 1).size() == 1;
+}
+
+
+NucleotideComposition DNASequenceView::getComposition() const {
+    NucleotideComposition composition = countComposition(this->m_sequence, this->m_offset, this->m_offset + this->m_size);
+
+    if(this->m_ambiguous) {
+        composition.n = countAmbiguousNucleotides(*this->m_ambiguous, this->m_offset, this->m_offset + this->m_size);
+        composition.a -= composition.n;
+    }
+    return composition;
+}
+
+
+double DNASequenceView::getGCContent() const {
+    return this->getComposition().getGCContent();
+}
+
+
+/* -- Operators -- */
+
+char DNASequenceView::operator[](size_t index) const {
+    if(index >= this->m_size)
+        return '-';
+    if(this->m_ambiguous && ambiguousSymbol(*this->m_ambiguous, this->m_offset + index))
+        return ambiguousSymbol(*this->m_ambiguous, this->m_offset + index);
+
+    char nucleotide;
+    unpackNucleotides(this->m_sequence, this->m_offset + index, 1, &nucleotide);
+    return nucleotide;
+}
+
+
+bool DNASequenceView::operator==(const DNASequenceView &view) const {
+    if(this->m_size != view.m_size || this->getAmbiguousRuns() != view.getAmbiguousRuns())
+        return false;
+
+    /* Compare 32 Nucleotides at a time, both views realigned to their first Nucleotide */
+    for(size_t index = 0; index < this->m_size; index += 32) {
+        uint64_t word = loadPackedWord(this->m_sequence, this->m_offset + this->m_size, this->m_offset + index);
+        uint64_t other = loadPackedWord(view.m_sequence, view.m_offset + view.m_size, view.m_offset + index);
+        size_t count = this->m_size - index;
+        uint64_t mask = count >= 32 ? ~uint64_t(0) : ~uint64_t(0) << (64 - count * 2);
+
+        if((word ^ other) & mask)
+            return false;
+    }
+    return true;
+}
+
+
+bool DNASequenceView::operator!=(const DNASequenceView &view) const {
+    return !(*this == view);
+}
+
+
+bool DNASequenceView::operator==(const std::string &dnaseq) const {
+    if(this->m_ambiguous)
+        return this->getSequenceStr() == dnaseq;
+    return this->m_size == dnaseq.size() && this->matchSubsequence(dnaseq, 0);
+}
+
+
+bool DNASequenceView::operator!=(const std::string &dnaseq) const {
+    return !(*this == dnaseq);
+}
+
+
+/* -- Getters -- */
+
+size_t DNASequenceView::getSize() const {
+    return this->m_size;
+}
+
+
+size_t DNASequenceView::getOffset() const {
+    return this->m_offset;
+}
+
+
+const unsigned char* DNASequenceView::getPackedSequence() const {
+    return this->m_sequence;
+}
+
+
+std::vector<AmbiguousRun> DNASequenceView::getAmbiguousRuns() const {
+    std::vector<AmbiguousRun> runs;
+
+    if(this->m_ambiguous)
+        copyAmbiguousRuns(*this->m_ambiguous, this->m_offset, this->m_offset + this->m_size, 0, runs);
+    return runs;
+}
+
+
+bool DNASequenceView::hasAmbiguousNucleotides() const {
+    return this->overlapsAmbiguous(0, this->m_size);
+}
+
+
+/* -- Private -- */
+
+std::vector<size_t> DNASequenceView::findPattern(const PackedPattern &pattern, size_t n) const {
+    std::vector<size_t> subsequence_occurances;
+
+    if(n == 0)
+        return subsequence_occurances;
+
+    /* The view ends the packed sequence as far as the scan is concerned, the indexes are shifted back */
+    scanPackedSequence(this->m_sequence, this->m_offset + this->m_size, pattern, this->m_offset, this->m_offset + this->m_size + 1,
+        [&](size_t index) {
+            if(this->overlapsAmbiguous(index - this->m_offset, index - this->m_offset + pattern.size))
+                return true;
+            subsequence_occurances.push_back(index - this->m_offset);
+            return --n != 0;
+        });
+    return subsequence_occurances;
+}
+
+
+size_t DNASequenceView::countPattern(const PackedPattern &pattern) const {
+    size_t count = 0;
+
+    scanPackedSequence(this->m_sequence, this->m_offset + this->m_size, pattern, this->m_offset, this->m_offset + this->m_size + 1,
+        [&](size_t index) {
+            if(!this->overlapsAmbiguous(index - this->m_offset, index - this->m_offset + pattern.size))
+                ++count;
+            return true;
+        });
+    return count;
+}
+
+
+bool DNASequenceView::overlapsAmbiguous(size_t start, size_t end) const {
+    if(end > this->m_size)
+        end = this->m_size;
+    return this->m_ambiguous && start < end &&
+           overlapsAmbiguousRun(*this->m_ambiguous, this->m_offset + start, this->m_offset + end);
+}
+
+
+/* ----- Stream Operators ----- */
+
+std::ostream& operator<<(std::ostream &stream, const DNASequenceView &view) {
+    char buffer[4096];
+
+    for(size_t index = 0; index < view.getSize() && stream; index += sizeof(buffer)) {
+        size_t count = view.decodeTo(buffer, index, sizeof(buffer));
+        stream.write(buffer, count);
+    }
+    return stream;
+}
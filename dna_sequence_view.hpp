@@ -0,0 +1,106 @@
+#ifndef DNA_SEQUENCE_VIEW
+#define DNA_SEQUENCE_VIEW
+
+#include "dna_sequence.hpp"
+
+#include <string>
+#include <vector>
+
+/*
+    * A non-owning, read-only window over packed Nucleotides: a pointer to the packed data, the index
+     of the first Nucleotide of the window (which may fall in the middle of a byte) and its size.
+    * Views are cheap to copy and creating one never allocates nor touches the data.
+    * A view does not keep the data alive: it must not outlive the DNASequence it was taken from,
+     and modifying that sequence invalidates it.
+    * A view taken from a DNASequence also sees its ambiguous Nucleotides, a view over raw packed data has none.
+*/
+class DNASequenceView {
+public:
+    /* Create an empty view. */
+    DNASequenceView();
+
+    /* A view over the whole sequence, with its ambiguous Nucleotides */
+    DNASequenceView(const DNASequence &sequence);
+
+    /*
+        * A view over 'size' Nucleotides starting at Nucleotide 'offset' of packed data,
+         in the layout of DNASequence::getPackedSequence.
+    */
+    DNASequenceView(const unsigned char *packed, size_t offset, size_t size);
+
+    /*
+        * Returns the view of the range [start, end) of this view.
+        * If end is not specified or bigger than the view size, the range ends with the view,
+         an empty view is returned if start is equal to or bigger than end.
+    */
+    DNASequenceView view(size_t start = 0, size_t end = -1) const;
+
+    /* Copies the Nucleotides of the view into an owning DNASequence, 32 Nucleotides per word. */
+    DNASequence toSequence() const;
+    std::string getSequenceStr() const;
+
+    /* Same as DNASequence::decodeTo, 'start' is relative to the start of the view. */
+    size_t decodeTo(char *out, size_t start = 0, size_t length = -1) const;
+
+    /*
+        * Same as the DNASequence methods of the same names, the indexes are relative to the start of the view
+         and the occurrences must lie entirely inside it.
+    */
+    bool matchSubsequence(const std::string &subsequence, size_t start_index) const;
+    bool matchSubsequence(const char* subsequence, size_t size, size_t start_index) const;
+    bool matchSubsequence(const DNASequenceView &subsequence, size_t start_index) const;
+
+    std::vector<size_t> findSubsequence(const std::string &subsequence, size_t n = -1) const;
+    std::vector<size_t> findSubsequence(const char* subsequence, size_t size, size_t n = -1) const;
+    std::vector<size_t> findSubsequence(const DNASequenceView &subsequence, size_t n = -1) const;
+
+    size_t countSubsequence(const std::string &subsequence) const;
+    size_t countSubsequence(const char* subsequence, size_t size) const;
+    size_t countSubsequence(const DNASequenceView &subsequence) const;
+
+    bool hasSubsequence(const std::string &subsequence) const;
+    bool hasSubsequence(const char* subsequence, size_t size) const;
+    bool hasSubsequence(const DNASequenceView &subsequence) const;
+
+    /* The number of each Nucleotide of the view and its GC content */
+    NucleotideComposition getComposition() const;
+    double getGCContent() const;
+
+    /* Operators */
+    // Returns '-' if the index is out of the view
+    char operator[](size_t index) const;
+    bool operator==(const DNASequenceView &view) const;
+    bool operator!=(const DNASequenceView &view) const;
+    bool operator==(const std::string &dnaseq) const;
+    bool operator!=(const std::string &dnaseq) const;
+
+    /* Getters */
+    size_t getSize() const;
+    size_t getOffset() const;
+
+    /* The ambiguous runs of the view, the indexes are relative to the start of the view */
+    std::vector<AmbiguousRun> getAmbiguousRuns() const;
+    bool hasAmbiguousNucleotides() const;
+
+    /* The packed data the view points into, the view starts at its Nucleotide getOffset() */
+    const unsigned char* getPackedSequence() const;
+
+private:
+    std::vector<size_t> findPattern(const PackedPattern &pattern, size_t n) const;
+    size_t countPattern(const PackedPattern &pattern) const;
+
+    /* True if one of the Nucleotides [start, end) of the view is ambiguous */
+    bool overlapsAmbiguous(size_t start, size_t end) const;
+
+    const unsigned char *m_sequence;
+    size_t m_offset;
+    size_t m_size;
+
+    /* The runs of the viewed DNASequence (indexes of the packed data), null when it has none */
+    const std::vector<AmbiguousRun> *m_ambiguous;
+};
+
+/* Writes the Nucleotides of the view to 'stream', see the DNASequence inserter. */
+std::ostream& operator<<(std::ostream &stream, const DNASequenceView &view);
+
+#endif
@@ -0,0 +1,118 @@
+#include "fasta_writer.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+/* ---------- FastaWriter Methods ---------- */
+
+FastaWriter::FastaWriter(const std::string &path, size_t line_width, size_t buffer_size)
+    : m_file(path, std::ios::binary | std::ios::trunc), m_stream(m_file) {
+    if(!m_file)
+        printf("FastaWriter Error: could not create '%s'!\n", path.c_str());
+
+    this->m_buffer_size = buffer_size ? buffer_size : 1;
+    this->m_buffer = std::unique_ptr<char[]>(new char[this->m_buffer_size]);
+    this->m_used = 0;
+    this->m_line_width = line_width;
+}
+
+
+FastaWriter::FastaWriter(std::ostream &stream, size_t line_width, size_t buffer_size) : m_stream(stream) {
+    this->m_buffer_size = buffer_size ? buffer_size : 1;
+    this->m_buffer = std::unique_ptr<char[]>(new char[this->m_buffer_size]);
+    this->m_used = 0;
+    this->m_line_width = line_width;
+}
+
+
+FastaWriter::~FastaWriter() {
+    this->flush();
+}
+
+
+bool FastaWriter::write(const std::string &name, const DNASequenceView &sequence) {
+    size_t size = sequence.getSize();
+    size_t line_left = this->m_line_width ? this->m_line_width : size;
+
+    if(!this->append(">", 1) || !this->append(name.data(), name.size()) || !this->append("\n", 1))
+        return false;
+
+    /*
+        * The Nucleotides are decoded a block of lines at a time into the scratch buffer and the lines
+         copied from it, decoding each short line on its own costs more than the copy.
+    */
+    for(size_t index = 0; index < size;) {
+        size_t block = sequence.decodeTo(this->m_scratch, index, DECODE_BLOCK);
+
+        for(const char *line = this->m_scratch; block;) {
+            size_t count = std::min(line_left, block);
+            if(!this->append(line, count))
+                return false;
+            line += count;
+            block -= count;
+            index += count;
+            line_left -= count;
+
+            if(line_left == 0 || index == size) {
+                if(!this->append("\n", 1))
+                    return false;
+                line_left = this->m_line_width ? this->m_line_width : size;
+            }
+        }
+    }
+    return true;
+}
+
+
+bool FastaWriter::flush() {
+    if(!this->writeBuffer())
+        return false;
+
+    this->m_stream.flush();
+    if(!this->m_stream) {
+        printf("FastaWriter Error: could not flush the output stream!\n");
+        return false;
+    }
+    return true;
+}
+
+
+/* -- Private -- */
+
+bool FastaWriter::writeBuffer() {
+    if(!this->m_stream) {
+        printf("FastaWriter Error: the output stream is in a failed state!\n");
+        return false;
+    }
+
+    this->m_stream.write(this->m_buffer.get(), this->m_used);
+    this->m_used = 0;
+    if(!this->m_stream) {
+        printf("FastaWriter Error: could not write to the output stream!\n");
+        return false;
+    }
+    return true;
+}
+
+
+bool FastaWriter::append(const char *data, size_t size) {
+    /* Most lines fit in the free space of the buffer */
+    if(size <= this->m_buffer_size - this->m_used) {
+        std::memcpy(this->m_buffer.get() + this->m_used, data, size);
+        this->m_used += size;
+        return true;
+    }
+
+    while(size) {
+        if(this->m_used == this->m_buffer_size && !this->writeBuffer())
+            return false;
+
+        size_t count = std::min(size, this->m_buffer_size - this->m_used);
+        std::memcpy(this->m_buffer.get() + this->m_used, data, count);
+        this->m_used += count;
+        data += count;
+        size -= count;
+    }
+    return true;
+}
@@ -0,0 +1,62 @@
+#ifndef FASTA_WRITER
+#define FASTA_WRITER
+
+#include "dna_sequence.hpp"
+#include "dna_sequence_view.hpp"
+
+#include <fstream>
+#include <memory>
+#include <ostream>
+#include <string>
+
+/*
+    * A buffered FASTA writer.
+    * The records are written into a buffer of 'buffer_size' bytes which is handed to the stream
+     once full. The Nucleotides are decoded in blocks into a fixed scratch buffer (see DNASequence::decodeTo)
+     and copied from it line by line, so writing a record never allocates.
+    * The sequence lines hold 'line_width' Nucleotides, the last one may be shorter.
+     A 'line_width' of 0 writes every sequence on a single line.
+    * The buffer is flushed when the writer is destroyed, call flush to know whether that succeeded.
+*/
+class FastaWriter {
+public:
+    /* Writes to the file at 'path', an error message is printed if it can not be created. */
+    FastaWriter(const std::string &path, size_t line_width = 60, size_t buffer_size = 1 << 20);
+
+    /* Writes to 'stream', which must outlive the writer. */
+    FastaWriter(std::ostream &stream, size_t line_width = 60, size_t buffer_size = 1 << 20);
+
+    ~FastaWriter();
+
+    FastaWriter(const FastaWriter&) = delete;
+    FastaWriter& operator=(const FastaWriter&) = delete;
+
+    /*
+        * Writes a record: '>' and 'name' on the header line, then the wrapped sequence.
+        * Returns false and prints an error message if the stream failed.
+    */
+    bool write(const std::string &name, const DNASequenceView &sequence);
+
+    /*
+        * Hands the buffered bytes to the stream and flushes it.
+        * Returns false and prints an error message if the stream failed.
+    */
+    bool flush();
+
+private:
+    /* Nucleotides decoded at once into 'm_scratch' */
+    static const size_t DECODE_BLOCK = 4096;
+
+    bool writeBuffer();
+    bool append(const char *data, size_t size);
+
+    std::ofstream m_file;
+    std::ostream &m_stream;
+    std::unique_ptr<char[]> m_buffer;
+    size_t m_buffer_size;
+    size_t m_used;
+    size_t m_line_width;
+    char m_scratch[DECODE_BLOCK];
+};
+
+#endif
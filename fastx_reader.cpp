@@ -0,0 +1,376 @@
+#include "fastx_reader.hpp"
+#include "nucleotide_kernels.hpp"
+#include "packed_search.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+/* ----- FASTX Reader Utility Functions ----- */
+
+/*
+    * Returns true for the characters that may appear inside a sequence or quality line
+     without being part of it.
+*/
+static inline bool isLineSpace(char c) {
+    return c == '\r' || c == ' ' || c == '\t';
+}
+
+
+/* ---------- FastxReader Methods ---------- */
+
+FastxReader::FastxReader(const std::string &path, size_t chunk_size)
+    : m_file(path, std::ios::binary), m_stream(m_file) {
+    if(!m_file)
+        printf("FastxReader Error: could not open '%s'!\n", path.c_str());
+
+    this->m_chunk_size = chunk_size ? chunk_size : 1;
+    this->m_buffer = std::unique_ptr<char[]>(new char[this->m_chunk_size]);
+    this->m_pos = this->m_end = this->m_buffer.get();
+    this->m_state = State::Start;
+    this->m_fastq = false;
+    this->m_packed_capacity = this->m_packed_size = this->m_sequence_length = 0;
+    this->m_error = FastxError::None;
+    this->m_error_offset = 0;
+    this->m_error_character = 0;
+}
+
+
+FastxReader::FastxReader(std::istream &stream, size_t chunk_size) : m_stream(stream) {
+    this->m_chunk_size = chunk_size ? chunk_size : 1;
+    this->m_buffer = std::unique_ptr<char[]>(new char[this->m_chunk_size]);
+    this->m_pos = this->m_end = this->m_buffer.get();
+    this->m_state = State::Start;
+    this->m_fastq = false;
+    this->m_packed_capacity = this->m_packed_size = this->m_sequence_length = 0;
+    this->m_error = FastxError::None;
+    this->m_error_offset = 0;
+    this->m_error_character = 0;
+}
+
+
+FastxReader::~FastxReader() {}
+
+
+bool FastxReader::next(FastxRecord &record) {
+    const char *line_end;
+
+    while(this->m_state != State::End) {
+        if(this->m_pos == this->m_end && !this->fillBuffer()) {
+            /* End of input, a FASTA record ends with the input */
+            State state = this->m_state;
+            this->m_state = State::End;
+
+            if(state == State::Start || (state == State::Separator && !this->m_fastq))
+                return false;
+            if(!this->m_fastq)
+                return this->finishRecord(record);
+
+            /* A FASTQ record ends with the input once its last quality line has as many values as bases */
+            if(state == State::Quality && this->m_quality.size() >= this->m_sequence_length)
+                return this->finishQuality(record);
+
+            this->setError(FastxError::TruncatedRecord, this->m_quality.size());
+            return this->finishRecord(record);
+        }
+
+        switch(this->m_state) {
+            case State::Start:
+                /* Skip blank lines up to the next header */
+                if(*this->m_pos == '>' || *this->m_pos == '@') {
+                    this->m_fastq = *this->m_pos == '@';
+                    this->m_state = State::Header;
+                }
+                else if(*this->m_pos != '\n' && !isLineSpace(*this->m_pos)) {
+                    printf("FastxReader Error: expected a '>' or '@' header, skipping line!\n");
+                    this->m_state = State::Separator;
+                    this->m_fastq = false;
+                    break;
+                }
+                ++this->m_pos;
+                break;
+
+            case State::Header:
+                line_end = static_cast<const char*>(std::memchr(this->m_pos, '\n', this->m_end - this->m_pos));
+                this->m_name.append(this->m_pos, (line_end ? line_end : this->m_end) - this->m_pos);
+                if(line_end) {
+                    if(!this->m_name.empty() && this->m_name.back() == '\r')
+                        this->m_name.pop_back();
+                    this->m_state = State::LineStart;
+                    line_end += 1;
+                }
+                this->m_pos = line_end ? line_end : this->m_end;
+                break;
+
+            case State::LineStart:
+                if(*this->m_pos == '\n' || isLineSpace(*this->m_pos)) {
+                    ++this->m_pos;
+                }
+                else if(!this->m_fastq && (*this->m_pos == '>' || *this->m_pos == '@')) {
+                    /* The next record starts, this one is complete */
+                    this->m_state = State::Header;
+                    bool fastq = *this->m_pos == '@';
+                    ++this->m_pos;
+                    bool finished = this->finishRecord(record);
+                    this->m_fastq = fastq;
+                    return finished;
+                }
+                else if(this->m_fastq && *this->m_pos == '+') {
+                    this->m_state = State::Separator;
+                }
+                else {
+                    this->m_state = State::Sequence;
+                }
+                break;
+
+            case State::Sequence:
+                line_end = static_cast<const char*>(std::memchr(this->m_pos, '\n', this->m_end - this->m_pos));
+                this->appendNucleotides(this->m_pos, (line_end ? line_end : this->m_end) - this->m_pos);
+                if(line_end) {
+                    this->m_state = State::LineStart;
+                    line_end += 1;
+                }
+                this->m_pos = line_end ? line_end : this->m_end;
+                break;
+
+            case State::Separator:
+                /* Skip the rest of the line, the '+' line of a FASTQ record or a malformed line */
+                line_end = static_cast<const char*>(std::memchr(this->m_pos, '\n', this->m_end - this->m_pos));
+                if(line_end)
+                    this->m_state = this->m_fastq ? State::Quality : State::Start;
+                this->m_pos = line_end ? line_end + 1 : this->m_end;
+                break;
+
+            case State::Quality:
+                line_end = static_cast<const char*>(std::memchr(this->m_pos, '\n', this->m_end - this->m_pos));
+                for(const char *c = this->m_pos, *stop = line_end ? line_end : this->m_end; c < stop; ++c) {
+                    if(!isLineSpace(*c))
+                        this->m_quality.push_back(*c);
+                }
+                this->m_pos = line_end ? line_end + 1 : this->m_end;
+
+                /* The quality ends at the end of the line where it reaches the sequence length */
+                if(line_end && this->m_quality.size() >= this->m_sequence_length) {
+                    this->m_state = State::Start;
+                    return this->finishQuality(record);
+                }
+                break;
+
+            case State::End:
+                break;
+        }
+    }
+    return false;
+}
+
+
+FastxReader::Iterator FastxReader::begin() {
+    return Iterator(this->next(this->m_record) ? this : nullptr);
+}
+
+
+FastxReader::Iterator FastxReader::end() {
+    return Iterator();
+}
+
+
+/* -- Private -- */
+
+bool FastxReader::fillBuffer() {
+    if(!this->m_stream)
+        return false;
+
+    this->m_stream.read(this->m_buffer.get(), this->m_chunk_size);
+    this->m_pos = this->m_buffer.get();
+    this->m_end = this->m_pos + this->m_stream.gcount();
+    return this->m_pos != this->m_end;
+}
+
+
+/*
+    * Validates and packs the Nucleotides of a sequence line into the record's packed buffer.
+    * The bulk is packed by the vectorized kernels, only the Nucleotides completing a partially
+     filled byte are packed one by one.
+    * A run of ambiguous Nucleotides is packed as 'A' by clearing its bytes, and recorded in m_ambiguous.
+*/
+void FastxReader::appendNucleotides(const char *nucleotides, size_t count) {
+    size_t needed = (this->m_packed_size + count + 3) / 4;
+
+    /* Grow the packed buffer geometrically so a record is copied O(1) times on average */
+    if(needed > this->m_packed_capacity) {
+        size_t capacity = this->m_packed_capacity * 2 > needed ? this->m_packed_capacity * 2 : needed;
+        std::unique_ptr<char[]> packed(new char[capacity]);
+
+        if(this->m_packed_size)
+            std::memcpy(packed.get(), this->m_packed.get(), (this->m_packed_size + 3) / 4);
+        this->m_packed = std::move(packed);
+        this->m_packed_capacity = capacity;
+    }
+
+    unsigned char *packed = reinterpret_cast<unsigned char*>(this->m_packed.get());
+
+    while(count) {
+        /* Fill up the last partially packed byte */
+        while(this->m_packed_size % 4 && count) {
+            int code = nucleotideCode(*nucleotides);
+            char symbol = ambiguityCode(*nucleotides);
+            if(code >= 0) {
+                unsigned shift = 6 - (this->m_packed_size % 4) * 2;
+                packed[this->m_packed_size / 4] |= code << shift;
+                ++this->m_packed_size;
+                ++this->m_sequence_length;
+            }
+            else if(symbol) {
+                /* The rest of the byte is already cleared */
+                appendAmbiguousRun(this->m_ambiguous, {this->m_packed_size, 1, symbol});
+                ++this->m_packed_size;
+                ++this->m_sequence_length;
+            }
+            else if(!isLineSpace(*nucleotides)) {
+                this->setError(FastxError::InvalidNucleotide, this->m_sequence_length, *nucleotides);
+                ++this->m_sequence_length;
+            }
+            ++nucleotides;
+            --count;
+        }
+        if(count == 0)
+            break;
+
+        /* Pack the rest from a byte boundary, on an invalid character pack the valid prefix only */
+        size_t valid = packNucleotides(nucleotides, count, packed + this->m_packed_size / 4);
+        if(valid != count && valid)
+            packNucleotides(nucleotides, valid, packed + this->m_packed_size / 4);
+
+        this->m_packed_size += valid;
+        this->m_sequence_length += valid;
+        nucleotides += valid;
+        count -= valid;
+
+        if(count == 0)
+            break;
+
+        char symbol = ambiguityCode(*nucleotides);
+        if(symbol) {
+            size_t run = 1;
+            while(run < count && ambiguityCode(nucleotides[run]) == symbol)
+                ++run;
+
+            /* The padding of the last packed byte is already cleared, the next bytes of the run are cleared */
+            size_t first = (this->m_packed_size + 3) / 4;
+            std::memset(packed + first, 0, (this->m_packed_size + run + 3) / 4 - first);
+            appendAmbiguousRun(this->m_ambiguous, {this->m_packed_size, run, symbol});
+            this->m_packed_size += run;
+            this->m_sequence_length += run;
+            nucleotides += run;
+            count -= run;
+        }
+        else {
+            if(!isLineSpace(*nucleotides)) {
+                this->setError(FastxError::InvalidNucleotide, this->m_sequence_length, *nucleotides);
+                ++this->m_sequence_length;
+            }
+            ++nucleotides;
+            --count;
+        }
+    }
+}
+
+
+/*
+    * Keeps the first error of the record being read.
+*/
+void FastxReader::setError(FastxError error, size_t offset, char character) {
+    if(this->m_error != FastxError::None)
+        return;
+
+    this->m_error = error;
+    this->m_error_offset = offset;
+    this->m_error_character = character;
+}
+
+
+/*
+    * Finishes a FASTQ record whose quality reached the sequence length, which must not be exceeded.
+*/
+bool FastxReader::finishQuality(FastxRecord &record) {
+    if(this->m_quality.size() != this->m_sequence_length)
+        this->setError(FastxError::ExtraQuality, this->m_sequence_length);
+    return this->finishRecord(record);
+}
+
+
+/*
+    * Moves the record read so far and its error into 'record' and resets the reader for the next one.
+*/
+bool FastxReader::finishRecord(FastxRecord &record) {
+    if(this->m_error != FastxError::None) {
+        record.sequence = DNASequence();
+        this->m_ambiguous.clear();
+    }
+    else {
+        size_t packed_bytes = (this->m_packed_size + 3) / 4;
+
+        /* Give back the unused growth capacity of a sequence that does not fit inline when it is significant */
+        if(packed_bytes > DNASequence::INLINE_BYTES && this->m_packed_capacity - packed_bytes > packed_bytes / 16) {
+            std::unique_ptr<char[]> packed(new char[packed_bytes]);
+            std::memcpy(packed.get(), this->m_packed.get(), packed_bytes);
+            this->m_packed = std::move(packed);
+        }
+        record.sequence.adoptSequence(this->m_packed, this->m_packed_size, this->m_ambiguous);
+    }
+
+    record.name.swap(this->m_name);
+    record.quality.swap(this->m_quality);
+    record.error = this->m_error;
+    record.error_offset = this->m_error_offset;
+    record.error_character = this->m_error_character;
+    this->m_name.clear();
+    this->m_quality.clear();
+
+    /* A sequence copied inline leaves its buffer to the next record */
+    if(!this->m_packed)
+        this->m_packed_capacity = 0;
+    this->m_packed_size = this->m_sequence_length = 0;
+    this->m_error = FastxError::None;
+    this->m_error_offset = 0;
+    this->m_error_character = 0;
+    return true;
+}
+
+
+/* ---------- FastxRecord Methods ---------- */
+
+bool FastxRecord::isValid() const {
+    return this->error == FastxError::None;
+}
+
+
+/* ---------- FastxReader::Iterator Methods ---------- */
+
+FastxReader::Iterator::Iterator(FastxReader *reader) : m_reader(reader) {}
+
+
+FastxReader::Iterator::reference FastxReader::Iterator::operator*() const {
+    return this->m_reader->m_record;
+}
+
+
+FastxReader::Iterator::pointer FastxReader::Iterator::operator->() const {
+    return &this->m_reader->m_record;
+}
+
+
+FastxReader::Iterator& FastxReader::Iterator::operator++() {
+    if(!this->m_reader->next(this->m_reader->m_record))
+        this->m_reader = nullptr;
+    return *this;
+}
+
+
+bool FastxReader::Iterator::operator==(const Iterator &other) const {
+    return this->m_reader == other.m_reader;
+}
+
+
+bool FastxReader::Iterator::operator!=(const Iterator &other) const {
+    return this->m_reader != other.m_reader;
+}
@@ -0,0 +1,144 @@
+#ifndef FASTX_READER
+#define FASTX_READER
+
+#include "dna_sequence.hpp"
+
+#include <fstream>
+#include <istream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class FastxError {
+    None,
+    InvalidNucleotide,
+    TruncatedRecord,
+    ExtraQuality
+};
+
+/*
+    * A FASTA or FASTQ record.
+    * 'name' is the header line without its leading '>' or '@'.
+    * 'quality' is empty for FASTA records.
+    * A malformed record has an empty sequence and the first error found in it:
+        InvalidNucleotide: 'error_offset' is the index of the invalid character in the sequence lines
+                           (line breaks excluded) and 'error_character' that character.
+        TruncatedRecord:   the input ended before the quality had as many values as the sequence,
+                           'error_offset' is the index of the first missing quality value.
+        ExtraQuality:      the quality has more values than the sequence, 'error_offset' is the index
+                           of the first extra value.
+*/
+struct FastxRecord {
+    std::string name;
+    DNASequence sequence;
+    std::string quality;
+    FastxError error = FastxError::None;
+    size_t error_offset = 0;
+    char error_character = 0;
+
+    bool isValid() const;
+};
+
+/*
+    * A streaming FASTA/FASTQ reader.
+    * The input is read in chunks of 'chunk_size' bytes and the bases are validated and packed
+     straight into the record's DNASequence, the ASCII sequence is never held in memory.
+     Memory use is bounded by the chunk size plus the current (packed) record.
+    * Records may be FASTA ('>' header, sequence on one or more lines) or FASTQ ('@' header,
+     sequence lines, a '+' separator line and as many quality characters as bases, on one or more lines).
+     Both kinds may be mixed in a single input, the last line may end without a newline.
+    * Line endings may be "\n" or "\r\n", blank lines are ignored.
+    * N and the IUPAC ambiguity codes are accepted, their runs are recorded while packing (see DNASequence).
+    * A malformed record is returned with its error (see FastxRecord) and nothing is printed,
+     so a hot ingest loop can count or log the bad reads itself.
+*/
+class FastxReader {
+public:
+    class Iterator;
+
+    /* Reads the file at 'path', an error message is printed if it can not be opened. */
+    FastxReader(const std::string &path, size_t chunk_size = 1 << 20);
+
+    /* Reads from 'stream', which must outlive the reader. */
+    FastxReader(std::istream &stream, size_t chunk_size = 1 << 20);
+
+    ~FastxReader();
+
+    /*
+        * Reads the next record into 'record'.
+        * Returns false once there are no more records.
+    */
+    bool next(FastxRecord &record);
+
+    /*
+        * Iterates over the remaining records.
+        * The iterated record is reused for the next record, move out of it what must outlive an increment.
+    */
+    Iterator begin();
+    Iterator end();
+
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = FastxRecord;
+        using difference_type = std::ptrdiff_t;
+        using pointer = FastxRecord*;
+        using reference = FastxRecord&;
+
+        Iterator(FastxReader *reader = nullptr);
+
+        reference operator*() const;
+        pointer operator->() const;
+        Iterator& operator++();
+        bool operator==(const Iterator &other) const;
+        bool operator!=(const Iterator &other) const;
+
+    private:
+        FastxReader *m_reader;
+    };
+
+private:
+    enum class State {
+        Start,
+        Header,
+        LineStart,
+        Sequence,
+        Separator,
+        Quality,
+        End
+    };
+
+    bool fillBuffer();
+    void appendNucleotides(const char *nucleotides, size_t count);
+    void setError(FastxError error, size_t offset, char character = 0);
+    bool finishQuality(FastxRecord &record);
+    bool finishRecord(FastxRecord &record);
+
+    std::ifstream m_file;
+    std::istream &m_stream;
+    std::unique_ptr<char[]> m_buffer;
+    size_t m_chunk_size;
+    const char *m_pos;
+    const char *m_end;
+    State m_state;
+    bool m_fastq;
+
+    /* The record being read, its bases are packed into 'm_packed' as they are parsed */
+    std::string m_name;
+    std::string m_quality;
+    std::unique_ptr<char[]> m_packed;
+    std::vector<AmbiguousRun> m_ambiguous;
+    size_t m_packed_capacity;
+    size_t m_packed_size;
+    size_t m_sequence_length;
+
+    /* The first error of the record being read */
+    FastxError m_error;
+    size_t m_error_offset;
+    char m_error_character;
+
+    FastxRecord m_record;
+};
+
+#endif
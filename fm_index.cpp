@@ -0,0 +1,551 @@
+#include "fm_index.hpp"
+#include "packed_search.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+static const char FM_INDEX_MAGIC[8] = {'D', 'N', 'A', 'F', 'M', 'I', 'X', '1'};
+
+static const size_t BLOCK_ROWS = 256;
+static const size_t SUPERBLOCK_ROWS = 65536;
+static const size_t SAMPLED_RANK_ROWS = 512;
+
+/* ----- Suffix Array Construction (SA-IS) ----- */
+
+/*
+    * Computes the bucket start (end == false) or end (end == true) of every character.
+*/
+template<typename Index>
+static void getBuckets(const Index *text, Index size, Index alphabet, std::vector<Index> &buckets, bool end) {
+    buckets.assign(alphabet, 0);
+    for(Index i = 0; i < size; ++i)
+        ++buckets[text[i]];
+
+    Index sum = 0;
+    for(Index c = 0; c < alphabet; ++c) {
+        sum += buckets[c];
+        buckets[c] = end ? sum : sum - buckets[c];
+    }
+}
+
+
+template<typename Index>
+static void induceSuffixes(const Index *text, Index *sa, Index size, Index alphabet,
+                           const std::vector<bool> &s_type, std::vector<Index> &buckets) {
+    /* L-type suffixes, left to right from the bucket starts */
+    getBuckets(text, size, alphabet, buckets, false);
+    for(Index i = 0; i < size; ++i) {
+        Index j = sa[i] - 1;
+        if(sa[i] > 0 && !s_type[j])
+            sa[buckets[text[j]]++] = j;
+    }
+
+    /* S-type suffixes, right to left from the bucket ends */
+    getBuckets(text, size, alphabet, buckets, true);
+    for(Index i = size - 1; i >= 0; --i) {
+        Index j = sa[i] - 1;
+        if(sa[i] > 0 && s_type[j])
+            sa[--buckets[text[j]]] = j;
+    }
+}
+
+
+/*
+    * Builds the suffix array of 'text' in O(n) (Nong, Zhang and Chan's SA-IS).
+    * The last character of 'text' must be 0 and appear nowhere else, every other
+     character is in [1, alphabet).
+*/
+template<typename Index>
+static void buildSuffixArray(const Index *text, Index *sa, Index size, Index alphabet) {
+    std::vector<bool> s_type(size);
+    std::vector<Index> buckets;
+
+    if(size == 1) {
+        sa[0] = 0;
+        return;
+    }
+
+    auto isLMS = [&](Index i) {
+        return i > 0 && s_type[i] && !s_type[i - 1];
+    };
+
+    s_type[size - 1] = true;
+    for(Index i = size - 2; i >= 0; --i)
+        s_type[i] = text[i] < text[i + 1] || (text[i] == text[i + 1] && s_type[i + 1]);
+
+    /* Sort the LMS substrings by placing them at their bucket ends and inducing */
+    std::fill(sa, sa + size, -1);
+    getBuckets(text, size, alphabet, buckets, true);
+    for(Index i = 1; i < size; ++i) {
+        if(isLMS(i))
+            sa[--buckets[text[i]]] = i;
+    }
+    induceSuffixes(text, sa, size, alphabet, s_type, buckets);
+
+    /* Compact the sorted LMS substrings and name them */
+    Index lms_count = 0;
+    for(Index i = 0; i < size; ++i) {
+        if(isLMS(sa[i]))
+            sa[lms_count++] = sa[i];
+    }
+    std::fill(sa + lms_count, sa + size, -1);
+
+    Index names = 0;
+    Index previous = -1;
+    for(Index i = 0; i < lms_count; ++i) {
+        Index position = sa[i];
+        bool different = false;
+
+        for(Index d = 0; ; ++d) {
+            if(previous == -1 || text[position + d] != text[previous + d] ||
+               s_type[position + d] != s_type[previous + d]) {
+                different = true;
+                break;
+            }
+            if(d > 0 && (isLMS(position + d) || isLMS(previous + d)))
+                break;
+        }
+        if(different) {
+            ++names;
+            previous = position;
+        }
+        sa[lms_count + position / 2] = names - 1;
+    }
+    for(Index i = size - 1, j = size - 1; i >= lms_count; --i) {
+        if(sa[i] >= 0)
+            sa[j--] = sa[i];
+    }
+
+    /* Sort the LMS suffixes, recursively if some LMS substrings share a name */
+    Index *reduced_text = sa + size - lms_count;
+    Index *reduced_sa = sa;
+    if(names < lms_count) {
+        buildSuffixArray(reduced_text, reduced_sa, lms_count, names);
+    }
+    else {
+        for(Index i = 0; i < lms_count; ++i)
+            reduced_sa[reduced_text[i]] = i;
+    }
+
+    /* Induce the suffix array from the sorted LMS suffixes */
+    for(Index i = 1, j = 0; i < size; ++i) {
+        if(isLMS(i))
+            reduced_text[j++] = i;
+    }
+    for(Index i = 0; i < lms_count; ++i)
+        reduced_sa[i] = reduced_text[reduced_sa[i]];
+    std::fill(sa + lms_count, sa + size, -1);
+
+    getBuckets(text, size, alphabet, buckets, true);
+    for(Index i = lms_count - 1; i >= 0; --i) {
+        Index j = sa[i];
+        sa[i] = -1;
+        sa[--buckets[text[j]]] = j;
+    }
+    induceSuffixes(text, sa, size, alphabet, s_type, buckets);
+}
+
+
+/*
+    * Returns the suffix array of the sequence followed by a sentinel smaller than every Nucleotide.
+*/
+template<typename Index>
+static std::vector<Index> sequenceSuffixArray(const unsigned char *packed, size_t size) {
+    std::vector<Index> text(size + 1);
+    std::vector<Index> sa(size + 1);
+
+    for(size_t i = 0; i < size; ++i)
+        text[i] = ((packed[i / 4] >> (6 - (i % 4) * 2)) & 0b11) + 1;
+    text[size] = 0;
+
+    buildSuffixArray<Index>(text.data(), sa.data(), size + 1, 5);
+    return sa;
+}
+
+
+/* ----- FM-Index Utility Functions ----- */
+
+template<typename T>
+static void writeVector(std::ofstream &file, const std::vector<T> &values) {
+    uint64_t size = values.size();
+    file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+
+/*
+    * Reads a vector written by writeVector.
+    * Returns false if the file ends before it, a corrupt size larger than the rest of the file
+     is rejected before anything is allocated.
+*/
+template<typename T>
+static bool readVector(std::ifstream &file, std::vector<T> &values) {
+    uint64_t size;
+    if(!file.read(reinterpret_cast<char*>(&size), sizeof(size)))
+        return false;
+
+    std::streampos position = file.tellg();
+    if(!file.seekg(0, std::ios::end))
+        return false;
+    uint64_t remaining = uint64_t(file.tellg() - position);
+    if(!file.seekg(position) || size > remaining / sizeof(T))
+        return false;
+
+    values.resize(size);
+    return bool(file.read(reinterpret_cast<char*>(values.data()), size * sizeof(T)));
+}
+
+
+/* ---------- FMIndex Methods ---------- */
+
+FMIndex::FMIndex() {
+    this->m_size = 0;
+    this->m_sa_sample_rate = 1;
+    this->m_sentinel_row = 0;
+    std::memset(this->m_first_row, 0, sizeof(this->m_first_row));
+}
+
+
+FMIndex::FMIndex(const DNASequence &sequence, size_t sa_sample_rate) : FMIndex() {
+    /* The ambiguous Nucleotides are packed as 'A', indexing them would match them as 'A' */
+    if(sequence.hasAmbiguousNucleotides()) {
+        printf("FMIndex Error: the sequence has ambiguous Nucleotides, which can not be indexed!\n");
+        return;
+    }
+
+    const unsigned char *packed = sequence.getPackedSequence();
+    const size_t size = sequence.getSize();
+    const size_t rows = size + 1;
+    uint64_t counts[4] = {0, 0, 0, 0};
+
+    this->m_size = size;
+    this->m_sa_sample_rate = sa_sample_rate ? sa_sample_rate : 1;
+    this->m_sentinel_row = 0;
+    this->m_bwt.assign((rows + 31) / 32, 0);
+    this->m_sampled_rows.assign((rows + 63) / 64, 0);
+
+    /* BWT and suffix array sample, 32-bit suffix array entries are used whenever they are enough */
+    auto sampleSuffixArray = [&](const auto &suffix_array) {
+        for(size_t row = 0; row < rows; ++row) {
+            uint64_t position = suffix_array[row];
+
+            if(position == 0) {
+                this->m_sentinel_row = row;
+            }
+            else {
+                uint64_t code = (packed[(position - 1) / 4] >> (6 - ((position - 1) % 4) * 2)) & 0b11;
+                this->m_bwt[row / 32] |= code << (62 - (row % 32) * 2);
+                ++counts[code];
+            }
+
+            if(position % this->m_sa_sample_rate == 0) {
+                this->m_sampled_rows[row / 64] |= uint64_t(1) << (row % 64);
+                this->m_samples.push_back(position);
+            }
+        }
+    };
+
+    if(rows < (size_t)std::numeric_limits<int32_t>::max())
+        sampleSuffixArray(sequenceSuffixArray<int32_t>(packed, size));
+    else
+        sampleSuffixArray(sequenceSuffixArray<int64_t>(packed, size));
+
+    this->m_first_row[0] = 1;
+    for(int code = 0; code < 4; ++code)
+        this->m_first_row[code + 1] = this->m_first_row[code] + counts[code];
+
+    /* Rank directory over the BWT, the sentinel is counted as an 'A' here and corrected in rank */
+    uint64_t totals[4] = {0, 0, 0, 0};
+    uint64_t superblock[4] = {0, 0, 0, 0};
+
+    for(size_t row = 0; row <= rows; row += BLOCK_ROWS) {
+        if(row % SUPERBLOCK_ROWS == 0) {
+            for(int code = 0; code < 4; ++code) {
+                superblock[code] = totals[code];
+                this->m_superblock_ranks.push_back(totals[code]);
+            }
+        }
+        for(int code = 0; code < 4; ++code)
+            this->m_block_ranks.push_back(totals[code] - superblock[code]);
+
+        for(size_t word = row / 32; word < (row + BLOCK_ROWS) / 32 && word < this->m_bwt.size(); ++word) {
+            size_t count = rows - word * 32 < 32 ? rows - word * 32 : 32;
+            for(int code = 0; code < 4; ++code)
+                totals[code] += countPackedCode(this->m_bwt[word], code, count);
+        }
+    }
+
+    uint64_t sampled = 0;
+    for(size_t word = 0; word < this->m_sampled_rows.size(); ++word) {
+        if(word % (SAMPLED_RANK_ROWS / 64) == 0)
+            this->m_sampled_ranks.push_back(sampled);
+        sampled += __builtin_popcountll(this->m_sampled_rows[word]);
+    }
+    this->m_sampled_ranks.push_back(sampled);
+}
+
+
+size_t FMIndex::countSubsequence(const char* subsequence, size_t size) const {
+    std::vector<uint8_t> codes;
+    if(!this->encode(subsequence, size, codes))
+        return 0;
+
+    RowRange range = this->backwardSearch(codes);
+    return range.last - range.first;
+}
+
+
+size_t FMIndex::countSubsequence(const std::string &subsequence) const {
+    return this->countSubsequence(&subsequence[0], subsequence.size());
+}
+
+
+size_t FMIndex::countSubsequence(const DNASequence &subsequence) const {
+    std::vector<uint8_t> codes;
+    if(!this->encode(subsequence, codes))
+        return 0;
+
+    RowRange range = this->backwardSearch(codes);
+    return range.last - range.first;
+}
+
+
+std::vector<size_t> FMIndex::findSubsequence(const char* subsequence, size_t size) const {
+    std::vector<uint8_t> codes;
+    if(!this->encode(subsequence, size, codes))
+        return std::vector<size_t>();
+
+    return this->locate(this->backwardSearch(codes));
+}
+
+
+std::vector<size_t> FMIndex::findSubsequence(const std::string &subsequence) const {
+    return this->findSubsequence(&subsequence[0], subsequence.size());
+}
+
+
+std::vector<size_t> FMIndex::findSubsequence(const DNASequence &subsequence) const {
+    std::vector<uint8_t> codes;
+    if(!this->encode(subsequence, codes))
+        return std::vector<size_t>();
+
+    return this->locate(this->backwardSearch(codes));
+}
+
+
+bool FMIndex::hasSubsequence(const std::string &subsequence) const {
+    return this->countSubsequence(subsequence) != 0;
+}
+
+
+bool FMIndex::hasSubsequence(const char* subsequence, size_t size) const {
+    return this->countSubsequence(subsequence, size) != 0;
+}
+
+
+bool FMIndex::hasSubsequence(const DNASequence &subsequence) const {
+    return this->countSubsequence(subsequence) != 0;
+}
+
+
+bool FMIndex::save(const std::string &path) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    uint64_t fields[3] = {this->m_size, this->m_sa_sample_rate, this->m_sentinel_row};
+
+    file.write(FM_INDEX_MAGIC, sizeof(FM_INDEX_MAGIC));
+    file.write(reinterpret_cast<const char*>(fields), sizeof(fields));
+    file.write(reinterpret_cast<const char*>(this->m_first_row), sizeof(this->m_first_row));
+    writeVector(file, this->m_bwt);
+    writeVector(file, this->m_superblock_ranks);
+    writeVector(file, this->m_block_ranks);
+    writeVector(file, this->m_sampled_rows);
+    writeVector(file, this->m_sampled_ranks);
+    writeVector(file, this->m_samples);
+
+    if(!file) {
+        printf("FMIndex Error: could not write '%s'!\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+
+bool FMIndex::load(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(FM_INDEX_MAGIC)];
+    uint64_t fields[3];
+
+    *this = FMIndex();
+
+    bool valid = file.read(magic, sizeof(magic)) &&
+                 std::memcmp(magic, FM_INDEX_MAGIC, sizeof(magic)) == 0 &&
+                 file.read(reinterpret_cast<char*>(fields), sizeof(fields)) &&
+                 file.read(reinterpret_cast<char*>(this->m_first_row), sizeof(this->m_first_row)) &&
+                 readVector(file, this->m_bwt) &&
+                 readVector(file, this->m_superblock_ranks) &&
+                 readVector(file, this->m_block_ranks) &&
+                 readVector(file, this->m_sampled_rows) &&
+                 readVector(file, this->m_sampled_ranks) &&
+                 readVector(file, this->m_samples);
+
+    /* Make sure the directories cover every row before trusting them */
+    if(valid) {
+        uint64_t rows = fields[0] + 1;
+        valid = fields[1] != 0 && fields[2] < rows &&
+                this->m_bwt.size() == (rows + 31) / 32 &&
+                this->m_superblock_ranks.size() == (rows / SUPERBLOCK_ROWS + 1) * 4 &&
+                this->m_block_ranks.size() == (rows / BLOCK_ROWS + 1) * 4 &&
+                this->m_sampled_rows.size() == (rows + 63) / 64 &&
+                this->m_sampled_ranks.size() == (this->m_sampled_rows.size() + 7) / 8 + 1 &&
+                this->m_first_row[4] == rows;
+    }
+
+    /* locate reads m_samples at the rank of a sampled row, the ranks and the samples must match the rows */
+    if(valid) {
+        uint64_t sampled = 0;
+        for(size_t word = 0; valid && word < this->m_sampled_rows.size(); ++word) {
+            if(word % (SAMPLED_RANK_ROWS / 64) == 0)
+                valid = this->m_sampled_ranks[word / (SAMPLED_RANK_ROWS / 64)] == sampled;
+            sampled += __builtin_popcountll(this->m_sampled_rows[word]);
+        }
+        valid = valid && this->m_sampled_ranks.back() == sampled && this->m_samples.size() == sampled;
+    }
+
+    if(!valid) {
+        printf("FMIndex Error: '%s' is not a valid FM-index file!\n", path.c_str());
+        *this = FMIndex();
+        return false;
+    }
+
+    this->m_size = fields[0];
+    this->m_sa_sample_rate = fields[1];
+    this->m_sentinel_row = fields[2];
+    return true;
+}
+
+
+/* -- Getters -- */
+
+size_t FMIndex::getSize() const {
+    return this->m_size;
+}
+
+
+size_t FMIndex::getSASampleRate() const {
+    return this->m_sa_sample_rate;
+}
+
+
+/* -- Private -- */
+
+FMIndex::RowRange FMIndex::backwardSearch(const std::vector<uint8_t> &codes) const {
+    RowRange range = {0, this->m_bwt.empty() ? 0 : this->m_size + 1};
+
+    for(size_t i = codes.size(); i-- > 0 && range.first < range.last;) {
+        uint8_t code = codes[i];
+        range.first = this->m_first_row[code] + this->rank(code, range.first);
+        range.last = this->m_first_row[code] + this->rank(code, range.last);
+    }
+    if(range.first > range.last)
+        range.last = range.first;
+    return range;
+}
+
+
+/*
+    * Walks every row of the range back to a sampled row, the distance walked is added to the sample.
+*/
+std::vector<size_t> FMIndex::locate(const RowRange &range) const {
+    std::vector<size_t> positions;
+    positions.reserve(range.last - range.first);
+
+    for(size_t row = range.first; row < range.last; ++row) {
+        size_t current = row;
+        size_t steps = 0;
+
+        while(!this->isSampled(current)) {
+            current = this->lastToFirst(current);
+            ++steps;
+        }
+        positions.push_back(this->m_samples[this->sampleIndex(current)] + steps);
+    }
+
+    std::sort(positions.begin(), positions.end());
+    return positions;
+}
+
+
+bool FMIndex::encode(const char *subsequence, size_t size, std::vector<uint8_t> &codes) const {
+    codes.resize(size);
+    for(size_t i = 0; i < size; ++i) {
+        int code = nucleotideCode(subsequence[i]);
+        if(code < 0)
+            return false;
+        codes[i] = code;
+    }
+    return true;
+}
+
+
+bool FMIndex::encode(const DNASequence &subsequence, std::vector<uint8_t> &codes) const {
+    const unsigned char *packed = subsequence.getPackedSequence();
+
+    codes.resize(subsequence.getSize());
+    for(size_t i = 0; i < codes.size(); ++i)
+        codes[i] = (packed[i / 4] >> (6 - (i % 4) * 2)) & 0b11;
+    return !subsequence.hasAmbiguousNucleotides();
+}
+
+
+uint8_t FMIndex::bwtCode(size_t row) const {
+    return (this->m_bwt[row / 32] >> (62 - (row % 32) * 2)) & 0b11;
+}
+
+
+/*
+    * Returns the number of times 'code' occurs in the BWT rows [0, row).
+*/
+size_t FMIndex::rank(uint8_t code, size_t row) const {
+    size_t block = row / BLOCK_ROWS;
+    size_t count = this->m_superblock_ranks[row / SUPERBLOCK_ROWS * 4 + code] + this->m_block_ranks[block * 4 + code];
+
+    size_t word = block * (BLOCK_ROWS / 32);
+    for(; word < row / 32; ++word)
+        count += countPackedCode(this->m_bwt[word], code, 32);
+    if(row % 32)
+        count += countPackedCode(this->m_bwt[word], code, row % 32);
+
+    /* The sentinel is stored as an 'A' */
+    if(code == 0 && this->m_sentinel_row < row)
+        --count;
+    return count;
+}
+
+
+size_t FMIndex::lastToFirst(size_t row) const {
+    uint8_t code = this->bwtCode(row);
+    return this->m_first_row[code] + this->rank(code, row);
+}
+
+
+bool FMIndex::isSampled(size_t row) const {
+    return (this->m_sampled_rows[row / 64] >> (row % 64)) & 1;
+}
+
+
+/*
+    * Returns the index in m_samples of a sampled row (the number of sampled rows before it).
+*/
+size_t FMIndex::sampleIndex(size_t row) const {
+    size_t count = this->m_sampled_ranks[row / SAMPLED_RANK_ROWS];
+    size_t word = row / SAMPLED_RANK_ROWS * (SAMPLED_RANK_ROWS / 64);
+
+    for(; word < row / 64; ++word)
+        count += __builtin_popcountll(this->m_sampled_rows[word]);
+    if(row % 64)
+        count += __builtin_popcountll(this->m_sampled_rows[word] & ((uint64_t(1) << (row % 64)) - 1));
+    return count;
+}
@@ -0,0 +1,108 @@
+#ifndef FM_INDEX
+#define FM_INDEX
+
+#include "dna_sequence.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+    * An FM-index over a DNASequence, built once and queried many times.
+    * The index holds the Burrows-Wheeler transform of the sequence packed 2 bits per Nucleotide,
+     a rank directory over it and a sample of the suffix array.
+    * Counting the occurrences of a subsequence of length m takes O(m) rank queries,
+     locating them takes O(m + occ * sa_sample_rate) steps.
+    * The rank directory stores 4 counts per 256 Nucleotides (about 12.5% of the packed BWT),
+     the suffix array sample stores one position every 'sa_sample_rate' Nucleotides.
+    * Subsequences follow the rules of DNASequence: an invalid Nucleotide value matches nowhere and
+     an empty subsequence matches at every index from 0 to the sequence size.
+    * The index only holds the packed Nucleotides: a sequence with ambiguous Nucleotides can not be indexed,
+     a subsequence with ambiguous Nucleotides matches nowhere.
+*/
+class FMIndex {
+public:
+    /* Create an empty index. */
+    FMIndex();
+
+    /*
+        * Builds the index of 'sequence' with a suffix array sample every 'sa_sample_rate' Nucleotides.
+        * The suffix array is built with SA-IS in O(n) time.
+        * If the sequence has ambiguous Nucleotides an error message is printed and the index is left empty.
+    */
+    FMIndex(const DNASequence &sequence, size_t sa_sample_rate = 32);
+
+    /*
+        * Returns the number of times a subsequence occurs in the indexed sequence.
+    */
+    size_t countSubsequence(const std::string &subsequence) const;
+    size_t countSubsequence(const char* subsequence, size_t size) const;
+    size_t countSubsequence(const DNASequence &subsequence) const;
+
+    /*
+        * Returns the starting indexes of every occurrence of a subsequence, in ascending order.
+    */
+    std::vector<size_t> findSubsequence(const std::string &subsequence) const;
+    std::vector<size_t> findSubsequence(const char* subsequence, size_t size) const;
+    std::vector<size_t> findSubsequence(const DNASequence &subsequence) const;
+
+    /*
+        * Returns True if the indexed sequence contains the passed subsequence.
+    */
+    bool hasSubsequence(const std::string &subsequence) const;
+    bool hasSubsequence(const char* subsequence, size_t size) const;
+    bool hasSubsequence(const DNASequence &subsequence) const;
+
+    /*
+        * Writes the index to 'path' / replaces the index with the one stored at 'path'.
+        * Returns false and prints an error message on failure, a failed load leaves the index empty.
+    */
+    bool save(const std::string &path) const;
+    bool load(const std::string &path);
+
+    /* Getters */
+    size_t getSize() const;
+    size_t getSASampleRate() const;
+
+private:
+    /* The range of BWT rows prefixed by the subsequence, [first, last) */
+    struct RowRange {
+        size_t first;
+        size_t last;
+    };
+
+    RowRange backwardSearch(const std::vector<uint8_t> &codes) const;
+    std::vector<size_t> locate(const RowRange &range) const;
+    bool encode(const char *subsequence, size_t size, std::vector<uint8_t> &codes) const;
+    bool encode(const DNASequence &subsequence, std::vector<uint8_t> &codes) const;
+
+    uint8_t bwtCode(size_t row) const;
+    size_t rank(uint8_t code, size_t row) const;
+    size_t lastToFirst(size_t row) const;
+    bool isSampled(size_t row) const;
+    size_t sampleIndex(size_t row) const;
+
+    /* Length of the indexed sequence, the BWT has m_size + 1 rows (one for the sentinel) */
+    size_t m_size;
+    size_t m_sa_sample_rate;
+
+    /* Row of the BWT holding the sentinel, it is stored as an 'A' and corrected in rank */
+    size_t m_sentinel_row;
+
+    /* m_first_row[c] is the first row of the suffixes starting with Nucleotide code 'c' */
+    uint64_t m_first_row[5];
+
+    /* BWT packed 32 Nucleotides per word, the first Nucleotide in the highest bits */
+    std::vector<uint64_t> m_bwt;
+
+    /* Rank directory: absolute counts every 65536 rows, relative counts every 256 rows */
+    std::vector<uint64_t> m_superblock_ranks;
+    std::vector<uint16_t> m_block_ranks;
+
+    /* Rows whose suffix array value is sampled, with cumulative counts every 512 rows */
+    std::vector<uint64_t> m_sampled_rows;
+    std::vector<uint64_t> m_sampled_ranks;
+    std::vector<uint64_t> m_samples;
+};
+
+#endif
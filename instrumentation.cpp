@@ -0,0 +1,235 @@
+#include "instrumentation.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/* The counters kept per operation, in the order of OperationCounters */
+enum CounterField {
+    CALLS,
+    BYTES,
+    ALLOCATIONS,
+    ALLOCATED_BYTES,
+    TICKS,
+    COUNTER_FIELDS
+};
+
+/*
+    * The counters of one thread, only written by the thread owning it.
+    * They are atomics so a snapshot can read them while they are updated, the owner updates them
+     with plain relaxed loads and stores.
+*/
+struct ThreadCounters {
+    std::atomic<uint64_t> counters[INSTRUMENTED_OPERATION_COUNT][COUNTER_FIELDS] = {};
+    std::atomic<bool> in_use{false};
+    ThreadCounters *next = nullptr;
+};
+
+/* Every ThreadCounters ever created, they are never freed and are reused once their thread ends */
+static std::atomic<ThreadCounters*> thread_counters_head{nullptr};
+
+/* ----- Instrumentation Utility Functions ----- */
+
+/*
+    * Takes a free slot of the list, or pushes a new one.
+*/
+static ThreadCounters* acquireThreadCounters() {
+    for(ThreadCounters *counters = thread_counters_head.load(std::memory_order_acquire); counters; counters = counters->next) {
+        bool expected = false;
+        if(!counters->in_use.load(std::memory_order_relaxed) &&
+           counters->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire))
+            return counters;
+    }
+
+    ThreadCounters *counters = new ThreadCounters();
+    counters->in_use.store(true, std::memory_order_relaxed);
+    counters->next = thread_counters_head.load(std::memory_order_relaxed);
+    while(!thread_counters_head.compare_exchange_weak(counters->next, counters, std::memory_order_release,
+                                                      std::memory_order_relaxed));
+    return counters;
+}
+
+
+/* Owns the slot of the thread, it is given back when the thread ends */
+struct ThreadCountersSlot {
+    ThreadCounters *counters = acquireThreadCounters();
+
+    ~ThreadCountersSlot() {
+        this->counters->in_use.store(false, std::memory_order_release);
+    }
+};
+
+static thread_local ThreadCountersSlot thread_slot;
+static thread_local InstrumentedOperation current_operation = InstrumentedOperation::Other;
+
+
+static inline void addCounter(InstrumentedOperation operation, CounterField field, uint64_t value) {
+    std::atomic<uint64_t> &counter = thread_slot.counters->counters[size_t(operation)][field];
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+
+static inline uint64_t readTicks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+
+bool isInstrumentationEnabled() {
+#ifdef DNA_SEQUENCE_INSTRUMENTATION
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+const char* instrumentedOperationName(InstrumentedOperation operation) {
+    switch(operation) {
+        case InstrumentedOperation::Construct: return "construct";
+        case InstrumentedOperation::Parse: return "parse";
+        case InstrumentedOperation::FillSequence: return "fill_sequence";
+        case InstrumentedOperation::Match: return "match";
+        case InstrumentedOperation::Find: return "find";
+        case InstrumentedOperation::Count: return "count";
+        case InstrumentedOperation::FindParallel: return "find_parallel";
+        case InstrumentedOperation::CountParallel: return "count_parallel";
+        case InstrumentedOperation::FindApproximate: return "find_approximate";
+        case InstrumentedOperation::Slice: return "slice";
+        case InstrumentedOperation::GetSequenceStr: return "get_sequence_str";
+        case InstrumentedOperation::GetSequenceCStr: return "get_sequence_cstr";
+        case InstrumentedOperation::Decode: return "decode";
+        default: return "other";
+    }
+}
+
+
+InstrumentationSnapshot instrumentationSnapshot() {
+    InstrumentationSnapshot snapshot;
+
+    for(ThreadCounters *counters = thread_counters_head.load(std::memory_order_acquire); counters; counters = counters->next) {
+        for(size_t operation = 0; operation < INSTRUMENTED_OPERATION_COUNT; ++operation) {
+            std::atomic<uint64_t> *fields = counters->counters[operation];
+            OperationCounters &sum = snapshot.operations[operation];
+
+            sum.calls += fields[CALLS].load(std::memory_order_relaxed);
+            sum.bytes += fields[BYTES].load(std::memory_order_relaxed);
+            sum.allocations += fields[ALLOCATIONS].load(std::memory_order_relaxed);
+            sum.allocated_bytes += fields[ALLOCATED_BYTES].load(std::memory_order_relaxed);
+            sum.ticks += fields[TICKS].load(std::memory_order_relaxed);
+        }
+    }
+    return snapshot;
+}
+
+
+void resetInstrumentation() {
+    for(ThreadCounters *counters = thread_counters_head.load(std::memory_order_acquire); counters; counters = counters->next) {
+        for(size_t operation = 0; operation < INSTRUMENTED_OPERATION_COUNT; ++operation) {
+            for(size_t field = 0; field < COUNTER_FIELDS; ++field)
+                counters->counters[operation][field].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+
+std::string formatPrometheusMetrics(const InstrumentationSnapshot &snapshot) {
+    static const struct {
+        const char *name;
+        const char *help;
+        uint64_t OperationCounters::*field;
+    } families[] = {
+        {"dna_sequence_operation_calls_total", "Number of calls of the operation.", &OperationCounters::calls},
+        {"dna_sequence_operation_bytes_total", "Bytes processed by the operation.", &OperationCounters::bytes},
+        {"dna_sequence_operation_allocations_total", "Heap allocations made by the operation.",
+         &OperationCounters::allocations},
+        {"dna_sequence_operation_allocated_bytes_total", "Bytes allocated on the heap by the operation.",
+         &OperationCounters::allocated_bytes},
+        {"dna_sequence_operation_ticks_total", "Time spent in the operation, in timestamp counter ticks.",
+         &OperationCounters::ticks},
+    };
+    std::string metrics;
+
+    metrics += "# HELP dna_sequence_instrumentation_enabled 1 if the library was built with the instrumentation.\n";
+    metrics += "# TYPE dna_sequence_instrumentation_enabled gauge\n";
+    metrics += "dna_sequence_instrumentation_enabled ";
+    metrics += isInstrumentationEnabled() ? "1\n" : "0\n";
+
+    for(const auto &family : families) {
+        metrics += std::string("# HELP ") + family.name + " " + family.help + "\n";
+        metrics += std::string("# TYPE ") + family.name + " counter\n";
+
+        for(size_t operation = 0; operation < INSTRUMENTED_OPERATION_COUNT; ++operation) {
+            metrics += family.name;
+            metrics += "{operation=\"";
+            metrics += instrumentedOperationName(InstrumentedOperation(operation));
+            metrics += "\"} ";
+            metrics += std::to_string(snapshot.operations[operation].*family.field);
+            metrics += "\n";
+        }
+    }
+    return metrics;
+}
+
+
+bool writePrometheusMetrics(const std::string &path) {
+    std::string metrics = formatPrometheusMetrics(instrumentationSnapshot());
+    std::string temporary_path = path + ".tmp";
+
+    {
+        std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+        file.write(metrics.data(), metrics.size());
+        if(!file) {
+            printf("Instrumentation Error: could not write '%s'!\n", temporary_path.c_str());
+            return false;
+        }
+    }
+
+    if(std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+        printf("Instrumentation Error: could not replace '%s'!\n", path.c_str());
+        std::remove(temporary_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+
+void recordAllocation(uint64_t bytes) {
+    addCounter(current_operation, ALLOCATIONS, 1);
+    addCounter(current_operation, ALLOCATED_BYTES, bytes);
+}
+
+
+/* ---------- InstrumentationSnapshot Methods ---------- */
+
+const OperationCounters& InstrumentationSnapshot::operator[](InstrumentedOperation operation) const {
+    return this->operations[size_t(operation)];
+}
+
+
+/* ---------- InstrumentationScope Methods ---------- */
+
+InstrumentationScope::InstrumentationScope(InstrumentedOperation operation, uint64_t bytes) {
+    this->m_operation = operation;
+    this->m_parent = current_operation;
+    current_operation = operation;
+
+    addCounter(operation, CALLS, 1);
+    addCounter(operation, BYTES, bytes);
+    this->m_start = readTicks();
+}
+
+
+InstrumentationScope::~InstrumentationScope() {
+    addCounter(this->m_operation, TICKS, readTicks() - this->m_start);
+    current_operation = this->m_parent;
+}
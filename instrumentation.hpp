@@ -0,0 +1,122 @@
+#ifndef INSTRUMENTATION
+#define INSTRUMENTATION
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+    * Opt-in counters of the DNASequence hot paths: calls, bytes processed, heap allocations and timer ticks
+     per operation.
+    * The counters are only updated when the library is compiled with DNA_SEQUENCE_INSTRUMENTATION defined
+     (the DNA_SEQUENCE_ENABLE_INSTRUMENTATION CMake option), otherwise the DNA_INSTRUMENT macros expand to
+     nothing and the snapshot is always zero.
+    * Every thread updates its own counters, without atomic read-modify-writes nor locks. The per-thread
+     counters are linked in a lock-free list that a snapshot walks, the counters of a finished thread are
+     kept and its slot is reused by the next thread.
+    * The bytes processed are the characters read or written for the parsing and export operations,
+     and the packed bytes scanned or copied for the searches and slices.
+    * The ticks are CPU timestamp counter cycles on x86 (rdtsc) and steady clock nanoseconds elsewhere,
+     an operation nested in another one (fillSequence in a constructor...) is counted in both.
+*/
+enum class InstrumentedOperation {
+    Construct,
+    Parse,
+    FillSequence,
+    Match,
+    Find,
+    Count,
+    FindParallel,
+    CountParallel,
+    FindApproximate,
+    Slice,
+    GetSequenceStr,
+    GetSequenceCStr,
+    Decode,
+    Other
+};
+
+static const size_t INSTRUMENTED_OPERATION_COUNT = size_t(InstrumentedOperation::Other) + 1;
+
+struct OperationCounters {
+    uint64_t calls = 0;
+    uint64_t bytes = 0;
+    uint64_t allocations = 0;
+    uint64_t allocated_bytes = 0;
+    uint64_t ticks = 0;
+};
+
+/*
+    * The counters of every operation summed over all the threads, indexed by InstrumentedOperation.
+*/
+struct InstrumentationSnapshot {
+    std::array<OperationCounters, INSTRUMENTED_OPERATION_COUNT> operations;
+
+    const OperationCounters& operator[](InstrumentedOperation operation) const;
+};
+
+/* Returns true if the library was compiled with the instrumentation. */
+bool isInstrumentationEnabled();
+
+/* The name of an operation, as used in the Prometheus labels ("find", "get_sequence_str"...) */
+const char* instrumentedOperationName(InstrumentedOperation operation);
+
+/*
+    * Sums the counters of every thread. The threads keep counting meanwhile, so the snapshot may
+     miss their very last updates but never sees a torn value.
+*/
+InstrumentationSnapshot instrumentationSnapshot();
+
+/*
+    * Sets every counter back to zero.
+    * It is exact only when no instrumented operation runs concurrently, an update racing with it may be lost.
+*/
+void resetInstrumentation();
+
+/*
+    * Formats the snapshot in the Prometheus text exposition format, one counter family per field:
+     dna_sequence_operation_calls_total{operation="find"} 12 ...
+*/
+std::string formatPrometheusMetrics(const InstrumentationSnapshot &snapshot);
+
+/*
+    * Writes the current counters in the Prometheus text format to 'path' (for the node exporter textfile
+     collector), through a temporary file renamed over it so a reader never sees a partial file.
+    * Returns false and prints an error message if the file could not be written.
+*/
+bool writePrometheusMetrics(const std::string &path);
+
+/*
+    * Counts a call of 'operation' processing 'bytes' bytes, and times it until the scope ends.
+    * The heap allocations recorded meanwhile by recordAllocation are counted for the innermost scope.
+*/
+class InstrumentationScope {
+public:
+    InstrumentationScope(InstrumentedOperation operation, uint64_t bytes);
+    ~InstrumentationScope();
+
+    InstrumentationScope(const InstrumentationScope&) = delete;
+    InstrumentationScope& operator=(const InstrumentationScope&) = delete;
+
+private:
+    InstrumentedOperation m_operation;
+    InstrumentedOperation m_parent;
+    uint64_t m_start;
+};
+
+/* Counts a heap allocation of 'bytes' bytes for the innermost instrumented operation of the thread. */
+void recordAllocation(uint64_t bytes);
+
+#ifdef DNA_SEQUENCE_INSTRUMENTATION
+#define DNA_INSTRUMENT_CONCAT_(a, b) a##b
+#define DNA_INSTRUMENT_CONCAT(a, b) DNA_INSTRUMENT_CONCAT_(a, b)
+#define DNA_INSTRUMENT(operation, bytes) \
+    InstrumentationScope DNA_INSTRUMENT_CONCAT(instrumentation_scope_, __LINE__)(InstrumentedOperation::operation, (bytes))
+#define DNA_INSTRUMENT_ALLOCATION(bytes) recordAllocation(bytes)
+#else
+#define DNA_INSTRUMENT(operation, bytes) ((void)0)
+#define DNA_INSTRUMENT_ALLOCATION(bytes) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,383 @@
+#include "kmer.hpp"
+#include "packed_search.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <mutex>
+
+/* The hash table is split in 2^KMER_SHARD_BITS shards, selected by the highest bits of the hash */
+static const unsigned KMER_SHARD_BITS = 6;
+static const size_t KMER_SHARDS = size_t(1) << KMER_SHARD_BITS;
+static const size_t KMER_SHARD_INITIAL_SLOTS = 1024;
+
+/* k-mer starting indexes per task and k-mers per shard batch of the parallel counting */
+static const size_t KMER_PARALLEL_CHUNK = 1 << 20;
+static const size_t KMER_PARALLEL_BATCH = 1024;
+
+/* ---------- KmerIterator Methods ---------- */
+
+KmerIterator::KmerIterator(const DNASequence &sequence, size_t k, size_t start, size_t end)
+    : KmerIterator(DNASequenceView(sequence), k, start, end) {}
+
+
+KmerIterator::KmerIterator(const DNASequenceView &view, size_t k, size_t start, size_t end) {
+    size_t size = view.getSize();
+
+    this->m_sequence = view.getPackedSequence();
+    this->m_offset = view.getOffset();
+    this->m_size = this->m_offset + size;
+    this->m_k = k;
+    this->m_started = false;
+    this->m_buffer = 0;
+    this->m_buffered = 0;
+
+    /* Only the k-mers that fit in the view */
+    if(k == 0 || k > size)
+        end = 0;
+    else if(end > size - k + 1)
+        end = size - k + 1;
+    this->m_index = this->m_offset + start;
+    this->m_loaded = this->m_index;
+    this->m_end = this->m_offset + end;
+
+    size_t top_nucleotides = k % 32 ? k % 32 : 32;
+    this->m_words = k ? (k + 31) / 32 : 1;
+    this->m_top_mask = top_nucleotides == 32 ? ~uint64_t(0) : (uint64_t(1) << (top_nucleotides * 2)) - 1;
+    this->m_kmer_inline = {};
+    this->m_reverse_inline = {};
+    if(this->m_words > INLINE_WORDS)
+        this->m_heap = std::unique_ptr<uint64_t[]>(new uint64_t[this->m_words * 2]());
+
+    this->m_next_run = 0;
+    if(view.hasAmbiguousNucleotides())
+        copyAmbiguousRuns(view.getAmbiguousRuns(), 0, size, this->m_offset, this->m_ambiguous);
+}
+
+
+bool KmerIterator::next() {
+    size_t rolls;
+
+    if(!this->m_started) {
+        if(this->m_index >= this->m_end)
+            return false;
+        this->m_started = true;
+        rolls = this->m_k;
+    }
+    else {
+        if(this->m_index + 1 >= this->m_end) {
+            this->m_index = this->m_end;
+            return false;
+        }
+        ++this->m_index;
+        rolls = 1;
+    }
+
+    /* Skip the k-mers covering an ambiguous Nucleotide, the k-mer after the run is rolled in from scratch */
+    while(this->m_next_run < this->m_ambiguous.size() && this->m_ambiguous[this->m_next_run].start < this->m_index + this->m_k) {
+        const AmbiguousRun &run = this->m_ambiguous[this->m_next_run++];
+        if(run.start + run.size <= this->m_index)
+            continue;
+
+        this->m_index = run.start + run.size;
+        this->m_loaded = this->m_index;
+        this->m_buffered = 0;
+        rolls = this->m_k;
+    }
+    if(this->m_index >= this->m_end) {
+        this->m_index = this->m_end;
+        return false;
+    }
+
+    const size_t words = this->m_words;
+    const unsigned top_shift = ((this->m_k - 1) % 32) * 2;
+    uint64_t *kmer = this->m_heap ? this->m_heap.get() : this->m_kmer_inline.data();
+    uint64_t *reverse = this->m_heap ? this->m_heap.get() + words : this->m_reverse_inline.data();
+
+    while(rolls--) {
+        /* Next Nucleotide from the packed sequence, 32 are loaded at once */
+        if(this->m_buffered == 0) {
+            this->m_buffer = loadPackedWord(this->m_sequence, this->m_size, this->m_loaded);
+            this->m_buffered = 32;
+        }
+        uint64_t code = this->m_buffer >> 62;
+        this->m_buffer <<= 2;
+        --this->m_buffered;
+        ++this->m_loaded;
+
+        /* Roll it in at the end of the k-mer and, complemented, at the start of the reverse complement */
+        if(words == 1) {
+            kmer[0] = ((kmer[0] << 2) | code) & this->m_top_mask;
+            reverse[0] = (reverse[0] >> 2) | ((code ^ 0b01) << top_shift);
+            continue;
+        }
+
+        for(size_t i = 0; i + 1 < words; ++i)
+            kmer[i] = (kmer[i] << 2) | (kmer[i + 1] >> 62);
+        kmer[words - 1] = (kmer[words - 1] << 2) | code;
+        kmer[0] &= this->m_top_mask;
+
+        for(size_t i = words - 1; i > 0; --i)
+            reverse[i] = (reverse[i] >> 2) | (reverse[i - 1] << 62);
+        reverse[0] = (reverse[0] >> 2) | ((code ^ 0b01) << top_shift);
+    }
+    return true;
+}
+
+
+size_t KmerIterator::getIndex() const {
+    return this->m_index - this->m_offset;
+}
+
+
+size_t KmerIterator::getK() const {
+    return this->m_k;
+}
+
+
+uint64_t KmerIterator::getKmer() const {
+    return this->kmerWords()[this->m_words - 1];
+}
+
+
+uint64_t KmerIterator::getReverseComplement() const {
+    return this->reverseWords()[this->m_words - 1];
+}
+
+
+uint64_t KmerIterator::getCanonical() const {
+    uint64_t kmer = this->getKmer();
+    uint64_t reverse = this->getReverseComplement();
+    return kmer < reverse ? kmer : reverse;
+}
+
+
+size_t KmerIterator::getWordCount() const {
+    return this->m_words;
+}
+
+
+const uint64_t* KmerIterator::getKmerWords() const {
+    return this->kmerWords();
+}
+
+
+const uint64_t* KmerIterator::getReverseComplementWords() const {
+    return this->reverseWords();
+}
+
+
+const uint64_t* KmerIterator::getCanonicalWords() const {
+    const uint64_t *kmer = this->kmerWords();
+    const uint64_t *reverse = this->reverseWords();
+
+    for(size_t i = 0; i < this->m_words; ++i) {
+        if(kmer[i] != reverse[i])
+            return kmer[i] < reverse[i] ? kmer : reverse;
+    }
+    return kmer;
+}
+
+
+/* -- Private -- */
+
+const uint64_t* KmerIterator::kmerWords() const {
+    return this->m_heap ? this->m_heap.get() : this->m_kmer_inline.data();
+}
+
+
+const uint64_t* KmerIterator::reverseWords() const {
+    return this->m_heap ? this->m_heap.get() + this->m_words : this->m_reverse_inline.data();
+}
+
+
+/* ---------- KmerCounter::Shard ---------- */
+
+/*
+    * One open addressing hash table with linear probing, a slot with a count of 0 is empty.
+*/
+struct KmerCounter::Shard {
+    struct Slot {
+        uint64_t kmer;
+        uint64_t count;
+    };
+
+    std::vector<Slot> slots;
+    size_t used = 0;
+    std::mutex mutex;
+
+    void add(uint64_t kmer, uint64_t hash, uint64_t count) {
+        /* Keep the load factor under 0.7 */
+        if(this->slots.empty() || (this->used + 1) * 10 > this->slots.size() * 7)
+            this->grow();
+
+        size_t mask = this->slots.size() - 1;
+        for(size_t i = hash & mask; ; i = (i + 1) & mask) {
+            Slot &slot = this->slots[i];
+            if(slot.count == 0) {
+                slot.kmer = kmer;
+                slot.count = count;
+                ++this->used;
+                return;
+            }
+            if(slot.kmer == kmer) {
+                slot.count += count;
+                return;
+            }
+        }
+    }
+
+    uint64_t find(uint64_t kmer, uint64_t hash) const {
+        if(this->slots.empty())
+            return 0;
+
+        size_t mask = this->slots.size() - 1;
+        for(size_t i = hash & mask; ; i = (i + 1) & mask) {
+            const Slot &slot = this->slots[i];
+            if(slot.count == 0)
+                return 0;
+            if(slot.kmer == kmer)
+                return slot.count;
+        }
+    }
+
+    void grow() {
+        std::vector<Slot> old_slots(this->slots.empty() ? KMER_SHARD_INITIAL_SLOTS : this->slots.size() * 2, Slot{0, 0});
+        old_slots.swap(this->slots);
+        this->used = 0;
+
+        for(const Slot &slot : old_slots) {
+            if(slot.count)
+                this->add(slot.kmer, hashKmer(slot.kmer), slot.count);
+        }
+    }
+};
+
+
+/* ---------- KmerCounter Methods ---------- */
+
+KmerCounter::KmerCounter(size_t k, bool canonical) {
+    this->m_k = k < 1 ? 1 : k > 32 ? 32 : k;
+    this->m_canonical = canonical;
+    this->m_shards = std::unique_ptr<Shard[]>(new Shard[KMER_SHARDS]);
+}
+
+
+KmerCounter::~KmerCounter() {}
+
+
+void KmerCounter::add(const DNASequence &sequence) {
+    KmerIterator kmers(sequence, this->m_k);
+
+    while(kmers.next()) {
+        uint64_t kmer = this->m_canonical ? kmers.getCanonical() : kmers.getKmer();
+        uint64_t hash = hashKmer(kmer);
+        this->m_shards[hash >> (64 - KMER_SHARD_BITS)].add(kmer, hash, 1);
+    }
+}
+
+
+void KmerCounter::addParallel(const DNASequence &sequence, ThreadPool *pool) {
+    size_t size = sequence.getSize();
+
+    if(this->m_k > size)
+        return;
+
+    size_t kmer_count = size - this->m_k + 1;
+    size_t chunks = (kmer_count + KMER_PARALLEL_CHUNK - 1) / KMER_PARALLEL_CHUNK;
+
+    (pool ? *pool : ThreadPool::shared()).parallelFor(chunks, [&](size_t chunk) {
+        std::vector<std::vector<uint64_t>> batches(KMER_SHARDS);
+        KmerIterator kmers(sequence, this->m_k, chunk * KMER_PARALLEL_CHUNK, (chunk + 1) * KMER_PARALLEL_CHUNK);
+
+        auto flush = [&](size_t shard) {
+            std::lock_guard<std::mutex> lock(this->m_shards[shard].mutex);
+            for(uint64_t kmer : batches[shard])
+                this->m_shards[shard].add(kmer, hashKmer(kmer), 1);
+            batches[shard].clear();
+        };
+
+        while(kmers.next()) {
+            uint64_t kmer = this->m_canonical ? kmers.getCanonical() : kmers.getKmer();
+            size_t shard = hashKmer(kmer) >> (64 - KMER_SHARD_BITS);
+
+            batches[shard].push_back(kmer);
+            if(batches[shard].size() == KMER_PARALLEL_BATCH)
+                flush(shard);
+        }
+        for(size_t shard = 0; shard < KMER_SHARDS; ++shard) {
+            if(!batches[shard].empty())
+                flush(shard);
+        }
+    });
+}
+
+
+uint64_t KmerCounter::getCount(uint64_t kmer) const {
+    if(this->m_canonical)
+        kmer = this->canonicalKmer(kmer);
+
+    uint64_t hash = hashKmer(kmer);
+    return this->m_shards[hash >> (64 - KMER_SHARD_BITS)].find(kmer, hash);
+}
+
+
+uint64_t KmerCounter::getCount(const std::string &kmer) const {
+    uint64_t encoded = 0;
+
+    if(kmer.size() != this->m_k)
+        return 0;
+
+    for(char nucleotide : kmer) {
+        int code = nucleotideCode(nucleotide);
+        if(code < 0)
+            return 0;
+        encoded = (encoded << 2) | code;
+    }
+    return this->getCount(encoded);
+}
+
+
+size_t KmerCounter::getDistinctCount() const {
+    size_t distinct = 0;
+
+    for(size_t shard = 0; shard < KMER_SHARDS; ++shard)
+        distinct += this->m_shards[shard].used;
+    return distinct;
+}
+
+
+std::vector<std::pair<uint64_t, uint64_t>> KmerCounter::getCounts() const {
+    std::vector<std::pair<uint64_t, uint64_t>> counts;
+
+    counts.reserve(this->getDistinctCount());
+    for(size_t shard = 0; shard < KMER_SHARDS; ++shard) {
+        for(const Shard::Slot &slot : this->m_shards[shard].slots) {
+            if(slot.count)
+                counts.emplace_back(slot.kmer, slot.count);
+        }
+    }
+    std::sort(counts.begin(), counts.end());
+    return counts;
+}
+
+
+size_t KmerCounter::getK() const {
+    return this->m_k;
+}
+
+
+bool KmerCounter::isCanonical() const {
+    return this->m_canonical;
+}
+
+
+/* -- Private -- */
+
+uint64_t KmerCounter::canonicalKmer(uint64_t kmer) const {
+    uint64_t reverse = 0;
+    uint64_t remaining = kmer;
+
+    for(size_t i = 0; i < this->m_k; ++i, remaining >>= 2)
+        reverse = (reverse << 2) | ((remaining & 0b11) ^ 0b01);
+    return kmer < reverse ? kmer : reverse;
+}
@@ -0,0 +1,159 @@
+#ifndef KMER
+#define KMER
+
+#include "dna_sequence.hpp"
+#include "dna_sequence_view.hpp"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+class ThreadPool;
+
+/*
+    * Mixes the bits of a k-mer (MurmurHash3 finalizer).
+    * The mix is a bijection, distinct k-mers always have distinct hashes.
+*/
+inline uint64_t hashKmer(uint64_t kmer) {
+    kmer ^= kmer >> 33;
+    kmer *= 0xFF51AFD7ED558CCDull;
+    kmer ^= kmer >> 33;
+    kmer *= 0xC4CEB9FE1A85EC53ull;
+    kmer ^= kmer >> 33;
+    return kmer;
+}
+
+/*
+    * Iterates over the k-mers of a DNASequence, directly from its packed Nucleotides.
+    * A k-mer is encoded 2 bits per Nucleotide ('00' A, '01' T, '10' G, '11' C) with its first
+     Nucleotide in the highest bits:
+        k <= 32: a single uint64_t holding the k-mer in its lowest 2k bits (getKmer).
+        k > 32:  ceil(k / 32) words, the first word holds the first k % 32 Nucleotides (32 if k
+                 is a multiple of 32) in its lowest bits, every other word holds 32 (getKmerWords).
+    * Each step costs O(1) for k <= 32 and O(k / 32) word shifts otherwise, nothing is allocated
+     after construction. The words are kept inside the iterator up to k = 64, only longer k-mers
+     allocate them.
+    * The reverse complement is rolled along with the k-mer, the canonical k-mer is the smallest of both.
+    * The k-mers covering an ambiguous Nucleotide are skipped, the next k-mer is rolled in after its run.
+*/
+class KmerIterator {
+public:
+    /*
+        * Iterates over the k-mers starting in [start, end) of 'sequence', which must outlive the iterator.
+        * If 'end' is not specified, every k-mer from 'start' to the end of the sequence is iterated.
+    */
+    KmerIterator(const DNASequence &sequence, size_t k, size_t start = 0, size_t end = -1);
+
+    /* Same over a view, the indexes are relative to the start of the view. */
+    KmerIterator(const DNASequenceView &view, size_t k, size_t start = 0, size_t end = -1);
+
+    /*
+        * Moves to the next k-mer, it must be called once before reading the first k-mer.
+        * Returns false once there are no more k-mers.
+    */
+    bool next();
+
+    /* Index of the first Nucleotide of the current k-mer */
+    size_t getIndex() const;
+    size_t getK() const;
+
+    /* The current k-mer, its reverse complement and the smallest of both, for k <= 32 */
+    uint64_t getKmer() const;
+    uint64_t getReverseComplement() const;
+    uint64_t getCanonical() const;
+
+    /* The current k-mer, its reverse complement and the smallest of both, for any k */
+    size_t getWordCount() const;
+    const uint64_t* getKmerWords() const;
+    const uint64_t* getReverseComplementWords() const;
+    const uint64_t* getCanonicalWords() const;
+
+private:
+    /* Words kept inside the iterator, enough for k <= 64 */
+    static const size_t INLINE_WORDS = 2;
+
+    /* The words of the current k-mer and of its reverse complement, inline or on the heap */
+    const uint64_t* kmerWords() const;
+    const uint64_t* reverseWords() const;
+
+    /* The packed data, the Nucleotides of the view are [m_offset, m_size) */
+    const unsigned char *m_sequence;
+    size_t m_offset;
+    size_t m_size;
+    size_t m_k;
+    size_t m_index;
+    size_t m_end;
+    size_t m_loaded;
+    bool m_started;
+
+    /* Next Nucleotides to roll in, loaded 32 at a time */
+    uint64_t m_buffer;
+    size_t m_buffered;
+
+    /* Number of words and mask of the first word of a multiword k-mer */
+    size_t m_words;
+    uint64_t m_top_mask;
+    std::array<uint64_t, INLINE_WORDS> m_kmer_inline;
+    std::array<uint64_t, INLINE_WORDS> m_reverse_inline;
+
+    /* The k-mer then the reverse complement words if k > 64, looked up on use so a moved iterator stays valid */
+    std::unique_ptr<uint64_t[]> m_heap;
+
+    /* The ambiguous runs, moved to the indexes of the packed data, and the next one to skip */
+    std::vector<AmbiguousRun> m_ambiguous;
+    size_t m_next_run;
+};
+
+/*
+    * Counts the k-mers (k <= 32) of one or more DNASequences.
+    * The counts are kept in a sharded open addressing hash table with linear probing. A slot holds
+     a k-mer and its count next to each other, so a lookup usually touches a single cache line.
+    * With 'canonical' set, a k-mer and its reverse complement are counted together under the smallest of both.
+*/
+class KmerCounter {
+public:
+    /* Create a counter of k-mers of length 'k', in [1, 32]. */
+    KmerCounter(size_t k, bool canonical = false);
+    ~KmerCounter();
+
+    /* Counts the k-mers of the sequence. */
+    void add(const DNASequence &sequence);
+
+    /*
+        * Counts the k-mers of the sequence on 'pool' (ThreadPool::shared() if null).
+        * The sequence is split into chunks whose k-mers are routed to the hash table shards
+         in batches, so each shard lock is taken once per batch.
+    */
+    void addParallel(const DNASequence &sequence, ThreadPool *pool = nullptr);
+
+    /*
+        * Returns the number of times the k-mer was counted.
+        * With canonical counting, the k-mer and its reverse complement give the same count.
+        * A string k-mer of the wrong length or with an invalid Nucleotide value has a count of 0.
+    */
+    uint64_t getCount(uint64_t kmer) const;
+    uint64_t getCount(const std::string &kmer) const;
+
+    /* Number of distinct k-mers counted */
+    size_t getDistinctCount() const;
+
+    /* Returns every counted k-mer with its count, sorted by k-mer. */
+    std::vector<std::pair<uint64_t, uint64_t>> getCounts() const;
+
+    size_t getK() const;
+    bool isCanonical() const;
+
+private:
+    struct Shard;
+
+    uint64_t canonicalKmer(uint64_t kmer) const;
+
+    size_t m_k;
+    bool m_canonical;
+    std::unique_ptr<Shard[]> m_shards;
+};
+
+#endif
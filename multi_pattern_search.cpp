@@ -0,0 +1,237 @@
+#include "multi_pattern_search.hpp"
+#include "packed_search.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+static const uint32_t NO_STATE = 0xFFFFFFFF;
+
+/* ---------- MultiPatternSearch Methods ---------- */
+
+MultiPatternSearch::MultiPatternSearch() {
+    this->build();
+}
+
+
+MultiPatternSearch::MultiPatternSearch(const std::vector<std::string> &patterns) {
+    std::vector<uint8_t> codes;
+
+    for(const std::string &pattern : patterns) {
+        bool valid = true;
+        codes.resize(pattern.size());
+        for(size_t i = 0; i < pattern.size() && valid; ++i) {
+            int code = nucleotideCode(pattern[i]);
+            valid = code >= 0;
+            codes[i] = code;
+        }
+        this->addPattern(codes, valid);
+    }
+    this->build();
+}
+
+
+MultiPatternSearch::MultiPatternSearch(const std::vector<const char*> &patterns) {
+    std::vector<uint8_t> codes;
+
+    for(const char *pattern : patterns) {
+        bool valid = true;
+        codes.resize(std::strlen(pattern));
+        for(size_t i = 0; i < codes.size() && valid; ++i) {
+            int code = nucleotideCode(pattern[i]);
+            valid = code >= 0;
+            codes[i] = code;
+        }
+        this->addPattern(codes, valid);
+    }
+    this->build();
+}
+
+
+MultiPatternSearch::MultiPatternSearch(const std::vector<DNASequence> &patterns) {
+    std::vector<uint8_t> codes;
+
+    for(const DNASequence &pattern : patterns) {
+        const unsigned char *packed = pattern.getPackedSequence();
+        codes.resize(pattern.getSize());
+        for(size_t i = 0; i < codes.size(); ++i)
+            codes[i] = (packed[i / 4] >> (6 - (i % 4) * 2)) & 0b11;
+        this->addPattern(codes, !pattern.hasAmbiguousNucleotides());
+    }
+    this->build();
+}
+
+
+std::vector<PatternHit> MultiPatternSearch::findAll(const DNASequence &sequence) const {
+    std::vector<PatternHit> hits;
+
+    this->scan(sequence, [&](uint32_t pattern, size_t index) {
+        hits.push_back({pattern, index});
+    });
+
+    std::sort(hits.begin(), hits.end(), [](const PatternHit &a, const PatternHit &b) {
+        return a.index != b.index ? a.index < b.index : a.pattern < b.pattern;
+    });
+    return hits;
+}
+
+
+std::vector<size_t> MultiPatternSearch::countAll(const DNASequence &sequence) const {
+    std::vector<size_t> counts(this->m_pattern_sizes.size(), 0);
+
+    this->scan(sequence, [&](uint32_t pattern, size_t) {
+        ++counts[pattern];
+    });
+    return counts;
+}
+
+
+size_t MultiPatternSearch::getPatternCount() const {
+    return this->m_pattern_sizes.size();
+}
+
+
+size_t MultiPatternSearch::getStateCount() const {
+    return this->m_transitions.size() / 4;
+}
+
+
+/* -- Private -- */
+
+/*
+    * Adds a pattern to the trie, the transitions are completed later by build.
+*/
+void MultiPatternSearch::addPattern(const std::vector<uint8_t> &codes, bool valid) {
+    uint32_t pattern = this->m_pattern_sizes.size();
+    uint32_t state = 0;
+
+    this->m_pattern_sizes.push_back(codes.size());
+    if(!valid)
+        return;
+    if(codes.empty()) {
+        this->m_empty_patterns.push_back(pattern);
+        return;
+    }
+
+    if(this->m_transitions.empty())
+        this->m_transitions.assign(4, NO_STATE);
+
+    for(uint8_t code : codes) {
+        uint32_t &next = this->m_transitions[state * 4 + code];
+        if(next == NO_STATE) {
+            next = this->m_transitions.size() / 4;
+            this->m_transitions.insert(this->m_transitions.end(), 4, NO_STATE);
+        }
+        state = this->m_transitions[state * 4 + code];
+    }
+    this->m_pattern_ends.push_back({state, pattern});
+}
+
+
+/*
+    * Completes the trie into a DFA with a breadth first traversal: a missing transition goes where
+     the failure state goes, and each state links to the nearest state on its failure chain where
+     patterns end.
+*/
+void MultiPatternSearch::build() {
+    if(this->m_transitions.empty())
+        this->m_transitions.assign(4, NO_STATE);
+
+    const uint32_t states = this->m_transitions.size() / 4;
+    std::vector<uint32_t> failures(states, 0);
+    std::vector<uint32_t> queue;
+
+    /* Patterns ending at each state, in pattern order */
+    std::stable_sort(this->m_pattern_ends.begin(), this->m_pattern_ends.end(),
+        [](const std::pair<uint32_t, uint32_t> &a, const std::pair<uint32_t, uint32_t> &b) {
+            return a.first < b.first;
+        });
+    this->m_output_begin.assign(states + 1, 0);
+    for(const std::pair<uint32_t, uint32_t> &end : this->m_pattern_ends)
+        ++this->m_output_begin[end.first + 1];
+    for(uint32_t state = 0; state < states; ++state)
+        this->m_output_begin[state + 1] += this->m_output_begin[state];
+    for(const std::pair<uint32_t, uint32_t> &end : this->m_pattern_ends)
+        this->m_outputs.push_back(end.second);
+    this->m_pattern_ends.clear();
+    this->m_pattern_ends.shrink_to_fit();
+
+    auto hasOutputs = [&](uint32_t state) {
+        return this->m_output_begin[state] != this->m_output_begin[state + 1];
+    };
+
+    this->m_output_links.assign(states, 0);
+    queue.reserve(states);
+
+    for(int code = 0; code < 4; ++code) {
+        uint32_t &next = this->m_transitions[code];
+        if(next == NO_STATE) {
+            next = 0;
+        }
+        else {
+            failures[next] = 0;
+            queue.push_back(next);
+        }
+    }
+
+    for(size_t head = 0; head < queue.size(); ++head) {
+        uint32_t state = queue[head];
+        uint32_t failure = failures[state];
+
+        this->m_output_links[state] = hasOutputs(failure) ? failure : this->m_output_links[failure];
+
+        for(int code = 0; code < 4; ++code) {
+            uint32_t &next = this->m_transitions[state * 4 + code];
+            if(next == NO_STATE) {
+                next = this->m_transitions[failure * 4 + code];
+            }
+            else {
+                failures[next] = this->m_transitions[failure * 4 + code];
+                queue.push_back(next);
+            }
+        }
+    }
+}
+
+
+/*
+    * Runs the automaton over the packed sequence, one 64-bit word (32 Nucleotides) is loaded at a time,
+     and calls on_match(pattern, starting index) for every occurrence.
+*/
+template<typename Callback>
+void MultiPatternSearch::scan(const DNASequence &sequence, Callback on_match) const {
+    const unsigned char *packed = sequence.getPackedSequence();
+    const size_t size = sequence.getSize();
+    const uint32_t *transitions = this->m_transitions.data();
+    const std::vector<AmbiguousRun> &ambiguous = sequence.getAmbiguousRuns();
+    uint32_t state = 0;
+
+    if(!this->m_empty_patterns.empty()) {
+        for(size_t index = 0; index <= size; ++index) {
+            for(uint32_t pattern : this->m_empty_patterns)
+                on_match(pattern, index);
+        }
+    }
+    if(this->m_outputs.empty())
+        return;
+
+    for(size_t word_start = 0; word_start < size; word_start += 32) {
+        uint64_t word = loadPackedWord(packed, size, word_start);
+        size_t word_end = size - word_start < 32 ? size : word_start + 32;
+
+        for(size_t index = word_start; index < word_end; ++index, word <<= 2) {
+            state = transitions[state * 4 + (word >> 62)];
+
+            /* Report the patterns ending here, then those on the output links */
+            for(uint32_t output = state; output != 0; output = this->m_output_links[output]) {
+                for(uint32_t i = this->m_output_begin[output]; i < this->m_output_begin[output + 1]; ++i) {
+                    uint32_t pattern = this->m_outputs[i];
+                    size_t start = index + 1 - this->m_pattern_sizes[pattern];
+
+                    /* The ambiguous Nucleotides are packed as 'A', they match no pattern */
+                    if(ambiguous.empty() || !overlapsAmbiguousRun(ambiguous, start, index + 1))
+                        on_match(pattern, start);
+                }
+            }
+        }
+    }
+}
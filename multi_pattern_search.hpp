@@ -0,0 +1,78 @@
+#ifndef MULTI_PATTERN_SEARCH
+#define MULTI_PATTERN_SEARCH
+
+#include "dna_sequence.hpp"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+    * An occurrence of pattern number 'pattern' starting at index 'index' of the searched sequence.
+*/
+struct PatternHit {
+    size_t pattern;
+    size_t index;
+};
+
+/*
+    * Searches a batch of patterns in a single pass over a packed DNASequence (Aho-Corasick).
+    * The automaton is a complete DFA over the 4 Nucleotides: every state has its 4 transitions
+     precomputed, so each Nucleotide of the sequence costs one table lookup.
+    * The patterns are numbered in the order they are passed in, a pattern with an invalid or ambiguous Nucleotide
+     value matches nowhere and an empty pattern matches at every index from 0 to the sequence size.
+    * An occurrence never covers an ambiguous Nucleotide of the searched sequence.
+    * The automaton is immutable once built, so it can be shared by threads searching different sequences.
+*/
+class MultiPatternSearch {
+public:
+    /* Create a search without patterns. */
+    MultiPatternSearch();
+
+    MultiPatternSearch(const std::vector<std::string> &patterns);
+
+    /* The C strings must end with a string termination character ('\0' or 0). */
+    MultiPatternSearch(const std::vector<const char*> &patterns);
+
+    MultiPatternSearch(const std::vector<DNASequence> &patterns);
+
+    /*
+        * Returns every occurrence of every pattern, sorted by starting index then by pattern number.
+    */
+    std::vector<PatternHit> findAll(const DNASequence &sequence) const;
+
+    /*
+        * Returns the number of occurrences of each pattern, indexed by pattern number.
+    */
+    std::vector<size_t> countAll(const DNASequence &sequence) const;
+
+    size_t getPatternCount() const;
+    size_t getStateCount() const;
+
+private:
+    void addPattern(const std::vector<uint8_t> &codes, bool valid);
+    void build();
+
+    template<typename Callback>
+    void scan(const DNASequence &sequence, Callback on_match) const;
+
+    /* m_transitions[state * 4 + code], a complete DFA once built */
+    std::vector<uint32_t> m_transitions;
+
+    /* Patterns ending at a state: m_outputs[m_output_begin[state] .. m_output_begin[state + 1]) */
+    std::vector<uint32_t> m_output_begin;
+    std::vector<uint32_t> m_outputs;
+
+    /* Nearest state on the failure chain that has patterns ending at it, 0 (the root) if none */
+    std::vector<uint32_t> m_output_links;
+
+    /* The pattern lengths, and the empty patterns which are reported at every index */
+    std::vector<size_t> m_pattern_sizes;
+    std::vector<uint32_t> m_empty_patterns;
+
+    /* (state, pattern) pairs collected while the trie is built */
+    std::vector<std::pair<uint32_t, uint32_t>> m_pattern_ends;
+};
+
+#endif
@@ -0,0 +1,97 @@
+#include "nucleotide_composition.hpp"
+#include "nucleotide_kernels.hpp"
+
+/* ----- Nucleotide Composition Utility Functions ----- */
+
+NucleotideComposition countComposition(const unsigned char *sequence, size_t start, size_t end) {
+    NucleotideComposition composition;
+    size_t counts[4];
+
+    if(start >= end)
+        return composition;
+
+    countNucleotides(sequence, start, end - start, counts);
+    composition.a = counts[0];
+    composition.t = counts[1];
+    composition.g = counts[2];
+    composition.c = counts[3];
+    return composition;
+}
+
+
+std::vector<NucleotideComposition> compositionProfile(const unsigned char *sequence, size_t size,
+                                                      size_t window, size_t step) {
+    std::vector<NucleotideComposition> profile;
+
+    if(window == 0 || step == 0 || window > size)
+        return profile;
+
+    profile.reserve((size - window) / step + 1);
+    NucleotideComposition composition = countComposition(sequence, 0, window);
+    profile.push_back(composition);
+
+    for(size_t start = step; start + window <= size; start += step) {
+        if(step < window) {
+            /* Slide: add what enters at the end, remove what leaves at the start */
+            composition += countComposition(sequence, start - step + window, start + window);
+            composition -= countComposition(sequence, start - step, start);
+        }
+        else {
+            composition = countComposition(sequence, start, start + window);
+        }
+        profile.push_back(composition);
+    }
+    return profile;
+}
+
+
+/* ---------- NucleotideComposition Methods ---------- */
+
+size_t NucleotideComposition::getSize() const {
+    return this->a + this->t + this->g + this->c + this->n;
+}
+
+
+double NucleotideComposition::getGCContent() const {
+    size_t size = this->a + this->t + this->g + this->c;
+    return size ? double(this->g + this->c) / size : 0;
+}
+
+
+double NucleotideComposition::getGCSkew() const {
+    size_t gc = this->g + this->c;
+    return gc ? (double(this->g) - double(this->c)) / gc : 0;
+}
+
+
+double NucleotideComposition::getATSkew() const {
+    size_t at = this->a + this->t;
+    return at ? (double(this->a) - double(this->t)) / at : 0;
+}
+
+
+/* -- Operators -- */
+
+NucleotideComposition& NucleotideComposition::operator+=(const NucleotideComposition &other) {
+    this->a += other.a;
+    this->t += other.t;
+    this->g += other.g;
+    this->c += other.c;
+    this->n += other.n;
+    return *this;
+}
+
+
+NucleotideComposition& NucleotideComposition::operator-=(const NucleotideComposition &other) {
+    this->a -= other.a;
+    this->t -= other.t;
+    this->g -= other.g;
+    this->c -= other.c;
+    this->n -= other.n;
+    return *this;
+}
+
+
+bool NucleotideComposition::operator==(const NucleotideComposition &other) const {
+    return this->a == other.a && this->t == other.t && this->g == other.g && this->c == other.c && this->n == other.n;
+}
@@ -0,0 +1,50 @@
+#ifndef NUCLEOTIDE_COMPOSITION
+#define NUCLEOTIDE_COMPOSITION
+
+#include <cstddef>
+#include <vector>
+
+/*
+    * The number of each Nucleotide in a sequence or a part of it.
+    * 'n' counts the ambiguous Nucleotides (N and the IUPAC codes), they are left out of the ratios.
+*/
+struct NucleotideComposition {
+    size_t a = 0;
+    size_t t = 0;
+    size_t g = 0;
+    size_t c = 0;
+    size_t n = 0;
+
+    size_t getSize() const;
+
+    /* (G + C) / (A + T + G + C), 0 when there are no such Nucleotides */
+    double getGCContent() const;
+
+    /* (G - C) / (G + C), 0 when there is no G or C */
+    double getGCSkew() const;
+
+    /* (A - T) / (A + T), 0 when there is no A or T */
+    double getATSkew() const;
+
+    NucleotideComposition& operator+=(const NucleotideComposition &other);
+    NucleotideComposition& operator-=(const NucleotideComposition &other);
+    bool operator==(const NucleotideComposition &other) const;
+};
+
+/*
+    * Counts the Nucleotides [start, end) of a packed sequence, with popcounts over whole words.
+    * The packed data has no ambiguous Nucleotides, their placeholders are counted as 'A'.
+*/
+NucleotideComposition countComposition(const unsigned char *sequence, size_t start, size_t end);
+
+/*
+    * Returns the composition of every window [i * step, i * step + window) that lies inside the
+     packed sequence, in order.
+    * Windows are computed incrementally: when they overlap, only the Nucleotides entering and leaving
+     between two windows are counted, so a profile costs a single pass over the sequence whatever the window.
+    * 'window' and 'step' must not be 0.
+*/
+std::vector<NucleotideComposition> compositionProfile(const unsigned char *sequence, size_t size,
+                                                      size_t window, size_t step);
+
+#endif
@@ -0,0 +1,638 @@
+#include "nucleotide_kernels.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define NUCLEOTIDE_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+/* ----- Lookup Tables ----- */
+
+/*
+    * CODES maps an ASCII character to its 2-bit code, or to INVALID_CODE.
+    * NUCLEOTIDES maps a packed byte to its 4 upper case Nucleotides.
+*/
+static const unsigned char INVALID_CODE = 0xFF;
+
+struct KernelTables {
+    unsigned char codes[256];
+    char nucleotides[256][4];
+
+    KernelTables() {
+        std::memset(codes, INVALID_CODE, sizeof(codes));
+        codes['A'] = codes['a'] = 0b00;
+        codes['T'] = codes['t'] = 0b01;
+        codes['G'] = codes['g'] = 0b10;
+        codes['C'] = codes['c'] = 0b11;
+
+        for(int byte = 0; byte < 256; ++byte)
+            for(int i = 0; i < 4; ++i)
+                nucleotides[byte][i] = "ATGC"[(byte >> (6 - i * 2)) & 0b11];
+    }
+};
+
+static const KernelTables& kernelTables() {
+    static const KernelTables tables;
+    return tables;
+}
+
+
+/* ----- Scalar Kernels ----- */
+
+static size_t validateScalar(const char *sequence, size_t size) {
+    const unsigned char *codes = kernelTables().codes;
+
+    for(size_t i = 0; i < size; ++i) {
+        if(codes[(unsigned char)sequence[i]] == INVALID_CODE)
+            return i;
+    }
+    return size;
+}
+
+
+static size_t packScalar(const char *sequence, size_t size, unsigned char *packed) {
+    const unsigned char *codes = kernelTables().codes;
+    size_t i = 0;
+
+    for(; i + 4 <= size; i += 4) {
+        unsigned char a = codes[(unsigned char)sequence[i]];
+        unsigned char b = codes[(unsigned char)sequence[i + 1]];
+        unsigned char c = codes[(unsigned char)sequence[i + 2]];
+        unsigned char d = codes[(unsigned char)sequence[i + 3]];
+
+        if((a | b | c | d) == INVALID_CODE)
+            return i + validateScalar(sequence + i, 4);
+        *packed++ = (a << 6) | (b << 4) | (c << 2) | d;
+    }
+
+    /* Pack the last Nucleotides with padding */
+    if(i < size) {
+        unsigned char last = 0;
+        for(unsigned shift = 6; i < size; ++i, shift -= 2) {
+            unsigned char code = codes[(unsigned char)sequence[i]];
+            if(code == INVALID_CODE)
+                return i;
+            last |= code << shift;
+        }
+        *packed = last;
+    }
+    return size;
+}
+
+
+static void unpackScalar(const unsigned char *packed, size_t bytes, char *out) {
+    const KernelTables &tables = kernelTables();
+
+    for(size_t i = 0; i < bytes; ++i, out += 4)
+        std::memcpy(out, tables.nucleotides[packed[i]], 4);
+}
+
+
+/*
+    * Reverses the order of the 4 Nucleotides inside every byte of a word.
+*/
+static inline uint64_t reverseByteNucleotides(uint64_t word) {
+    word = ((word >> 4) & 0x0F0F0F0F0F0F0F0Full) | ((word & 0x0F0F0F0F0F0F0F0Full) << 4);
+    return ((word >> 2) & 0x3333333333333333ull) | ((word & 0x3333333333333333ull) << 2);
+}
+
+
+/*
+    * Reverses the order of 'bytes' packed bytes and of the Nucleotides inside them, then xors them with 'flip'.
+*/
+static void reverseScalar(unsigned char *packed, size_t bytes, unsigned char flip) {
+    const uint64_t flip_word = flip * 0x0101010101010101ull;
+    size_t low = 0, high = bytes;
+
+    /* Swap a word from each end, a byte swap reverses the order of the bytes in memory */
+    for(; high - low >= 16; low += 8, high -= 8) {
+        uint64_t first, last;
+        std::memcpy(&first, packed + low, 8);
+        std::memcpy(&last, packed + high - 8, 8);
+        first = reverseByteNucleotides(__builtin_bswap64(first)) ^ flip_word;
+        last = reverseByteNucleotides(__builtin_bswap64(last)) ^ flip_word;
+        std::memcpy(packed + low, &last, 8);
+        std::memcpy(packed + high - 8, &first, 8);
+    }
+
+    for(; high - low >= 2; ++low, --high) {
+        unsigned char first = reverseByteNucleotides(packed[low]) ^ flip;
+        packed[low] = reverseByteNucleotides(packed[high - 1]) ^ flip;
+        packed[high - 1] = first;
+    }
+    if(high - low == 1)
+        packed[low] = reverseByteNucleotides(packed[low]) ^ flip;
+}
+
+
+/*
+    * Adds the Nucleotides of 'bytes' packed bytes to 'counts', read 8 bytes at a time.
+    * The byte order of a word does not matter for counting, so no byte swap is needed.
+*/
+static inline void countBytes(const unsigned char *packed, size_t bytes, size_t counts[4]) {
+    const uint64_t low_bits = 0x5555555555555555ull;
+    size_t gc = 0, c = 0, t = 0;
+
+    for(size_t i = 0; i < bytes; i += 8) {
+        uint64_t word = 0;
+        std::memcpy(&word, packed + i, bytes - i < 8 ? bytes - i : 8);
+
+        uint64_t high = (word >> 1) & low_bits;
+        uint64_t low = word & low_bits;
+        gc += __builtin_popcountll(high);
+        c += __builtin_popcountll(high & low);
+        t += __builtin_popcountll(low & ~high);
+    }
+
+    /* The zero padding of the last word counts as nothing but A, which is derived */
+    counts[0] += bytes * 4 - gc - t;
+    counts[1] += t;
+    counts[2] += gc - c;
+    counts[3] += c;
+}
+
+
+static void countScalar(const unsigned char *packed, size_t bytes, size_t counts[4]) {
+    countBytes(packed, bytes, counts);
+}
+
+
+#ifdef NUCLEOTIDE_KERNELS_X86
+
+/* ----- SSE4.2 Kernels ----- */
+
+/*
+    * Returns a mask with a bit set for every valid Nucleotide character of 'chars'.
+*/
+__attribute__((target("sse4.2")))
+static inline int validMaskSSE(__m128i chars) {
+    __m128i upper = _mm_and_si128(chars, _mm_set1_epi8((char)0xDF));
+    __m128i valid = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(upper, _mm_set1_epi8('A')), _mm_cmpeq_epi8(upper, _mm_set1_epi8('T'))),
+        _mm_or_si128(_mm_cmpeq_epi8(upper, _mm_set1_epi8('G')), _mm_cmpeq_epi8(upper, _mm_set1_epi8('C'))));
+    return _mm_movemask_epi8(valid);
+}
+
+
+/*
+    * Maps valid Nucleotide characters to their 2-bit code with a lookup on the low nibble,
+     'A' (0x41), 'T' (0x54), 'G' (0x47) and 'C' (0x43) have distinct low nibbles in both cases.
+*/
+__attribute__((target("sse4.2")))
+static inline __m128i codesSSE(__m128i chars) {
+    const __m128i lookup = _mm_setr_epi8(0, 0b00, 0, 0b11, 0b01, 0, 0, 0b10, 0, 0, 0, 0, 0, 0, 0, 0);
+    return _mm_shuffle_epi8(lookup, _mm_and_si128(chars, _mm_set1_epi8(0x0F)));
+}
+
+
+/*
+    * Combines every 4 codes into one packed byte, the packed bytes end up in the lowest 32 bits of each 128-bit lane.
+*/
+__attribute__((target("sse4.2")))
+static inline __m128i combineCodesSSE(__m128i codes) {
+    __m128i pairs = _mm_maddubs_epi16(codes, _mm_set1_epi16(0x0104));
+    __m128i quads = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00010010));
+    return _mm_shuffle_epi8(quads, _mm_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+}
+
+
+__attribute__((target("sse4.2")))
+static size_t validateSSE(const char *sequence, size_t size) {
+    size_t i = 0;
+
+    for(; i + 16 <= size; i += 16) {
+        int mask = validMaskSSE(_mm_loadu_si128((const __m128i*)(sequence + i)));
+        if(mask != 0xFFFF)
+            return i + __builtin_ctz(~mask);
+    }
+    return i + validateScalar(sequence + i, size - i);
+}
+
+
+__attribute__((target("sse4.2")))
+static size_t packSSE(const char *sequence, size_t size, unsigned char *packed) {
+    size_t i = 0;
+
+    for(; i + 16 <= size; i += 16, packed += 4) {
+        __m128i chars = _mm_loadu_si128((const __m128i*)(sequence + i));
+        int mask = validMaskSSE(chars);
+        if(mask != 0xFFFF)
+            return i + __builtin_ctz(~mask);
+
+        uint32_t bytes = _mm_cvtsi128_si32(combineCodesSSE(codesSSE(chars)));
+        std::memcpy(packed, &bytes, 4);
+    }
+    return i + packScalar(sequence + i, size - i, packed);
+}
+
+
+__attribute__((target("sse4.2")))
+static void unpackSSE(const unsigned char *packed, size_t bytes, char *out) {
+    const __m128i lookup = _mm_setr_epi8('A', 'T', 'G', 'C', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i low_bits = _mm_set1_epi8(0b11);
+    size_t i = 0;
+
+    for(; i + 16 <= bytes; i += 16, out += 64) {
+        __m128i packed_bytes = _mm_loadu_si128((const __m128i*)(packed + i));
+
+        /* The 4 fields of every byte, from the first to the last Nucleotide */
+        __m128i field0 = _mm_and_si128(_mm_srli_epi16(packed_bytes, 6), low_bits);
+        __m128i field1 = _mm_and_si128(_mm_srli_epi16(packed_bytes, 4), low_bits);
+        __m128i field2 = _mm_and_si128(_mm_srli_epi16(packed_bytes, 2), low_bits);
+        __m128i field3 = _mm_and_si128(packed_bytes, low_bits);
+
+        /* Interleave the fields so each byte expands to 4 consecutive Nucleotides */
+        __m128i low01 = _mm_unpacklo_epi8(field0, field1);
+        __m128i low23 = _mm_unpacklo_epi8(field2, field3);
+        __m128i high01 = _mm_unpackhi_epi8(field0, field1);
+        __m128i high23 = _mm_unpackhi_epi8(field2, field3);
+
+        _mm_storeu_si128((__m128i*)out, _mm_shuffle_epi8(lookup, _mm_unpacklo_epi16(low01, low23)));
+        _mm_storeu_si128((__m128i*)(out + 16), _mm_shuffle_epi8(lookup, _mm_unpackhi_epi16(low01, low23)));
+        _mm_storeu_si128((__m128i*)(out + 32), _mm_shuffle_epi8(lookup, _mm_unpacklo_epi16(high01, high23)));
+        _mm_storeu_si128((__m128i*)(out + 48), _mm_shuffle_epi8(lookup, _mm_unpackhi_epi16(high01, high23)));
+    }
+    unpackScalar(packed + i, bytes - i, out);
+}
+
+
+/*
+    * Reverses the order of the bytes of a vector and of the Nucleotides inside them.
+    * A byte is split in its two nibbles, each nibble of 2 Nucleotides is reversed with a lookup
+     and the nibbles are swapped.
+*/
+__attribute__((target("sse4.2")))
+static inline __m128i reverseBytesSSE(__m128i bytes) {
+    const __m128i byte_order = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    const __m128i nibble_reverse = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+    const __m128i low_nibble = _mm_set1_epi8(0x0F);
+
+    bytes = _mm_shuffle_epi8(bytes, byte_order);
+    __m128i low = _mm_shuffle_epi8(nibble_reverse, _mm_and_si128(bytes, low_nibble));
+    __m128i high = _mm_shuffle_epi8(nibble_reverse, _mm_and_si128(_mm_srli_epi16(bytes, 4), low_nibble));
+    return _mm_or_si128(_mm_slli_epi16(low, 4), high);
+}
+
+
+__attribute__((target("sse4.2")))
+static void reverseSSE(unsigned char *packed, size_t bytes, unsigned char flip) {
+    const __m128i flip_bytes = _mm_set1_epi8(flip);
+    size_t low = 0, high = bytes;
+
+    for(; high - low >= 32; low += 16, high -= 16) {
+        __m128i first = _mm_loadu_si128((const __m128i*)(packed + low));
+        __m128i last = _mm_loadu_si128((const __m128i*)(packed + high - 16));
+        _mm_storeu_si128((__m128i*)(packed + low), _mm_xor_si128(reverseBytesSSE(last), flip_bytes));
+        _mm_storeu_si128((__m128i*)(packed + high - 16), _mm_xor_si128(reverseBytesSSE(first), flip_bytes));
+    }
+    reverseScalar(packed + low, high - low, flip);
+}
+
+
+/* Every SSE4.2 CPU has popcnt, the scalar loop is recompiled to use it */
+__attribute__((target("sse4.2,popcnt")))
+static void countSSE(const unsigned char *packed, size_t bytes, size_t counts[4]) {
+    countBytes(packed, bytes, counts);
+}
+
+
+/* ----- AVX2 Kernels ----- */
+
+__attribute__((target("avx2")))
+static inline uint32_t validMaskAVX2(__m256i chars) {
+    __m256i upper = _mm256_and_si256(chars, _mm256_set1_epi8((char)0xDF));
+    __m256i valid = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(upper, _mm256_set1_epi8('A')), _mm256_cmpeq_epi8(upper, _mm256_set1_epi8('T'))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(upper, _mm256_set1_epi8('G')), _mm256_cmpeq_epi8(upper, _mm256_set1_epi8('C'))));
+    return (uint32_t)_mm256_movemask_epi8(valid);
+}
+
+
+__attribute__((target("avx2")))
+static size_t validateAVX2(const char *sequence, size_t size) {
+    size_t i = 0;
+
+    for(; i + 32 <= size; i += 32) {
+        uint32_t mask = validMaskAVX2(_mm256_loadu_si256((const __m256i*)(sequence + i)));
+        if(mask != 0xFFFFFFFFu)
+            return i + __builtin_ctz(~mask);
+    }
+    return i + validateSSE(sequence + i, size - i);
+}
+
+
+__attribute__((target("avx2")))
+static size_t packAVX2(const char *sequence, size_t size, unsigned char *packed) {
+    const __m256i lookup = _mm256_setr_epi8(
+        0, 0b00, 0, 0b11, 0b01, 0, 0, 0b10, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0b00, 0, 0b11, 0b01, 0, 0, 0b10, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i gather = _mm256_setr_epi8(
+        0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    size_t i = 0;
+
+    for(; i + 32 <= size; i += 32, packed += 8) {
+        __m256i chars = _mm256_loadu_si256((const __m256i*)(sequence + i));
+        uint32_t mask = validMaskAVX2(chars);
+        if(mask != 0xFFFFFFFFu)
+            return i + __builtin_ctz(~mask);
+
+        __m256i codes = _mm256_shuffle_epi8(lookup, _mm256_and_si256(chars, _mm256_set1_epi8(0x0F)));
+        __m256i pairs = _mm256_maddubs_epi16(codes, _mm256_set1_epi16(0x0104));
+        __m256i quads = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00010010));
+        __m256i bytes = _mm256_shuffle_epi8(quads, gather);
+
+        /* Move the 4 packed bytes of the high lane next to the 4 of the low lane */
+        bytes = _mm256_permutevar8x32_epi32(bytes, _mm256_setr_epi32(0, 4, 1, 2, 3, 5, 6, 7));
+        _mm_storel_epi64((__m128i*)packed, _mm256_castsi256_si128(bytes));
+    }
+    return i + packSSE(sequence + i, size - i, packed);
+}
+
+
+__attribute__((target("avx2")))
+static void unpackAVX2(const unsigned char *packed, size_t bytes, char *out) {
+    const __m256i lookup = _mm256_setr_epi8(
+        'A', 'T', 'G', 'C', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        'A', 'T', 'G', 'C', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i low_bits = _mm256_set1_epi8(0b11);
+    size_t i = 0;
+
+    for(; i + 16 <= bytes; i += 16, out += 64) {
+        /* Low lane holds packed bytes 0-7, high lane holds packed bytes 8-15 */
+        __m128i input = _mm_loadu_si128((const __m128i*)(packed + i));
+        __m256i packed_bytes = _mm256_permute4x64_epi64(_mm256_castsi128_si256(input), 0b01010000);
+
+        __m256i field0 = _mm256_and_si256(_mm256_srli_epi16(packed_bytes, 6), low_bits);
+        __m256i field1 = _mm256_and_si256(_mm256_srli_epi16(packed_bytes, 4), low_bits);
+        __m256i field2 = _mm256_and_si256(_mm256_srli_epi16(packed_bytes, 2), low_bits);
+        __m256i field3 = _mm256_and_si256(packed_bytes, low_bits);
+
+        __m256i pairs01 = _mm256_unpacklo_epi8(field0, field1);
+        __m256i pairs23 = _mm256_unpacklo_epi8(field2, field3);
+        __m256i first = _mm256_shuffle_epi8(lookup, _mm256_unpacklo_epi16(pairs01, pairs23));
+        __m256i second = _mm256_shuffle_epi8(lookup, _mm256_unpackhi_epi16(pairs01, pairs23));
+
+        _mm256_storeu_si256((__m256i*)out, _mm256_permute2x128_si256(first, second, 0x20));
+        _mm256_storeu_si256((__m256i*)(out + 32), _mm256_permute2x128_si256(first, second, 0x31));
+    }
+    unpackSSE(packed + i, bytes - i, out);
+}
+
+
+__attribute__((target("avx2")))
+static inline __m256i reverseBytesAVX2(__m256i bytes) {
+    const __m256i byte_order = _mm256_setr_epi8(
+        15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+        15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    const __m256i nibble_reverse = _mm256_setr_epi8(
+        0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15,
+        0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+    const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+
+    /* Reverse each 128-bit lane, then swap the lanes */
+    bytes = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(bytes, byte_order), 0b01001110);
+    __m256i low = _mm256_shuffle_epi8(nibble_reverse, _mm256_and_si256(bytes, low_nibble));
+    __m256i high = _mm256_shuffle_epi8(nibble_reverse, _mm256_and_si256(_mm256_srli_epi16(bytes, 4), low_nibble));
+    return _mm256_or_si256(_mm256_slli_epi16(low, 4), high);
+}
+
+
+__attribute__((target("avx2")))
+static void reverseAVX2(unsigned char *packed, size_t bytes, unsigned char flip) {
+    const __m256i flip_bytes = _mm256_set1_epi8(flip);
+    size_t low = 0, high = bytes;
+
+    for(; high - low >= 64; low += 32, high -= 32) {
+        __m256i first = _mm256_loadu_si256((const __m256i*)(packed + low));
+        __m256i last = _mm256_loadu_si256((const __m256i*)(packed + high - 32));
+        _mm256_storeu_si256((__m256i*)(packed + low), _mm256_xor_si256(reverseBytesAVX2(last), flip_bytes));
+        _mm256_storeu_si256((__m256i*)(packed + high - 32), _mm256_xor_si256(reverseBytesAVX2(first), flip_bytes));
+    }
+    reverseSSE(packed + low, high - low, flip);
+}
+
+/*
+    * Returns the number of bits set in every byte, with nibble lookups.
+*/
+__attribute__((target("avx2")))
+static inline __m256i popcountBytesAVX2(__m256i bytes) {
+    const __m256i nibble_count = _mm256_setr_epi8(
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+
+    __m256i low = _mm256_shuffle_epi8(nibble_count, _mm256_and_si256(bytes, low_nibble));
+    __m256i high = _mm256_shuffle_epi8(nibble_count, _mm256_and_si256(_mm256_srli_epi16(bytes, 4), low_nibble));
+    return _mm256_add_epi8(low, high);
+}
+
+
+__attribute__((target("avx2")))
+static inline size_t sumLanesAVX2(__m256i lanes) {
+    __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(lanes), _mm256_extracti128_si256(lanes, 1));
+    return _mm_cvtsi128_si64(sum) + _mm_extract_epi64(sum, 1);
+}
+
+
+__attribute__((target("avx2,popcnt")))
+static void countAVX2(const unsigned char *packed, size_t bytes, size_t counts[4]) {
+    const __m256i low_bits = _mm256_set1_epi8(0x55);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i gc = zero, c = zero, t = zero;
+    size_t i = 0;
+
+    /* The per byte counts are summed into 64-bit lanes by psadbw */
+    for(; i + 32 <= bytes; i += 32) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i*)(packed + i));
+        __m256i high = _mm256_and_si256(_mm256_srli_epi16(chunk, 1), low_bits);
+        __m256i low = _mm256_and_si256(chunk, low_bits);
+
+        gc = _mm256_add_epi64(gc, _mm256_sad_epu8(popcountBytesAVX2(high), zero));
+        c = _mm256_add_epi64(c, _mm256_sad_epu8(popcountBytesAVX2(_mm256_and_si256(high, low)), zero));
+        t = _mm256_add_epi64(t, _mm256_sad_epu8(popcountBytesAVX2(_mm256_andnot_si256(high, low)), zero));
+    }
+
+    size_t gc_count = sumLanesAVX2(gc), c_count = sumLanesAVX2(c), t_count = sumLanesAVX2(t);
+    counts[0] += i * 4 - gc_count - t_count;
+    counts[1] += t_count;
+    counts[2] += gc_count - c_count;
+    counts[3] += c_count;
+    countBytes(packed + i, bytes - i, counts);
+}
+
+#endif
+
+
+/* ----- Runtime Dispatch ----- */
+
+struct NucleotideKernels {
+    size_t (*validate)(const char *sequence, size_t size);
+    size_t (*pack)(const char *sequence, size_t size, unsigned char *packed);
+    void (*unpack)(const unsigned char *packed, size_t bytes, char *out);
+    void (*reverse)(unsigned char *packed, size_t bytes, unsigned char flip);
+    void (*count)(const unsigned char *packed, size_t bytes, size_t counts[4]);
+    KernelLevel level;
+};
+
+
+/*
+    * Returns the best level supported by the CPU that is not above 'level'.
+*/
+static KernelLevel supportedLevel(KernelLevel level) {
+#ifdef NUCLEOTIDE_KERNELS_X86
+    __builtin_cpu_init();
+    if(level == KernelLevel::AVX2 && __builtin_cpu_supports("avx2"))
+        return KernelLevel::AVX2;
+    if(level != KernelLevel::Scalar && __builtin_cpu_supports("sse4.2"))
+        return KernelLevel::SSE42;
+#endif
+    return KernelLevel::Scalar;
+}
+
+
+static NucleotideKernels kernelsFor(KernelLevel level) {
+    switch(supportedLevel(level)) {
+#ifdef NUCLEOTIDE_KERNELS_X86
+        case KernelLevel::AVX2:
+            return {validateAVX2, packAVX2, unpackAVX2, reverseAVX2, countAVX2, KernelLevel::AVX2};
+        case KernelLevel::SSE42:
+            return {validateSSE, packSSE, unpackSSE, reverseSSE, countSSE, KernelLevel::SSE42};
+#endif
+        default:
+            return {validateScalar, packScalar, unpackScalar, reverseScalar, countScalar, KernelLevel::Scalar};
+    }
+}
+
+
+static NucleotideKernels& activeKernels() {
+    static NucleotideKernels kernels = kernelsFor(KernelLevel::AVX2);
+    return kernels;
+}
+
+
+KernelLevel nucleotideKernelLevel() {
+    return activeKernels().level;
+}
+
+
+KernelLevel selectNucleotideKernels(KernelLevel level) {
+    activeKernels() = kernelsFor(level);
+    return activeKernels().level;
+}
+
+
+/* ----- Kernel Entry Points ----- */
+
+size_t validateNucleotides(const char *sequence, size_t size) {
+    return activeKernels().validate(sequence, size);
+}
+
+
+size_t packNucleotides(const char *sequence, size_t size, unsigned char *packed) {
+    return activeKernels().pack(sequence, size, packed);
+}
+
+
+void unpackNucleotides(const unsigned char *packed, size_t start, size_t count, char *out) {
+    const KernelTables &tables = kernelTables();
+
+    packed += start / 4;
+
+    /* Unaligned head, up to the next byte boundary */
+    if(start % 4 && count) {
+        size_t head = 4 - start % 4;
+        head = head < count ? head : count;
+        std::memcpy(out, tables.nucleotides[*packed] + start % 4, head);
+        out += head;
+        count -= head;
+        ++packed;
+    }
+
+    /* Whole bytes */
+    activeKernels().unpack(packed, count / 4, out);
+    packed += count / 4;
+    out += count / 4 * 4;
+
+    /* Padded tail */
+    if(count % 4)
+        std::memcpy(out, tables.nucleotides[*packed], count % 4);
+}
+
+
+void complementNucleotides(unsigned char *packed, size_t size) {
+    size_t bytes = (size + 3) / 4;
+    size_t i = 0;
+
+    /* '01' is the difference between the codes of A and T, and of G and C */
+    for(; i + 8 <= bytes; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, packed + i, 8);
+        word ^= 0x5555555555555555ull;
+        std::memcpy(packed + i, &word, 8);
+    }
+    for(; i < bytes; ++i)
+        packed[i] ^= 0x55;
+
+    if(size % 4)
+        packed[bytes - 1] &= 0xFF << (8 - (size % 4) * 2);
+}
+
+
+void reverseNucleotides(unsigned char *packed, size_t size, bool complement) {
+    size_t bytes = (size + 3) / 4;
+    unsigned shift = ((4 - size % 4) % 4) * 2;
+
+    activeKernels().reverse(packed, bytes, complement ? 0x55 : 0);
+
+    /* The padding of the last byte is now at the start of the first byte, shift it out */
+    if(shift == 0)
+        return;
+
+    size_t i = 0;
+    for(; i + 9 <= bytes; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, packed + i, 8);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+        word = (word << shift) | (packed[i + 8] >> (8 - shift));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+        std::memcpy(packed + i, &word, 8);
+    }
+    for(; i < bytes; ++i)
+        packed[i] = (packed[i] << shift) | (i + 1 < bytes ? packed[i + 1] >> (8 - shift) : 0);
+}
+
+
+void countNucleotides(const unsigned char *packed, size_t start, size_t count, size_t counts[4]) {
+    counts[0] = counts[1] = counts[2] = counts[3] = 0;
+    packed += start / 4;
+
+    /* Unaligned head, moved to the highest bits of its byte and counted as a padded byte */
+    if(start % 4 && count) {
+        size_t head = 4 - start % 4;
+        head = head < count ? head : count;
+        unsigned char byte = (*packed << (start % 4) * 2) & (0xFF << (8 - head * 2));
+
+        countBytes(&byte, 1, counts);
+        counts[0] -= 4 - head;
+        count -= head;
+        ++packed;
+    }
+
+    /* Whole bytes */
+    activeKernels().count(packed, count / 4, counts);
+    packed += count / 4;
+
+    /* Padded tail */
+    if(count % 4) {
+        unsigned char byte = packed[0] & (0xFF << (8 - (count % 4) * 2));
+        countBytes(&byte, 1, counts);
+        counts[0] -= 4 - count % 4;
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef NUCLEOTIDE_KERNELS
+#define NUCLEOTIDE_KERNELS
+
+#include <cstddef>
+
+/*
+    * Bulk kernels converting between ASCII Nucleotides and the 2-bit packed layout of DNASequence.
+    * 'A' or 'a' become '00' in binary
+    * 'T' or 't' become '01' in binary
+    * 'G' or 'g' become '10' in binary
+    * 'C' or 'c' become '11' in binary
+    * 4 Nucleotides are packed per byte from left to right, the first Nucleotide in the highest bits.
+    * On x86-64 the kernels are selected at runtime (CPUID) between a scalar, an SSE4.2 and an AVX2
+     implementation, so a single binary runs on every x86-64 machine.
+*/
+
+enum class KernelLevel {
+    Scalar,
+    SSE42,
+    AVX2
+};
+
+/*
+    * Returns the index of the first character that is not one of
+     'a', 't', 'g', 'c', 'A', 'T', 'G', 'C', or 'size' if every character is valid.
+*/
+size_t validateNucleotides(const char *sequence, size_t size);
+
+/*
+    * Validates and packs 'size' Nucleotides into 'packed', which must hold (size + 3) / 4 bytes.
+    * The unused bits of the last byte are set to zero.
+    * Returns the index of the first invalid character, or 'size' if every character is valid,
+     the content of 'packed' is unspecified when an invalid character is found.
+*/
+size_t packNucleotides(const char *sequence, size_t size, unsigned char *packed);
+
+/*
+    * Unpacks 'count' Nucleotides starting at Nucleotide 'start' of a packed sequence
+     into 'out' as upper case characters, no string terminator is written.
+*/
+void unpackNucleotides(const unsigned char *packed, size_t start, size_t count, char *out);
+
+/*
+    * Complements 'size' packed Nucleotides in place (A <-> T, G <-> C), 8 bytes per step.
+    * The unused bits of the last byte are set to zero.
+*/
+void complementNucleotides(unsigned char *packed, size_t size);
+
+/*
+    * Reverses 'size' packed Nucleotides in place, complementing them too if 'complement' is set.
+    * The bytes are reversed with their 4 Nucleotides (byte shuffles on SSE4.2/AVX2, shifts and masks
+     on 64-bit words otherwise), then the sequence is shifted back over the padding of the last byte.
+    * The unused bits of the last byte are set to zero.
+*/
+void reverseNucleotides(unsigned char *packed, size_t size, bool complement);
+
+/*
+    * Counts the Nucleotides [start, start + count) of a packed sequence into 'counts', indexed by
+     2-bit code: counts[0] A, counts[1] T, counts[2] G, counts[3] C.
+    * The high bit of a code is set for G and C and the low bit for T and C, so whole words are counted
+     with three popcounts (hardware popcnt on SSE4.2, nibble lookups on AVX2) and A is what remains.
+*/
+void countNucleotides(const unsigned char *packed, size_t start, size_t count, size_t counts[4]);
+
+/*
+    * Returns the kernel level currently in use.
+*/
+KernelLevel nucleotideKernelLevel();
+
+/*
+    * Selects the kernels to use, a level the CPU does not support is lowered to the best supported one.
+    * Returns the selected level.
+    * Selecting is not synchronized with concurrent kernel calls, it is meant for start up and benchmarks.
+*/
+KernelLevel selectNucleotideKernels(KernelLevel level);
+
+#endif
@@ -0,0 +1,237 @@
+#include "packed_search.hpp"
+#include "nucleotide_kernels.hpp"
+
+#include <cstring>
+
+/* ----- Packed Search Utility Functions ----- */
+
+int nucleotideCode(char nucleotide) {
+    switch(nucleotide) {
+        case 'a':
+        case 'A':
+            return 0b00;
+        case 't':
+        case 'T':
+            return 0b01;
+        case 'g':
+        case 'G':
+            return 0b10;
+        case 'c':
+        case 'C':
+            return 0b11;
+        default:
+            return -1;
+    }
+}
+
+
+/*
+    * Reads 8 bytes as a big endian word so that the first byte ends up in the highest bits.
+*/
+static inline uint64_t loadBigEndian(const unsigned char *bytes) {
+    uint64_t word;
+    std::memcpy(&word, bytes, sizeof(word));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    word = __builtin_bswap64(word);
+#endif
+    return word;
+}
+
+
+uint64_t loadPackedWord(const unsigned char *sequence, size_t size, size_t index) {
+    size_t byte = index / 4;
+    size_t bytes = (size + 3) / 4;
+    unsigned phase = (index % 4) * 2;
+    uint64_t word = 0;
+    uint64_t extra = 0;
+
+    if(byte >= bytes)
+        return 0;
+
+    if(byte + 9 <= bytes) {
+        word = loadBigEndian(sequence + byte);
+        extra = sequence[byte + 8];
+    }
+    else {
+        /* Near the end of the buffer, read byte by byte and pad with zeros */
+        for(size_t i = 0; i < 8; ++i)
+            word = (word << 8) | (byte + i < bytes ? sequence[byte + i] : 0);
+        extra = byte + 8 < bytes ? sequence[byte + 8] : 0;
+    }
+
+    if(phase)
+        word = (word << phase) | (extra >> (8 - phase));
+    return word;
+}
+
+
+/*
+    * Returns a mask of the first 'count' Nucleotides of a word, 'count' is in [0, 32].
+*/
+static inline uint64_t nucleotideMask(size_t count) {
+    return count >= 32 ? ~uint64_t(0) : count == 0 ? 0 : ~uint64_t(0) << (64 - count * 2);
+}
+
+
+void storePackedWord(unsigned char *sequence, size_t size, size_t index, uint64_t word, size_t count) {
+    size_t byte = index / 4;
+    unsigned phase = (index % 4) * 2;
+
+    if(index >= size)
+        return;
+    if(count > size - index)
+        count = size - index;
+
+    uint64_t mask = nucleotideMask(count);
+
+    /* Whole aligned word, a single big endian store */
+    if(phase == 0 && count == 32) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+        std::memcpy(sequence + byte, &word, sizeof(word));
+        return;
+    }
+
+    /* The word spans up to 9 bytes, the Nucleotides around it keep their value */
+    for(size_t i = 0; i < 9; ++i) {
+        unsigned char bits, bits_mask;
+        if(i < 8) {
+            bits = (word >> phase) >> (56 - i * 8);
+            bits_mask = (mask >> phase) >> (56 - i * 8);
+        }
+        else {
+            if(phase == 0)
+                break;
+            bits = word << (8 - phase);
+            bits_mask = mask << (8 - phase);
+        }
+        if(bits_mask)
+            sequence[byte + i] = (sequence[byte + i] & ~bits_mask) | (bits & bits_mask);
+    }
+}
+
+
+void movePackedNucleotides(unsigned char *sequence, size_t size, size_t from, size_t to, size_t count) {
+    if(from == to || count == 0)
+        return;
+
+    /* Same phase: realign the head, then move whole bytes and the masked last byte */
+    if(from % 4 == to % 4) {
+        size_t head = (4 - from % 4) % 4;
+        head = head < count ? head : count;
+
+        /* The partial head and tail bytes are read before anything is written */
+        uint64_t head_word = loadPackedWord(sequence, size, from);
+        from += head;
+        count -= head;
+
+        size_t bytes = count / 4;
+        size_t tail = count % 4;
+        uint64_t tail_word = tail ? loadPackedWord(sequence, size, from + bytes * 4) : 0;
+
+        std::memmove(sequence + (to + head) / 4, sequence + from / 4, bytes);
+        if(tail)
+            storePackedWord(sequence, size, to + head + bytes * 4, tail_word, tail);
+        if(head)
+            storePackedWord(sequence, size, to, head_word, head);
+        return;
+    }
+
+    if(to < from) {
+        for(size_t i = 0; i < count; i += 32) {
+            size_t chunk = count - i < 32 ? count - i : 32;
+            storePackedWord(sequence, size, to + i, loadPackedWord(sequence, size, from + i), chunk);
+        }
+    }
+    else {
+        for(size_t i = count; i > 0;) {
+            size_t chunk = i < 32 ? i : 32;
+            i -= chunk;
+            storePackedWord(sequence, size, to + i, loadPackedWord(sequence, size, from + i), chunk);
+        }
+    }
+}
+
+
+void copyPackedNucleotides(const unsigned char *source, size_t source_size, size_t from,
+                           unsigned char *destination, size_t destination_size, size_t to, size_t count) {
+    size_t done = 0;
+
+    /* Same phase: whole bytes are copied with memcpy once the head is aligned */
+    if(from % 4 == to % 4 && count >= 4) {
+        done = (4 - from % 4) % 4;
+        if(done)
+            storePackedWord(destination, destination_size, to, loadPackedWord(source, source_size, from), done);
+
+        size_t bytes = (count - done) / 4;
+        std::memcpy(destination + (to + done) / 4, source + (from + done) / 4, bytes);
+        done += bytes * 4;
+    }
+
+    for(; done < count; done += 32) {
+        size_t chunk = count - done < 32 ? count - done : 32;
+        storePackedWord(destination, destination_size, to + done,
+                        loadPackedWord(source, source_size, from + done), chunk);
+    }
+}
+
+
+void storePackedNucleotides(unsigned char *sequence, size_t size, size_t index, const char *nucleotides, size_t count) {
+    size_t done = 0;
+
+    /* Whole bytes are packed in place when the position is byte aligned */
+    if(index % 4 == 0) {
+        done = count - count % 4;
+        packNucleotides(nucleotides, done, sequence + index / 4);
+    }
+
+    for(; done < count; done += 32) {
+        size_t chunk = count - done < 32 ? count - done : 32;
+        unsigned char packed[8];
+
+        packNucleotides(nucleotides + done, chunk, packed);
+        storePackedWord(sequence, size, index + done, loadPackedWord(packed, chunk, 0), chunk);
+    }
+}
+
+
+bool packPattern(const char *subsequence, size_t size, PackedPattern &pattern) {
+    pattern.size = size;
+    pattern.words.assign(size ? (size + 31) / 32 : 1, 0);
+    pattern.last_mask = nucleotideMask(size % 32 ? size % 32 : (size ? 32 : 0));
+
+    for(size_t i = 0; i < size; ++i) {
+        int code = nucleotideCode(subsequence[i]);
+        if(code < 0)
+            return false;
+        pattern.words[i / 32] |= uint64_t(code) << (62 - (i % 32) * 2);
+    }
+    return true;
+}
+
+
+void packPattern(const unsigned char *sequence, size_t start, size_t size, PackedPattern &pattern) {
+    pattern.size = size;
+    pattern.words.assign(size ? (size + 31) / 32 : 1, 0);
+    pattern.last_mask = nucleotideMask(size % 32 ? size % 32 : (size ? 32 : 0));
+
+    for(size_t i = 0; i * 32 < size; ++i)
+        pattern.words[i] = loadPackedWord(sequence, start + size, start + i * 32);
+    pattern.words.back() &= pattern.last_mask;
+}
+
+
+bool matchPackedPattern(const unsigned char *sequence, size_t size, const PackedPattern &pattern,
+                        size_t index, size_t first_word) {
+    if(index > size || size - index < pattern.size)
+        return false;
+
+    size_t last_word = pattern.words.size() - 1;
+    for(size_t i = first_word; i <= last_word; ++i) {
+        uint64_t mask = i == last_word ? pattern.last_mask : ~uint64_t(0);
+        if((loadPackedWord(sequence, size, index + i * 32) ^ pattern.words[i]) & mask)
+            return false;
+    }
+    return true;
+}
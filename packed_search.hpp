@@ -0,0 +1,147 @@
+#ifndef PACKED_SEARCH
+#define PACKED_SEARCH
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/*
+    * Word-parallel search over 2-bit packed Nucleotides.
+    * The packed layout is the one used by DNASequence: 4 Nucleotides per byte, the first
+     Nucleotide in the two highest bits ('00' A, '01' T, '10' G, '11' C).
+    * Nucleotides are compared 32 at a time by loading the packed bytes into 64-bit words,
+     the first Nucleotide of a word is kept in its two highest bits so a shift left by
+     2 * phase realigns a word that starts in the middle of a byte.
+*/
+
+/*
+    * A subsequence packed into 64-bit words of 32 Nucleotides each.
+    * 'last_mask' selects the valid Nucleotides of the last word,
+     an empty pattern has a single word with a zero mask (it matches everywhere).
+*/
+struct PackedPattern {
+    std::vector<uint64_t> words;
+    uint64_t last_mask = 0;
+    size_t size = 0;
+};
+
+/*
+    * Returns the 2-bit code of a Nucleotide character, or -1 if the character is not
+     one of 'a', 't', 'g', 'c', 'A', 'T', 'G', 'C'.
+*/
+int nucleotideCode(char nucleotide);
+
+/*
+    * Loads the 32 Nucleotides starting at 'index' of a packed sequence holding 'size' Nucleotides.
+    * Nucleotides past the end of the packed buffer are read as zeros, never read out of bounds.
+*/
+uint64_t loadPackedWord(const unsigned char *sequence, size_t size, size_t index);
+
+/*
+    * Stores the first 'count' Nucleotides (at most 32) of 'word' at 'index' of a packed sequence
+     holding 'size' Nucleotides, the other Nucleotides of the sequence are left unchanged.
+*/
+void storePackedWord(unsigned char *sequence, size_t size, size_t index, uint64_t word, size_t count);
+
+/*
+    * Moves 'count' Nucleotides from index 'from' to index 'to' of a packed sequence holding 'size' Nucleotides,
+     the ranges may overlap (like memmove).
+    * When both indexes have the same position inside their byte the whole bytes are moved with memmove,
+     otherwise the Nucleotides are realigned 32 at a time through loadPackedWord and storePackedWord.
+*/
+void movePackedNucleotides(unsigned char *sequence, size_t size, size_t from, size_t to, size_t count);
+
+/*
+    * Copies 'count' Nucleotides from index 'from' of the packed sequence 'source' (holding 'source_size' Nucleotides)
+     to index 'to' of the packed sequence 'destination' (holding 'destination_size' Nucleotides).
+    * The buffers must not overlap, the other Nucleotides of the destination are left unchanged.
+*/
+void copyPackedNucleotides(const unsigned char *source, size_t source_size, size_t from,
+                           unsigned char *destination, size_t destination_size, size_t to, size_t count);
+
+/*
+    * Packs 'count' Nucleotide characters at index 'index' of a packed sequence holding 'size' Nucleotides.
+    * The characters must be valid Nucleotide values, the other Nucleotides of the sequence are left unchanged.
+*/
+void storePackedNucleotides(unsigned char *sequence, size_t size, size_t index, const char *nucleotides, size_t count);
+
+/*
+    * Reverses the order of the 32 Nucleotides of a word.
+*/
+constexpr uint64_t reversePackedWord(uint64_t word) {
+    word = __builtin_bswap64(word);
+    word = ((word >> 4) & 0x0F0F0F0F0F0F0F0Full) | ((word & 0x0F0F0F0F0F0F0F0Full) << 4);
+    return ((word >> 2) & 0x3333333333333333ull) | ((word & 0x3333333333333333ull) << 2);
+}
+
+/*
+    * Counts the occurrences of the Nucleotide 'code' in the first 'count' Nucleotides (at most 32) of a word.
+*/
+inline size_t countPackedCode(uint64_t word, int code, size_t count) {
+    const uint64_t low_bits = 0x5555555555555555ull;
+    uint64_t diff = word ^ (code * low_bits);
+    uint64_t matches = ~(diff | (diff >> 1)) & low_bits;
+
+    if(count < 32)
+        matches &= count ? ~uint64_t(0) << (64 - count * 2) : 0;
+    return __builtin_popcountll(matches);
+}
+
+/*
+    * Packs a Nucleotide string into 'pattern'.
+    * Returns false if the string has an invalid Nucleotide value, such a pattern matches nowhere.
+*/
+bool packPattern(const char *subsequence, size_t size, PackedPattern &pattern);
+
+/*
+    * Packs 'size' Nucleotides of a packed sequence starting at 'start' into 'pattern'.
+*/
+void packPattern(const unsigned char *sequence, size_t start, size_t size, PackedPattern &pattern);
+
+/*
+    * Returns true if the pattern occurs at 'index' of the packed sequence.
+    * Only the words from 'first_word' on are compared.
+*/
+bool matchPackedPattern(const unsigned char *sequence, size_t size, const PackedPattern &pattern,
+                        size_t index, size_t first_word = 0);
+
+/*
+    * Calls 'on_match(index)' in ascending order for every occurrence of the pattern that starts
+     in the range [begin, end) of the packed sequence.
+    * The scan stops early when 'on_match' returns false.
+    * Returns false if the scan was stopped by 'on_match', true otherwise.
+    * Each 32 Nucleotides of the sequence are loaded once, the candidates inside them are
+     produced by shifting the loaded word pair, so the first 32 Nucleotides of the pattern
+     are checked with a single xor/mask per candidate.
+*/
+template<typename Callback>
+bool scanPackedSequence(const unsigned char *sequence, size_t size, const PackedPattern &pattern,
+                        size_t begin, size_t end, Callback on_match) {
+    if(pattern.size > size)
+        return true;
+    if(end > size - pattern.size + 1)
+        end = size - pattern.size + 1;
+
+    const uint64_t first = pattern.words[0];
+    const uint64_t first_mask = pattern.words.size() == 1 ? pattern.last_mask : ~uint64_t(0);
+    const bool multi_word = pattern.words.size() > 1;
+
+    for(size_t index = begin; index < end; index += 32) {
+        uint64_t current = loadPackedWord(sequence, size, index);
+        uint64_t next = loadPackedWord(sequence, size, index + 32);
+        size_t candidates = end - index < 32 ? end - index : 32;
+
+        for(size_t shift = 0; shift < candidates; ++shift) {
+            uint64_t window = shift ? (current << (shift * 2)) | (next >> (64 - shift * 2)) : current;
+            if((window ^ first) & first_mask)
+                continue;
+            if(multi_word && !matchPackedPattern(sequence, size, pattern, index + shift, 1))
+                continue;
+            if(!on_match(index + shift))
+                return false;
+        }
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,284 @@
+#include "packed_sequence_file.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char PACKED_FILE_MAGIC[8] = {'D', 'N', 'A', 'P', 'A', 'C', 'K', '2'};
+static const uint32_t PACKED_FILE_VERSION = 1;
+
+static_assert(sizeof(PackedSequenceFileHeader) == 64, "the packed file header must be 64 bytes");
+static_assert(sizeof(PackedSequenceFileRecord) == 32, "a packed file record must be 32 bytes");
+
+/* ----- Packed Sequence File Utility Functions ----- */
+
+/*
+    * A 64-bit checksum processing the data 8 bytes at a time.
+    * The data can be added in several parts as long as every part but the last is a multiple of 8 bytes.
+*/
+struct PackedFileChecksum {
+    uint64_t state = 0;
+    uint64_t size = 0;
+
+    void update(const unsigned char *data, size_t data_size) {
+        const uint64_t prime = 0x9E3779B97F4A7C15ull;
+        uint64_t word;
+        size_t i = 0;
+
+        for(; i + 8 <= data_size; i += 8) {
+            std::memcpy(&word, data + i, 8);
+            this->state = (this->state ^ word) * prime;
+            this->state ^= this->state >> 29;
+        }
+        if(i < data_size) {
+            word = 0;
+            std::memcpy(&word, data + i, data_size - i);
+            this->state = (this->state ^ word) * prime;
+            this->state ^= this->state >> 29;
+        }
+        this->size += data_size;
+    }
+
+    uint64_t value() const {
+        uint64_t checksum = (this->state ^ this->size) * 0xC2B2AE3D27D4EB4Full;
+        return checksum ^ (checksum >> 32);
+    }
+};
+
+
+static uint64_t alignOffset(uint64_t offset) {
+    return (offset + 7) & ~uint64_t(7);
+}
+
+
+/* ----- Mapping ----- */
+
+struct PackedSequenceFile::Mapping {
+    const unsigned char *data;
+    size_t size;
+
+    Mapping(const unsigned char *data, size_t size) : data(data), size(size) {}
+
+    ~Mapping() {
+        munmap(const_cast<unsigned char*>(this->data), this->size);
+    }
+};
+
+
+/* ---------- PackedSequenceFile Methods ---------- */
+
+PackedSequenceFile::PackedSequenceFile() {
+    this->m_header = nullptr;
+    this->m_records = nullptr;
+}
+
+
+PackedSequenceFile::~PackedSequenceFile() {}
+
+
+bool PackedSequenceFile::open(const std::string &path, bool verify_checksum) {
+    struct stat file_stat;
+    int fd;
+    void *data;
+
+    this->close();
+
+    fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+        printf("PackedSequenceFile Error: could not open '%s'!\n", path.c_str());
+        return false;
+    }
+
+    if(fstat(fd, &file_stat) != 0 || (size_t)file_stat.st_size < sizeof(PackedSequenceFileHeader)) {
+        printf("PackedSequenceFile Error: '%s' is not a packed sequence file!\n", path.c_str());
+        ::close(fd);
+        return false;
+    }
+
+    data = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(data == MAP_FAILED) {
+        printf("PackedSequenceFile Error: could not map '%s'!\n", path.c_str());
+        return false;
+    }
+
+    std::shared_ptr<const Mapping> mapping =
+        std::make_shared<const Mapping>(static_cast<const unsigned char*>(data), file_stat.st_size);
+    const PackedSequenceFileHeader *header = reinterpret_cast<const PackedSequenceFileHeader*>(mapping->data);
+    const uint64_t file_size = mapping->size;
+
+    /* Check the header, then make sure every record lies inside the file */
+    bool valid = std::memcmp(header->magic, PACKED_FILE_MAGIC, sizeof(PACKED_FILE_MAGIC)) == 0 &&
+                 header->version == PACKED_FILE_VERSION &&
+                 header->file_size == file_size &&
+                 header->records_offset == sizeof(PackedSequenceFileHeader) &&
+                 header->records_offset + uint64_t(header->record_count) * sizeof(PackedSequenceFileRecord) <= file_size;
+
+    const PackedSequenceFileRecord *records =
+        reinterpret_cast<const PackedSequenceFileRecord*>(mapping->data + header->records_offset);
+
+    for(uint32_t i = 0; valid && i < header->record_count; ++i) {
+        const PackedSequenceFileRecord &record = records[i];
+        /* Not (size + 3) / 4, which wraps around for a size near UINT64_MAX */
+        uint64_t data_size = record.size / 4 + (record.size % 4 != 0);
+
+        valid = record.data_offset % 8 == 0 &&
+                record.data_offset <= file_size && data_size <= file_size - record.data_offset &&
+                record.name_offset <= file_size && record.name_size <= file_size - record.name_offset;
+    }
+
+    if(valid && verify_checksum) {
+        PackedFileChecksum checksum;
+        checksum.update(mapping->data + sizeof(PackedSequenceFileHeader), file_size - sizeof(PackedSequenceFileHeader));
+        valid = checksum.value() == header->checksum;
+    }
+
+    if(!valid) {
+        printf("PackedSequenceFile Error: '%s' is not a valid packed sequence file!\n", path.c_str());
+        return false;
+    }
+
+    this->m_mapping = std::move(mapping);
+    this->m_header = header;
+    this->m_records = records;
+    return true;
+}
+
+
+void PackedSequenceFile::close() {
+    this->m_mapping = nullptr;
+    this->m_header = nullptr;
+    this->m_records = nullptr;
+}
+
+
+bool PackedSequenceFile::isOpen() const {
+    return this->m_mapping != nullptr;
+}
+
+
+size_t PackedSequenceFile::getRecordCount() const {
+    return this->m_header ? this->m_header->record_count : 0;
+}
+
+
+std::string PackedSequenceFile::getRecordName(size_t index) const {
+    if(index >= this->getRecordCount())
+        return std::string();
+
+    const PackedSequenceFileRecord &record = this->m_records[index];
+    return std::string(reinterpret_cast<const char*>(this->m_mapping->data + record.name_offset), record.name_size);
+}
+
+
+size_t PackedSequenceFile::findRecord(const std::string &name) const {
+    for(size_t i = 0, count = this->getRecordCount(); i < count; ++i) {
+        const PackedSequenceFileRecord &record = this->m_records[i];
+        if(record.name_size == name.size() &&
+           std::memcmp(this->m_mapping->data + record.name_offset, name.data(), name.size()) == 0)
+            return i;
+    }
+    return -1;
+}
+
+
+DNASequence PackedSequenceFile::getSequence(size_t index) const {
+    if(index >= this->getRecordCount())
+        return DNASequence();
+
+    const PackedSequenceFileRecord &record = this->m_records[index];
+    return DNASequence(this->m_mapping->data + record.data_offset, record.size, this->m_mapping);
+}
+
+
+bool PackedSequenceFile::write(const std::string &path, const std::vector<std::string> &names,
+                               const std::vector<const DNASequence*> &sequences) {
+    if(names.size() != sequences.size()) {
+        printf("PackedSequenceFile Error: every sequence needs a name!\n");
+        return false;
+    }
+    for(const DNASequence *sequence : sequences) {
+        if(sequence->hasAmbiguousNucleotides()) {
+            printf("PackedSequenceFile Error: a sequence has ambiguous Nucleotides, which can not be stored!\n");
+            return false;
+        }
+    }
+
+    PackedSequenceFileHeader header;
+    std::vector<PackedSequenceFileRecord> records(sequences.size());
+    uint64_t offset;
+
+    /* Lay out the record table, the names and the 8 byte aligned packed data */
+    std::memcpy(header.magic, PACKED_FILE_MAGIC, sizeof(PACKED_FILE_MAGIC));
+    header.version = PACKED_FILE_VERSION;
+    header.record_count = sequences.size();
+    header.records_offset = sizeof(PackedSequenceFileHeader);
+    header.names_offset = header.records_offset + records.size() * sizeof(PackedSequenceFileRecord);
+    header.reserved = 0;
+
+    offset = header.names_offset;
+    for(size_t i = 0; i < records.size(); ++i) {
+        records[i].name_offset = offset;
+        records[i].name_size = names[i].size();
+        offset += names[i].size();
+    }
+
+    header.data_offset = offset = alignOffset(offset);
+    for(size_t i = 0; i < records.size(); ++i) {
+        records[i].data_offset = offset;
+        records[i].size = sequences[i]->getSize();
+        offset = alignOffset(offset + (records[i].size + 3) / 4);
+    }
+    header.file_size = offset;
+
+    /* The record table and the names are small, they are built in memory and padded up to the data */
+    std::vector<unsigned char> table(header.data_offset - header.records_offset, 0);
+    unsigned char *base = table.data() - header.records_offset;
+    const unsigned char padding[8] = {0};
+    PackedFileChecksum checksum;
+
+    if(!records.empty())
+        std::memcpy(base + header.records_offset, records.data(), records.size() * sizeof(PackedSequenceFileRecord));
+    for(size_t i = 0; i < records.size(); ++i)
+        std::memcpy(base + records[i].name_offset, names[i].data(), names[i].size());
+
+    /* The packed sequences are streamed to the file, the header is written last once the checksum is known */
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(table.data()), table.size());
+    checksum.update(table.data(), table.size());
+
+    for(size_t i = 0; i < records.size() && file; ++i) {
+        const unsigned char *data = sequences[i]->getPackedSequence();
+        size_t data_size = (records[i].size + 3) / 4;
+        size_t whole_words = data_size - data_size % 8;
+
+        if(data_size == 0)
+            continue;
+
+        file.write(reinterpret_cast<const char*>(data), data_size);
+        file.write(reinterpret_cast<const char*>(padding), alignOffset(data_size) - data_size);
+        checksum.update(data, whole_words);
+
+        /* Checksum the last partial word together with its padding */
+        if(whole_words != data_size) {
+            unsigned char last_word[8] = {0};
+            std::memcpy(last_word, data + whole_words, data_size - whole_words);
+            checksum.update(last_word, 8);
+        }
+    }
+
+    header.checksum = checksum.value();
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if(!file) {
+        printf("PackedSequenceFile Error: could not write '%s'!\n", path.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,93 @@
+#ifndef PACKED_SEQUENCE_FILE
+#define PACKED_SEQUENCE_FILE
+
+#include "dna_sequence.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+    * A binary file of named DNA Sequences stored in the 2-bit packed layout of DNASequence,
+     so it can be memory mapped and used without validating or packing anything.
+    * Layout (all integers in the byte order of the host that wrote the file, the structures are mapped
+     as they are, so a file is only readable on hosts of the same byte order):
+        header:       64 bytes, see PackedSequenceFileHeader
+        record table: one PackedSequenceFileRecord per sequence
+        names:        the record names, not null terminated
+        data:         the packed sequences, each one starting at an 8 byte aligned offset
+    * The checksum covers every byte after the header.
+*/
+struct PackedSequenceFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_count;
+    uint64_t records_offset;
+    uint64_t names_offset;
+    uint64_t data_offset;
+    uint64_t file_size;
+    uint64_t checksum;
+    uint64_t reserved;
+};
+
+struct PackedSequenceFileRecord {
+    uint64_t data_offset;
+    uint64_t size;
+    uint64_t name_offset;
+    uint64_t name_size;
+};
+
+/*
+    * A memory mapped packed sequence file.
+    * The sequences returned by getSequence are read-only DNASequences pointing into the mapping,
+     they keep the mapping alive after the file is closed or destroyed.
+    * On error, a message is printed and the file is left closed.
+*/
+class PackedSequenceFile {
+public:
+    PackedSequenceFile();
+    ~PackedSequenceFile();
+
+    /*
+        * Maps the file at 'path' and checks its header and record table.
+        * If 'verify_checksum' is true the whole file is read to verify its checksum,
+         otherwise only the header and the record table are touched.
+        * Returns false if the file could not be mapped or is not a valid packed sequence file.
+    */
+    bool open(const std::string &path, bool verify_checksum = false);
+    void close();
+    bool isOpen() const;
+
+    size_t getRecordCount() const;
+    std::string getRecordName(size_t index) const;
+
+    /*
+        * Returns the index of the first record named 'name', or -1(max value for size_t) if there is none.
+    */
+    size_t findRecord(const std::string &name) const;
+
+    /*
+        * Returns the sequence of the record at 'index' without copying it,
+         an empty sequence is returned if the index is out of range.
+    */
+    DNASequence getSequence(size_t index) const;
+
+    /*
+        * Writes the sequences and their names to a packed sequence file at 'path'.
+        * 'names' and 'sequences' must have the same size.
+        * The format has no room for ambiguous Nucleotides, a sequence with some is rejected.
+        * Returns false if the file could not be written.
+    */
+    static bool write(const std::string &path, const std::vector<std::string> &names,
+                      const std::vector<const DNASequence*> &sequences);
+
+private:
+    struct Mapping;
+
+    std::shared_ptr<const Mapping> m_mapping;
+    const PackedSequenceFileHeader *m_header;
+    const PackedSequenceFileRecord *m_records;
+};
+
+#endif
@@ -0,0 +1,229 @@
+#include "rank_directory.hpp"
+#include "nucleotide_kernels.hpp"
+#include "packed_search.hpp"
+
+#include <algorithm>
+
+static const size_t BLOCK_SIZE = 512;
+static const size_t SUPERBLOCK_SIZE = 65536;
+static const size_t BLOCKS_PER_SUPERBLOCK = SUPERBLOCK_SIZE / BLOCK_SIZE;
+
+/* ---------- RankDirectory Methods ---------- */
+
+RankDirectory::RankDirectory() {
+    this->m_sequence = nullptr;
+    this->m_offset = 0;
+    this->m_size = 0;
+    this->build();
+}
+
+
+RankDirectory::RankDirectory(const DNASequence &sequence) {
+    this->m_sequence = sequence.getPackedSequence();
+    this->m_offset = 0;
+    this->m_size = sequence.getSize();
+    this->m_ambiguous = sequence.getAmbiguousRuns();
+    this->build();
+}
+
+
+RankDirectory::RankDirectory(const DNASequenceView &view) {
+    this->m_sequence = view.getPackedSequence();
+    this->m_offset = view.getOffset();
+    this->m_size = view.getSize();
+    this->m_ambiguous = view.getAmbiguousRuns();
+    this->build();
+}
+
+
+size_t RankDirectory::rank(char base, size_t index) const {
+    int code = nucleotideCode(base);
+
+    if(code < 0)
+        return 0;
+    if(index > this->m_size)
+        index = this->m_size;
+
+    /* The ambiguous Nucleotides are packed as 'A' */
+    if(code == 0)
+        return this->blockRank(0, index) - this->ambiguousRank(index);
+    return this->blockRank(code, index);
+}
+
+
+size_t RankDirectory::countBase(char base, size_t start_index, size_t end_index) const {
+    if(end_index > this->m_size)
+        end_index = this->m_size;
+    if(start_index >= end_index)
+        return 0;
+
+    return this->rank(base, end_index) - this->rank(base, start_index);
+}
+
+
+NucleotideComposition RankDirectory::getComposition(size_t start_index, size_t end_index) const {
+    NucleotideComposition composition;
+
+    if(end_index > this->m_size)
+        end_index = this->m_size;
+    if(start_index >= end_index)
+        return composition;
+
+    /* A short range is cheaper to count directly */
+    if(end_index - start_index <= BLOCK_SIZE) {
+        composition = countComposition(this->m_sequence, this->m_offset + start_index, this->m_offset + end_index);
+    }
+    else {
+        composition.a = this->blockRank(0, end_index) - this->blockRank(0, start_index);
+        composition.t = this->blockRank(1, end_index) - this->blockRank(1, start_index);
+        composition.g = this->blockRank(2, end_index) - this->blockRank(2, start_index);
+        composition.c = this->blockRank(3, end_index) - this->blockRank(3, start_index);
+    }
+
+    composition.n = this->ambiguousRank(end_index) - this->ambiguousRank(start_index);
+    composition.a -= composition.n;
+    return composition;
+}
+
+
+size_t RankDirectory::select(char base, size_t n) const {
+    int code = nucleotideCode(base);
+
+    if(code < 0 || n == 0 || this->rank(base, this->m_size) < n)
+        return -1;
+
+    /* The directory counts the ambiguous Nucleotides as 'A', search the index on the corrected rank instead */
+    if(code == 0 && !this->m_ambiguous.empty()) {
+        size_t low = 0, high = this->m_size;
+        while(low < high) {
+            size_t middle = low + (high - low) / 2;
+            if(this->rank(base, middle + 1) < n)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        return low;
+    }
+
+    /* Last superblock, then last block, with fewer than 'n' occurrences before it */
+    size_t low = 0, high = this->m_superblock_ranks.size() / 4;
+    while(high - low > 1) {
+        size_t middle = (low + high) / 2;
+        if(this->m_superblock_ranks[middle * 4 + code] < n)
+            low = middle;
+        else
+            high = middle;
+    }
+    size_t remaining = n - this->m_superblock_ranks[low * 4 + code];
+
+    size_t first_block = low * BLOCKS_PER_SUPERBLOCK;
+    size_t last_block = first_block + BLOCKS_PER_SUPERBLOCK;
+    low = first_block;
+    high = last_block < this->m_block_ranks.size() ? last_block : this->m_block_ranks.size();
+    while(high - low > 1) {
+        size_t middle = (low + high) / 2;
+        if(((this->m_block_ranks[middle] >> (code * 16)) & 0xFFFF) < remaining)
+            low = middle;
+        else
+            high = middle;
+    }
+    remaining -= (this->m_block_ranks[low] >> (code * 16)) & 0xFFFF;
+
+    /* Scan the words of the block, then the Nucleotides of the word holding the occurrence */
+    size_t end = this->m_offset + this->m_size;
+    for(size_t index = low * BLOCK_SIZE; index < this->m_size; index += 32) {
+        size_t count = this->m_size - index < 32 ? this->m_size - index : 32;
+        uint64_t word = loadPackedWord(this->m_sequence, end, this->m_offset + index);
+        size_t occurrences = countPackedCode(word, code, count);
+
+        if(remaining > occurrences) {
+            remaining -= occurrences;
+            continue;
+        }
+
+        uint64_t diff = word ^ (code * 0x5555555555555555ull);
+        uint64_t matches = ~(diff | (diff >> 1)) & 0x5555555555555555ull;
+        for(; remaining > 1; --remaining)
+            matches &= ~(uint64_t(1) << (63 - __builtin_clzll(matches)));
+        return index + __builtin_clzll(matches) / 2;
+    }
+    return -1;
+}
+
+
+size_t RankDirectory::getSize() const {
+    return this->m_size;
+}
+
+
+/* -- Private -- */
+
+void RankDirectory::build() {
+    size_t counts[4];
+    uint64_t totals[4] = {0, 0, 0, 0};
+    uint64_t superblock[4] = {0, 0, 0, 0};
+
+    this->m_superblock_ranks.reserve((this->m_size / SUPERBLOCK_SIZE + 1) * 4);
+    this->m_block_ranks.reserve(this->m_size / BLOCK_SIZE + 1);
+
+    size_t ambiguous = 0;
+    this->m_ambiguous_ranks.reserve(this->m_ambiguous.size());
+    for(const AmbiguousRun &run : this->m_ambiguous) {
+        this->m_ambiguous_ranks.push_back(ambiguous);
+        ambiguous += run.size;
+    }
+
+    /* One entry per block starting at or before the end, so rank(m_size) needs no special case */
+    for(size_t index = 0; index <= this->m_size; index += BLOCK_SIZE) {
+        if(index % SUPERBLOCK_SIZE == 0) {
+            for(int code = 0; code < 4; ++code) {
+                superblock[code] = totals[code];
+                this->m_superblock_ranks.push_back(totals[code]);
+            }
+        }
+
+        uint64_t block = 0;
+        for(int code = 0; code < 4; ++code)
+            block |= (totals[code] - superblock[code]) << (code * 16);
+        this->m_block_ranks.push_back(block);
+
+        size_t count = this->m_size - index < BLOCK_SIZE ? this->m_size - index : BLOCK_SIZE;
+        countNucleotides(this->m_sequence, this->m_offset + index, count, counts);
+        for(int code = 0; code < 4; ++code)
+            totals[code] += counts[code];
+    }
+}
+
+
+/*
+    * Returns the number of times 'code' occurs in [0, index), 'index' is at most m_size.
+*/
+size_t RankDirectory::blockRank(int code, size_t index) const {
+    size_t block = index / BLOCK_SIZE;
+    size_t end = this->m_offset + this->m_size;
+    size_t count = this->m_superblock_ranks[index / SUPERBLOCK_SIZE * 4 + code] +
+                   ((this->m_block_ranks[block] >> (code * 16)) & 0xFFFF);
+
+    size_t position = block * BLOCK_SIZE;
+    for(; position + 32 <= index; position += 32)
+        count += countPackedCode(loadPackedWord(this->m_sequence, end, this->m_offset + position), code, 32);
+    if(position < index)
+        count += countPackedCode(loadPackedWord(this->m_sequence, end, this->m_offset + position), code, index - position);
+    return count;
+}
+
+
+/*
+    * Returns the number of ambiguous Nucleotides in [0, index).
+*/
+size_t RankDirectory::ambiguousRank(size_t index) const {
+    auto run = std::partition_point(this->m_ambiguous.begin(), this->m_ambiguous.end(),
+        [index](const AmbiguousRun &run) { return run.start < index; });
+
+    if(run == this->m_ambiguous.begin())
+        return 0;
+
+    --run;
+    size_t before = this->m_ambiguous_ranks[run - this->m_ambiguous.begin()];
+    return before + (index - run->start < run->size ? index - run->start : run->size);
+}
@@ -0,0 +1,78 @@
+#ifndef RANK_DIRECTORY
+#define RANK_DIRECTORY
+
+#include "dna_sequence.hpp"
+#include "dna_sequence_view.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/*
+    * A rank/select directory over the packed Nucleotides of a DNASequence, built once and queried many times.
+    * Every 512 Nucleotides the counts of the 4 Nucleotides since the last 65536 Nucleotide boundary are stored
+     as 16-bit values in a single word, and every 65536 Nucleotides the absolute counts are stored.
+     The directory takes 64 bits per 1024 bits of packed sequence, about 6.3%.
+    * A rank query reads one directory word and popcounts at most 16 words of the sequence, so counting
+     a Nucleotide in any range [i, j) costs O(1) whatever its length.
+    * A select query binary searches the directory, then the words of a single 512 Nucleotide block.
+    * The ambiguous Nucleotides of the sequence are not counted as any base: their runs are kept with the
+     prefix sums of their sizes, an 'A' rank subtracts the ambiguous Nucleotides before the index in O(log runs).
+    * The directory reads the sequence it was built from, which must outlive it and must not be modified.
+*/
+class RankDirectory {
+public:
+    /* Create an empty directory. */
+    RankDirectory();
+
+    RankDirectory(const DNASequence &sequence);
+    RankDirectory(const DNASequenceView &view);
+
+    /*
+        * Returns the number of times the Nucleotide 'base' ('A', 'T', 'G' or 'C') occurs before 'index'.
+        * 'index' is clamped to the sequence size, an invalid Nucleotide value occurs 0 times.
+    */
+    size_t rank(char base, size_t index) const;
+
+    /*
+        * Returns the number of times 'base' occurs in the range [start_index, end_index).
+        * If 'end_index' is not specified or bigger than the sequence size, the range ends with the sequence.
+    */
+    size_t countBase(char base, size_t start_index, size_t end_index = -1) const;
+
+    /*
+        * Returns the number of each Nucleotide in the range [start_index, end_index), clamped as for countBase.
+        * The ambiguous Nucleotides of the range are counted in 'n'.
+    */
+    NucleotideComposition getComposition(size_t start_index, size_t end_index = -1) const;
+
+    /*
+        * Returns the index of the 'n'th occurrence of 'base'.
+        * If 'base' does not occur 'n' times, -1(max value for size_t) is returned.
+    */
+    size_t select(char base, size_t n) const;
+
+    /* Getters */
+    size_t getSize() const;
+
+private:
+    void build();
+    size_t blockRank(int code, size_t index) const;
+    size_t ambiguousRank(size_t index) const;
+
+    /* The packed data, the indexed Nucleotides are [m_offset, m_offset + m_size) */
+    const unsigned char *m_sequence;
+    size_t m_offset;
+    size_t m_size;
+
+    /* Absolute counts every 65536 Nucleotides, 4 per entry */
+    std::vector<uint64_t> m_superblock_ranks;
+
+    /* Counts since the superblock every 512 Nucleotides, 4 x 16 bits per word */
+    std::vector<uint64_t> m_block_ranks;
+
+    /* Ambiguous runs relative to m_offset, and the number of ambiguous Nucleotides before each run */
+    std::vector<AmbiguousRun> m_ambiguous;
+    std::vector<size_t> m_ambiguous_ranks;
+};
+
+#endif
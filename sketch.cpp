@@ -0,0 +1,267 @@
+#include "sketch.hpp"
+#include "kmer.hpp"
+#include "packed_search.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+/* ----- Sketch Utility Functions ----- */
+
+static size_t clampK(size_t k) {
+    return k < 1 ? 1 : k > 32 ? 32 : k;
+}
+
+
+/*
+    * Returns the k-mer starting at 'index' of the sequence, or the smallest of it and its
+     reverse complement if 'canonical' is set (as KmerIterator::getCanonical).
+*/
+static uint64_t loadKmer(const DNASequenceView &sequence, size_t index, size_t k, bool canonical) {
+    uint64_t word = loadPackedWord(sequence.getPackedSequence(), sequence.getOffset() + sequence.getSize(),
+                                   sequence.getOffset() + index);
+    uint64_t mask = k == 32 ? ~uint64_t(0) : (uint64_t(1) << (k * 2)) - 1;
+    uint64_t kmer = word >> (64 - k * 2);
+
+    if(!canonical)
+        return kmer;
+
+    /* The padding after the k-mer is complemented too, the reversal moves it to the highest bits */
+    uint64_t reverse = reversePackedWord((kmer << (64 - k * 2)) ^ 0x5555555555555555ull) & mask;
+    return kmer < reverse ? kmer : reverse;
+}
+
+
+/*
+    * The minimum of a window sliding over consecutive k-mers, kept in a monotone deque: the k-mers that
+     may still become the minimum, by increasing index and increasing hash, in a ring buffer of 'w' entries.
+*/
+class MonotoneWindow {
+public:
+    MonotoneWindow(size_t w) : m_entries(w), m_w(w), m_head(0), m_count(0) {}
+
+    void clear() {
+        this->m_head = this->m_count = 0;
+    }
+
+    /* Adds the k-mer following the last one, the k-mers leaving the window are dropped */
+    void push(const SketchKmer &kmer) {
+        while(this->m_count && this->m_entries[this->m_head].index + this->m_w <= kmer.index) {
+            this->m_head = this->m_head + 1 == this->m_w ? 0 : this->m_head + 1;
+            --this->m_count;
+        }
+
+        /* A larger hash before the new k-mer can never be the minimum again, an equal one stays (leftmost) */
+        while(this->m_count && this->m_entries[this->slot(this->m_count - 1)].hash > kmer.hash)
+            --this->m_count;
+
+        this->m_entries[this->slot(this->m_count++)] = kmer;
+    }
+
+    const SketchKmer& minimum() const {
+        return this->m_entries[this->m_head];
+    }
+
+private:
+    size_t slot(size_t position) const {
+        size_t slot = this->m_head + position;
+        return slot >= this->m_w ? slot - this->m_w : slot;
+    }
+
+    std::vector<SketchKmer> m_entries;
+    size_t m_w;
+    size_t m_head;
+    size_t m_count;
+};
+
+
+std::vector<SketchKmer> findMinimizers(const DNASequenceView &sequence, size_t w, size_t k, bool canonical) {
+    std::vector<SketchKmer> minimizers;
+
+    if(w == 0)
+        return minimizers;
+
+    /* A random sequence has about 2 / (w + 1) minimizers per k-mer */
+    minimizers.reserve(sequence.getSize() / (w + 1) * 2);
+
+    KmerIterator kmers(sequence, clampK(k));
+    MonotoneWindow window(w);
+    size_t run_start = 0;
+    size_t next_index = -1;
+
+    while(kmers.next()) {
+        size_t index = kmers.getIndex();
+        uint64_t kmer = canonical ? kmers.getCanonical() : kmers.getKmer();
+
+        /* The iterator skipped ambiguous Nucleotides, the windows start over after them */
+        if(index != next_index) {
+            window.clear();
+            run_start = index;
+        }
+        next_index = index + 1;
+
+        window.push({index, kmer, hashKmer(kmer)});
+        if(index + 1 - run_start < w)
+            continue;
+
+        const SketchKmer &minimum = window.minimum();
+        if(minimizers.empty() || minimizers.back().index != minimum.index)
+            minimizers.push_back(minimum);
+    }
+    return minimizers;
+}
+
+
+std::vector<SketchKmer> findOpenSyncmers(const DNASequenceView &sequence, size_t k, size_t s, size_t t, bool canonical) {
+    std::vector<SketchKmer> syncmers;
+
+    k = clampK(k);
+    s = s < 1 ? 1 : s > k ? k : s;
+    if(t > k - s)
+        return syncmers;
+
+    /* A k-mer is the window of the k - s + 1 s-mers it contains */
+    size_t w = k - s + 1;
+    KmerIterator smers(sequence, s);
+    MonotoneWindow window(w);
+    size_t run_start = 0;
+    size_t next_index = -1;
+
+    while(smers.next()) {
+        size_t index = smers.getIndex();
+        uint64_t smer = canonical ? smers.getCanonical() : smers.getKmer();
+
+        if(index != next_index) {
+            window.clear();
+            run_start = index;
+        }
+        next_index = index + 1;
+
+        window.push({index, smer, hashKmer(smer)});
+        if(index + 1 - run_start < w)
+            continue;
+
+        size_t start = index + 1 - w;
+        if(window.minimum().index - start == t) {
+            uint64_t kmer = loadKmer(sequence, start, k, canonical);
+            syncmers.push_back({start, kmer, hashKmer(kmer)});
+        }
+    }
+    return syncmers;
+}
+
+
+/* ---------- SketchKmer Methods ---------- */
+
+bool SketchKmer::operator==(const SketchKmer &kmer) const {
+    return this->index == kmer.index && this->kmer == kmer.kmer && this->hash == kmer.hash;
+}
+
+
+/* ---------- MinHashSketch Methods ---------- */
+
+MinHashSketch::MinHashSketch(size_t k, size_t sketch_size, bool canonical) {
+    this->m_k = clampK(k);
+    this->m_sketch_size = sketch_size ? sketch_size : 1;
+    this->m_canonical = canonical;
+    this->m_threshold = ~uint64_t(0);
+}
+
+
+void MinHashSketch::add(const DNASequenceView &sequence) {
+    KmerIterator kmers(sequence, this->m_k);
+
+    while(kmers.next()) {
+        uint64_t hash = hashKmer(this->m_canonical ? kmers.getCanonical() : kmers.getKmer());
+
+        if(hash > this->m_threshold)
+            continue;
+
+        this->m_pending.push_back(hash);
+        if(this->m_pending.size() >= this->m_sketch_size)
+            this->merge();
+    }
+    this->merge();
+}
+
+
+double MinHashSketch::jaccard(const MinHashSketch &sketch) const {
+    if(this->m_k != sketch.m_k || this->m_canonical != sketch.m_canonical) {
+        printf("MinHashSketch Error: the sketches must have the same k and be both canonical or not!\n");
+        return 0;
+    }
+
+    /* Walk the smallest hashes of the union, counting those found in both sketches */
+    const std::vector<uint64_t> &hashes = this->m_hashes;
+    const std::vector<uint64_t> &other = sketch.m_hashes;
+    size_t size = std::min(this->m_sketch_size, sketch.m_sketch_size);
+    size_t i = 0, j = 0;
+    size_t union_size = 0, shared = 0;
+
+    for(; union_size < size && (i < hashes.size() || j < other.size()); ++union_size) {
+        if(j == other.size() || (i < hashes.size() && hashes[i] < other[j]))
+            ++i;
+        else if(i == hashes.size() || other[j] < hashes[i])
+            ++j;
+        else {
+            ++shared;
+            ++i;
+            ++j;
+        }
+    }
+    return union_size ? double(shared) / union_size : 0;
+}
+
+
+double MinHashSketch::mashDistance(const MinHashSketch &sketch) const {
+    double jaccard = this->jaccard(sketch);
+
+    if(jaccard == 0)
+        return 1;
+    return -std::log(2 * jaccard / (1 + jaccard)) / this->m_k;
+}
+
+
+/* -- Getters -- */
+
+const std::vector<uint64_t>& MinHashSketch::getHashes() const {
+    return this->m_hashes;
+}
+
+
+size_t MinHashSketch::getK() const {
+    return this->m_k;
+}
+
+
+size_t MinHashSketch::getSketchSize() const {
+    return this->m_sketch_size;
+}
+
+
+bool MinHashSketch::isCanonical() const {
+    return this->m_canonical;
+}
+
+
+/* -- Private -- */
+
+/*
+    * Merges the pending hashes into the sketch, keeps its smallest distinct hashes and lowers the threshold.
+*/
+void MinHashSketch::merge() {
+    if(this->m_pending.empty())
+        return;
+
+    std::sort(this->m_pending.begin(), this->m_pending.end());
+    size_t middle = this->m_hashes.size();
+    this->m_hashes.insert(this->m_hashes.end(), this->m_pending.begin(), this->m_pending.end());
+    std::inplace_merge(this->m_hashes.begin(), this->m_hashes.begin() + middle, this->m_hashes.end());
+    this->m_hashes.erase(std::unique(this->m_hashes.begin(), this->m_hashes.end()), this->m_hashes.end());
+    this->m_pending.clear();
+
+    if(this->m_hashes.size() >= this->m_sketch_size) {
+        this->m_hashes.resize(this->m_sketch_size);
+        this->m_threshold = this->m_hashes.back();
+    }
+}
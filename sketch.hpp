@@ -0,0 +1,95 @@
+#ifndef SKETCH
+#define SKETCH
+
+#include "dna_sequence.hpp"
+#include "dna_sequence_view.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/*
+    * Sketches of the k-mers (k <= 32) of a sequence, to compare sequences without aligning them.
+    * The k-mers are read by KmerIterator and hashed with hashKmer. With 'canonical' set (the default) a k-mer
+     and its reverse complement are the same k-mer, so a sequence and its reverse complement have the same sketch.
+    * The k-mers covering an ambiguous Nucleotide are skipped, a window never spans them.
+*/
+
+/*
+    * A k-mer selected by a sketch: the index of its first Nucleotide, the k-mer (canonical if requested)
+     in the layout of KmerIterator::getKmer, and its hash.
+*/
+struct SketchKmer {
+    size_t index;
+    uint64_t kmer;
+    uint64_t hash;
+
+    bool operator==(const SketchKmer &kmer) const;
+};
+
+/*
+    * Returns the (w, k)-minimizers of the sequence: the k-mer of smallest hash of every window of 'w'
+     consecutive k-mers, the leftmost one on ties. A k-mer selected by consecutive windows is returned once.
+    * The window minimum is kept in a monotone deque of at most 'w' k-mers, so each k-mer costs O(1)
+     amortized whatever 'w'.
+    * 'k' is clamped to [1, 32], nothing is returned if 'w' is 0.
+*/
+std::vector<SketchKmer> findMinimizers(const DNASequenceView &sequence, size_t w, size_t k, bool canonical = true);
+
+/*
+    * Returns the open syncmers of the sequence: the k-mers whose s-mer of smallest hash (the leftmost
+     one on ties) starts at offset 't' of the k-mer.
+    * Unlike minimizers, whether a k-mer is selected only depends on the k-mer itself, so the same k-mers
+     are selected in every sequence they appear in.
+    * 'k' is clamped to [1, 32] and 's' to [1, k], nothing is returned if 't' is bigger than k - s.
+*/
+std::vector<SketchKmer> findOpenSyncmers(const DNASequenceView &sequence, size_t k, size_t s, size_t t = 0,
+                                         bool canonical = true);
+
+/*
+    * A bottom-s MinHash sketch: the 's' smallest distinct k-mer hashes of every sequence added to it.
+    * Two sketches of the same k estimate the Jaccard index of the k-mer sets of their sequences,
+     and the Mash distance derived from it (an estimate of the mutation rate between them).
+    * Adding a sequence costs a comparison per k-mer, the hashes below the current threshold are
+     buffered and merged into the sketch once the buffer holds 's' of them.
+*/
+class MinHashSketch {
+public:
+    /* Create an empty sketch of k-mers of length 'k' (clamped to [1, 32]) keeping 'sketch_size' hashes. */
+    MinHashSketch(size_t k = 21, size_t sketch_size = 1000, bool canonical = true);
+
+    /* Adds the k-mers of the sequence to the sketch. */
+    void add(const DNASequenceView &sequence);
+
+    /*
+        * Estimates the Jaccard index of the k-mer sets of the two sketches, from the 's' smallest
+         hashes of their union (s being the smallest sketch size) and how many of them are in both.
+        * Returns 0 and prints an error message if the sketches have a different k or orientation.
+    */
+    double jaccard(const MinHashSketch &sketch) const;
+
+    /*
+        * The Mash distance: -1/k * ln(2j / (1 + j)), where j is the estimated Jaccard index.
+        * Returns 1 when the sketches have no hash in common, and on error (see jaccard).
+    */
+    double mashDistance(const MinHashSketch &sketch) const;
+
+    /* The hashes of the sketch, sorted, at most getSketchSize() of them */
+    const std::vector<uint64_t>& getHashes() const;
+    size_t getK() const;
+    size_t getSketchSize() const;
+    bool isCanonical() const;
+
+private:
+    void merge();
+
+    size_t m_k;
+    size_t m_sketch_size;
+    bool m_canonical;
+    std::vector<uint64_t> m_hashes;
+
+    /* Hashes below the threshold waiting to be merged, the threshold is the largest hash of a full sketch */
+    std::vector<uint64_t> m_pending;
+    uint64_t m_threshold;
+};
+
+#endif
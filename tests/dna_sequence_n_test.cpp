@@ -0,0 +1,86 @@
+#include "dna_sequence_n.hpp"
+#include "kmer.hpp"
+#include "test_checks.hpp"
+
+#include <random>
+#include <string>
+
+/*
+    * Checks DNASequenceN against the DNASequence operations it mirrors, and that the loads and parses
+     of a bad range or string fail without producing a valid looking sequence.
+*/
+
+template<size_t K>
+static void checkWindows(const std::string &text, DNASequence &sequence) {
+    DNASequenceView view(sequence);
+    KmerIterator kmers(sequence, K);
+
+    for(size_t start = 0; start + K <= text.size(); ++start) {
+        DNASequenceN<K> loaded;
+        DNASequenceN<K> from_view;
+        DNASequenceN<K> parsed;
+        std::string expected = text.substr(start, K);
+        bool ambiguous = expected.find('N') != std::string::npos;
+
+        TEST_CHECK(DNASequenceN<K>::tryLoad(sequence, start, loaded) == !ambiguous);
+        TEST_CHECK(DNASequenceN<K>::tryLoad(view, start, from_view) == !ambiguous);
+        TEST_CHECK(DNASequenceN<K>::tryParse(text.data() + start, K, parsed) == !ambiguous);
+        if(ambiguous) {
+            TEST_CHECK(loaded == DNASequenceN<K>() && from_view == DNASequenceN<K>() && parsed == DNASequenceN<K>());
+            continue;
+        }
+
+        TEST_CHECK(loaded.getSequenceStr() == expected);
+        TEST_CHECK(from_view == loaded && parsed == loaded);
+
+        DNASequence reverse = sequence.slice(start, start + K);
+        reverse.reverseComplement();
+        TEST_CHECK(loaded.reverseComplement().getSequenceStr() == reverse.getSequenceStr());
+        TEST_CHECK(loaded.toSequence() == sequence.slice(start, start + K));
+
+        /* The k-mers skip the ambiguous Nucleotides, so they follow the loaded windows */
+        TEST_CHECK(kmers.next() && kmers.getIndex() == start);
+        TEST_CHECK(DNASequenceN<K>::fromWords(kmers.getKmerWords()) == loaded);
+        TEST_CHECK(DNASequenceN<K>::fromWords(kmers.getCanonicalWords()) == loaded.canonical());
+    }
+
+    /* Ranges out of the sequence */
+    DNASequenceN<K> loaded;
+    TEST_CHECK(!DNASequenceN<K>::tryLoad(sequence, text.size() - K + 1, loaded));
+    TEST_CHECK(!DNASequenceN<K>::tryLoad(sequence, size_t(-1), loaded));
+    TEST_CHECK(!DNASequenceN<K>::tryLoad(view.view(1, K), 0, loaded));
+}
+
+
+int main() {
+    std::mt19937_64 random(11);
+    std::string text;
+
+    for(size_t i = 0; i < 300; ++i)
+        text.push_back("ATGC"[random() % 4]);
+    text.replace(150, 5, "NNNNN");
+    DNASequence sequence(text);
+
+    checkWindows<1>(text, sequence);
+    checkWindows<7>(text, sequence);
+    checkWindows<32>(text, sequence);
+    checkWindows<33>(text, sequence);
+    checkWindows<64>(text, sequence);
+
+    /* Parsing */
+    DNASequenceN<4> parsed("ACGT");
+    TEST_CHECK(!DNASequenceN<4>::tryParse("ACGN", 4, parsed) && parsed.getSequenceStr() == "ACGT");
+    TEST_CHECK(!DNASequenceN<4>::tryParse("ACG", 3, parsed));
+    TEST_CHECK(DNASequenceN<4>::tryParse("ggca", 4, parsed) && parsed.getSequenceStr() == "GGCA");
+    TEST_CHECK(DNASequenceN<4>("ACGN").getSequenceStr() == "AAAA");
+    TEST_CHECK(DNASequenceN<4>(std::string("ACGTA")).getSequenceStr() == "AAAA");
+
+    /* Ordering follows the Nucleotide strings, the hashes follow equality */
+    constexpr DNASequenceN<3> acg("ACG");
+    static_assert(acg < DNASequenceN<3>("ACT") && DNASequenceN<3>("CAA") > DNASequenceN<3>("ATT"));
+    static_assert(acg.reverseComplement() == DNASequenceN<3>("CGT"));
+    TEST_CHECK(acg.hash() == DNASequenceN<3>("acg").hash());
+    TEST_CHECK(acg[0] == 'A' && acg[2] == 'G' && acg[3] == '-');
+
+    return testResult("dna_sequence_n");
+}
@@ -0,0 +1,107 @@
+#include "fastx_reader.hpp"
+#include "test_checks.hpp"
+
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+    * Reads FASTA and FASTQ inputs at chunk sizes from 1 byte, so every state of the reader
+     is cut by a chunk boundary somewhere, and checks the records.
+*/
+
+static const size_t CHUNK_SIZES[] = {1, 2, 3, 7, 64, 1 << 20};
+
+
+static std::vector<FastxRecord> readRecords(const std::string &input, size_t chunk_size) {
+    std::istringstream stream(input);
+    FastxReader reader(stream, chunk_size);
+    std::vector<FastxRecord> records;
+
+    for(FastxRecord &record : reader)
+        records.push_back(std::move(record));
+    return records;
+}
+
+
+static bool hasRecord(std::vector<FastxRecord> &records, size_t index, const std::string &name,
+                      const std::string &sequence, const std::string &quality) {
+    return index < records.size() && records[index].name == name &&
+           records[index].sequence.getSequenceStr() == sequence && records[index].quality == quality;
+}
+
+
+static bool hasError(const std::vector<FastxRecord> &records, size_t index, FastxError error, size_t offset,
+                     char character = 0) {
+    return index < records.size() && !records[index].isValid() && records[index].error == error &&
+           records[index].error_offset == offset && records[index].error_character == character;
+}
+
+
+int main() {
+    for(size_t chunk_size : CHUNK_SIZES) {
+        std::vector<FastxRecord> records;
+
+        /* The last line may end without a newline */
+        records = readRecords("@r1\nACGT\n+\nIIII\n@r2\nGGCC\n+\nJJJJ", chunk_size);
+        TEST_CHECK(records.size() == 2);
+        TEST_CHECK(hasRecord(records, 0, "r1", "ACGT", "IIII"));
+        TEST_CHECK(hasRecord(records, 1, "r2", "GGCC", "JJJJ"));
+        TEST_CHECK(records.size() == 2 && records[0].isValid() && records[1].isValid());
+
+        records = readRecords(">s1\nACGT\nTT\n>s2\nGGCCA", chunk_size);
+        TEST_CHECK(records.size() == 2);
+        TEST_CHECK(hasRecord(records, 0, "s1", "ACGTTT", ""));
+        TEST_CHECK(hasRecord(records, 1, "s2", "GGCCA", ""));
+
+        /* Multi-line records, "\r\n" line endings, blank lines, lower case and mixed FASTA and FASTQ */
+        records = readRecords("\n>s1 first\r\nacgtacgtac\r\nGT\r\n\r\n@r1\r\nAC\r\nGT\r\n+r1\r\nII\r\nII\r\n>s2\r\n", chunk_size);
+        TEST_CHECK(records.size() == 3);
+        TEST_CHECK(hasRecord(records, 0, "s1 first", "ACGTACGTACGT", ""));
+        TEST_CHECK(hasRecord(records, 1, "r1", "ACGT", "IIII"));
+        TEST_CHECK(hasRecord(records, 2, "s2", "", ""));
+
+        /* Ambiguous Nucleotides are kept as runs */
+        records = readRecords(">s1\nACGTNNNNNNNNNNAC\nRYACGT\n", chunk_size);
+        TEST_CHECK(records.size() == 1);
+        TEST_CHECK(hasRecord(records, 0, "s1", "ACGTNNNNNNNNNNACRYACGT", ""));
+
+        /* An empty FASTQ record is valid */
+        records = readRecords("@r1\n\n+\n\n@r2\nA\n+\nI", chunk_size);
+        TEST_CHECK(records.size() == 2);
+        TEST_CHECK(hasRecord(records, 0, "r1", "", ""));
+        TEST_CHECK(records.size() == 2 && records[0].isValid());
+        TEST_CHECK(hasRecord(records, 1, "r2", "A", "I"));
+
+        /* Malformed records have an empty sequence and their first error, the next records are read */
+        records = readRecords(">s1\nACG\nNNX-T\n>s2\nACGT\n", chunk_size);
+        TEST_CHECK(records.size() == 2);
+        TEST_CHECK(hasRecord(records, 0, "s1", "", ""));
+        TEST_CHECK(hasError(records, 0, FastxError::InvalidNucleotide, 5, 'X'));
+        TEST_CHECK(hasRecord(records, 1, "s2", "ACGT", ""));
+        TEST_CHECK(records.size() == 2 && records[1].isValid());
+
+        records = readRecords("@r1\nACGT\n+\nIIIII\n@r2\nAC\n+\nII\n", chunk_size);
+        TEST_CHECK(records.size() == 2);
+        TEST_CHECK(hasRecord(records, 0, "r1", "", "IIIII"));
+        TEST_CHECK(hasError(records, 0, FastxError::ExtraQuality, 4));
+        TEST_CHECK(hasRecord(records, 1, "r2", "AC", "II"));
+
+        records = readRecords("@r1\nACGT\n+\nIII", chunk_size);
+        TEST_CHECK(records.size() == 1);
+        TEST_CHECK(hasRecord(records, 0, "r1", "", "III"));
+        TEST_CHECK(hasError(records, 0, FastxError::TruncatedRecord, 3));
+
+        records = readRecords("@r1\nACGT\n", chunk_size);
+        TEST_CHECK(records.size() == 1);
+        TEST_CHECK(hasRecord(records, 0, "r1", "", ""));
+        TEST_CHECK(hasError(records, 0, FastxError::TruncatedRecord, 0));
+
+        /* No record at all */
+        TEST_CHECK(readRecords("", chunk_size).empty());
+        TEST_CHECK(readRecords("\n\r\n", chunk_size).empty());
+    }
+
+    return testResult("fastx_reader");
+}
@@ -0,0 +1,166 @@
+#include "fm_index.hpp"
+#include "test_checks.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+/*
+    * Checks the FM-index queries against a naive search on random sequences, saves and loads
+     the index, then loads corrupted copies of the file, which must be rejected and leave the index empty.
+*/
+
+static std::vector<size_t> naiveFind(const std::string &sequence, const std::string &subsequence) {
+    std::vector<size_t> indexes;
+
+    for(size_t index = 0; index + subsequence.size() <= sequence.size(); ++index) {
+        if(sequence.compare(index, subsequence.size(), subsequence) == 0)
+            indexes.push_back(index);
+    }
+    return indexes;
+}
+
+
+static void checkQueries(const FMIndex &index, const std::string &sequence, std::mt19937_64 &random) {
+    for(size_t query = 0; query < 200; ++query) {
+        std::string subsequence;
+
+        /* Half of the subsequences are taken from the sequence, so most of them have hits */
+        size_t size = 1 + random() % 12;
+        if(query % 2 == 0 && size <= sequence.size())
+            subsequence = sequence.substr(random() % (sequence.size() - size + 1), size);
+        else
+            for(size_t i = 0; i < size; ++i)
+                subsequence.push_back("ATGC"[random() % 4]);
+
+        std::vector<size_t> expected = naiveFind(sequence, subsequence);
+        TEST_CHECK(index.countSubsequence(subsequence) == expected.size());
+        TEST_CHECK(index.findSubsequence(subsequence) == expected);
+        TEST_CHECK(index.hasSubsequence(subsequence) == !expected.empty());
+    }
+}
+
+
+static std::vector<char> readFile(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+
+/* Loads 'bytes' as an index file, returns whether it loaded and checks a failed load left the index empty */
+static bool loadBytes(const std::vector<char> &bytes) {
+    FMIndex index;
+    {
+        std::ofstream file("fm_index_test_corrupted.idx", std::ios::binary | std::ios::trunc);
+        file.write(bytes.data(), bytes.size());
+    }
+
+    bool loaded = index.load("fm_index_test_corrupted.idx");
+    TEST_CHECK(loaded || (index.getSize() == 0 && index.countSubsequence("A") == 0));
+    return loaded;
+}
+
+
+static void patch(std::vector<char> &bytes, size_t offset, uint64_t value) {
+    std::memcpy(bytes.data() + offset, &value, sizeof(value));
+}
+
+
+int main() {
+    std::mt19937_64 random(7);
+
+    /* Repetitive and random sequences, across the 256 row blocks and the 512 row sample ranks */
+    for(size_t size : {1, 2, 31, 100, 257, 1000, 5000}) {
+        std::string sequence;
+        for(size_t i = 0; i < size; ++i)
+            sequence.push_back(size < 1000 ? "AT"[random() % 2] : "ATGC"[random() % 4]);
+
+        for(size_t sa_sample_rate : {1, 5, 32}) {
+            FMIndex index(DNASequence(sequence), sa_sample_rate);
+            TEST_CHECK(index.getSize() == size);
+            checkQueries(index, sequence, random);
+
+            TEST_CHECK(index.countSubsequence("") == size + 1);
+            TEST_CHECK(index.countSubsequence("ACGN") == 0);
+            TEST_CHECK(index.countSubsequence(sequence + "A") == 0);
+        }
+    }
+
+    /* A sequence with ambiguous Nucleotides is not indexed */
+    FMIndex ambiguous(DNASequence("ACGTNNNNNNNNNNACGT"));
+    TEST_CHECK(ambiguous.getSize() == 0);
+    TEST_CHECK(ambiguous.countSubsequence("AAAA") == 0);
+
+    /* Save and load */
+    std::string sequence;
+    for(size_t i = 0; i < 3000; ++i)
+        sequence.push_back("ATGC"[random() % 4]);
+
+    FMIndex saved(DNASequence(sequence), 16);
+    TEST_CHECK(saved.save("fm_index_test.idx"));
+
+    FMIndex loaded;
+    TEST_CHECK(loaded.load("fm_index_test.idx"));
+    TEST_CHECK(loaded.getSize() == saved.getSize() && loaded.getSASampleRate() == 16);
+    checkQueries(loaded, sequence, random);
+
+    TEST_CHECK(!loaded.load("fm_index_test_missing.idx"));
+    TEST_CHECK(loaded.getSize() == 0);
+
+    /* Corrupted files: the fixed fields, then six vectors stored as their size and their values */
+    std::vector<char> bytes = readFile("fm_index_test.idx");
+    TEST_CHECK(loadBytes(bytes));
+
+    const size_t value_sizes[6] = {8, 8, 2, 8, 8, 8};
+    size_t vector_offsets[6];
+    size_t offset = 8 + 3 * 8 + 5 * 8;
+    for(size_t i = 0; i < 6; ++i) {
+        uint64_t size;
+        std::memcpy(&size, bytes.data() + offset, sizeof(size));
+        vector_offsets[i] = offset;
+        offset += sizeof(size) + size * value_sizes[i];
+    }
+    TEST_CHECK(offset == bytes.size());
+
+    std::vector<char> corrupted = bytes;
+    patch(corrupted, 0, 0);
+    TEST_CHECK(!loadBytes(corrupted));
+
+    TEST_CHECK(!loadBytes(std::vector<char>(bytes.begin(), bytes.end() - 1)));
+    TEST_CHECK(!loadBytes(std::vector<char>(bytes.begin(), bytes.begin() + 40)));
+
+    /* A size larger than the rest of the file, for every vector */
+    for(size_t i = 0; i < 6; ++i) {
+        corrupted = bytes;
+        patch(corrupted, vector_offsets[i], uint64_t(1) << 60);
+        TEST_CHECK(!loadBytes(corrupted));
+    }
+
+    /* A sequence size that does not match the BWT, a sentinel row out of the BWT, a sample rate of 0 */
+    corrupted = bytes;
+    patch(corrupted, 8, sequence.size() + 64);
+    TEST_CHECK(!loadBytes(corrupted));
+    corrupted = bytes;
+    patch(corrupted, 8 + 16, sequence.size() + 1);
+    TEST_CHECK(!loadBytes(corrupted));
+    corrupted = bytes;
+    patch(corrupted, 8 + 8, 0);
+    TEST_CHECK(!loadBytes(corrupted));
+
+    /* One sample less than the sampled rows */
+    corrupted = std::vector<char>(bytes.begin(), bytes.end() - 8);
+    uint64_t samples;
+    std::memcpy(&samples, corrupted.data() + vector_offsets[5], sizeof(samples));
+    patch(corrupted, vector_offsets[5], samples - 1);
+    TEST_CHECK(!loadBytes(corrupted));
+
+    /* A sampled row more than the samples and the sample ranks count */
+    corrupted = bytes;
+    corrupted[vector_offsets[3] + 8] ^= 0x02;
+    TEST_CHECK(!loadBytes(corrupted));
+
+    return testResult("fm_index");
+}
@@ -0,0 +1,125 @@
+#include "nucleotide_kernels.hpp"
+#include "test_checks.hpp"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+/*
+    * Runs the SSE4.2 and AVX2 kernels supported by the CPU against the scalar ones on random
+     sequences of 0 to 300 Nucleotides, at misaligned addresses, with invalid characters inserted.
+*/
+
+struct KernelResults {
+    size_t valid;
+    size_t packed_valid;
+    std::vector<unsigned char> packed;
+    std::vector<char> unpacked;
+    std::vector<unsigned char> complemented;
+    std::vector<unsigned char> reversed;
+    std::vector<unsigned char> reverse_complemented;
+    size_t counts[4];
+};
+
+
+static KernelResults runKernels(const char *sequence, size_t size, const unsigned char *packed,
+                                size_t start, size_t count) {
+    KernelResults results;
+    size_t bytes = (size + 3) / 4;
+
+    results.valid = validateNucleotides(sequence, size);
+
+    /* The packed bytes are only specified when every character is valid */
+    results.packed.assign(bytes + 1, 0xAA);
+    results.packed_valid = packNucleotides(sequence, size, results.packed.data());
+    if(results.packed_valid != size)
+        results.packed.clear();
+
+    results.unpacked.assign(count + 1, '-');
+    unpackNucleotides(packed, start, count, results.unpacked.data());
+
+    results.complemented.assign(packed, packed + bytes);
+    complementNucleotides(results.complemented.data(), size);
+
+    results.reversed.assign(packed, packed + bytes);
+    reverseNucleotides(results.reversed.data(), size, false);
+    results.reverse_complemented.assign(packed, packed + bytes);
+    reverseNucleotides(results.reverse_complemented.data(), size, true);
+
+    countNucleotides(packed, start, count, results.counts);
+    return results;
+}
+
+
+int main() {
+    const char *NUCLEOTIDES = "ATGCatgc";
+    const char *INVALID = "NnUX-\n\0\xC3";
+    std::mt19937_64 random(2024);
+    std::vector<KernelLevel> levels;
+
+    for(KernelLevel level : {KernelLevel::SSE42, KernelLevel::AVX2}) {
+        if(selectNucleotideKernels(level) == level)
+            levels.push_back(level);
+    }
+    if(levels.empty())
+        printf("nucleotide_kernels: no SIMD kernel level is supported, only the scalar kernels run\n");
+
+    for(size_t iteration = 0; iteration < 20000; ++iteration) {
+        size_t size = random() % 301;
+        size_t misalignment = random() % 32;
+
+        /* A misaligned copy of random Nucleotides, some with an invalid character */
+        std::vector<char> buffer(misalignment + size + 1);
+        char *sequence = buffer.data() + misalignment;
+        for(size_t i = 0; i < size; ++i)
+            sequence[i] = NUCLEOTIDES[random() % 8];
+        if(size && random() % 3 == 0)
+            sequence[random() % size] = INVALID[random() % 8];
+
+        /* A packed sequence of 'size' random Nucleotides with its padding cleared, at a misaligned address */
+        std::vector<unsigned char> packed_buffer(misalignment + (size + 3) / 4 + 1);
+        unsigned char *packed = packed_buffer.data() + misalignment;
+        for(size_t i = 0; i < (size + 3) / 4; ++i)
+            packed[i] = random();
+        if(size % 4)
+            packed[(size + 3) / 4 - 1] &= 0xFF << (8 - (size % 4) * 2);
+
+        size_t start = size ? random() % (size + 1) : 0;
+        size_t count = size - start ? random() % (size - start + 1) : 0;
+
+        selectNucleotideKernels(KernelLevel::Scalar);
+        KernelResults expected = runKernels(sequence, size, packed, start, count);
+
+        for(KernelLevel level : levels) {
+            selectNucleotideKernels(level);
+            KernelResults results = runKernels(sequence, size, packed, start, count);
+
+            TEST_CHECK(results.valid == expected.valid);
+            TEST_CHECK(results.packed_valid == expected.packed_valid);
+            TEST_CHECK(results.packed == expected.packed);
+            TEST_CHECK(results.unpacked == expected.unpacked);
+            TEST_CHECK(results.complemented == expected.complemented);
+            TEST_CHECK(results.reversed == expected.reversed);
+            TEST_CHECK(results.reverse_complemented == expected.reverse_complemented);
+            TEST_CHECK(std::memcmp(results.counts, expected.counts, sizeof(results.counts)) == 0);
+        }
+    }
+
+    /* The scalar kernels against the definition of the layout */
+    selectNucleotideKernels(KernelLevel::Scalar);
+    unsigned char packed[3];
+    char unpacked[10];
+    size_t counts[4];
+    TEST_CHECK(packNucleotides("ATGCatgcA", 9, packed) == 9);
+    TEST_CHECK(packed[0] == 0b00011011 && packed[1] == 0b00011011 && packed[2] == 0);
+    unpackNucleotides(packed, 0, 9, unpacked);
+    TEST_CHECK(std::memcmp(unpacked, "ATGCATGCA", 9) == 0);
+    countNucleotides(packed, 1, 8, counts);
+    TEST_CHECK(counts[0] == 2 && counts[1] == 2 && counts[2] == 2 && counts[3] == 2);
+    reverseNucleotides(packed, 9, true);
+    unpackNucleotides(packed, 0, 9, unpacked);
+    TEST_CHECK(std::memcmp(unpacked, "TGCATGCAT", 9) == 0);
+    TEST_CHECK(validateNucleotides("ACGTN", 5) == 4);
+
+    return testResult("nucleotide_kernels");
+}
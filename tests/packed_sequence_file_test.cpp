@@ -0,0 +1,113 @@
+#include "packed_sequence_file.hpp"
+#include "test_checks.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+/*
+    * Writes a packed sequence file, reads it back, then opens corrupted copies of it,
+     which must be rejected and leave the file closed.
+*/
+
+static std::vector<char> readFile(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+
+static void writeFile(const std::string &path, const std::vector<char> &bytes) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(bytes.data(), bytes.size());
+}
+
+
+/* Opens a copy of 'bytes' with the 8 bytes at 'offset' replaced by 'value' */
+static bool openPatched(std::vector<char> bytes, size_t offset, uint64_t value, bool verify_checksum) {
+    PackedSequenceFile file;
+
+    std::memcpy(bytes.data() + offset, &value, sizeof(value));
+    writeFile("packed_sequence_file_test_patched.dnap", bytes);
+
+    bool opened = file.open("packed_sequence_file_test_patched.dnap", verify_checksum);
+    TEST_CHECK(opened == file.isOpen());
+    return opened;
+}
+
+
+int main() {
+    const std::string path = "packed_sequence_file_test.dnap";
+    DNASequence first("ACGTACGTTTGCA");
+    DNASequence second("");
+    DNASequence third(std::string(1000, 'G') + "ATC");
+
+    TEST_CHECK(PackedSequenceFile::write(path, {"first", "second", "third"}, {&first, &second, &third}));
+
+    /* Round trip, with and without the checksum */
+    for(bool verify_checksum : {false, true}) {
+        PackedSequenceFile file;
+        TEST_CHECK(file.open(path, verify_checksum));
+        TEST_CHECK(file.getRecordCount() == 3);
+        TEST_CHECK(file.getRecordName(2) == "third");
+        TEST_CHECK(file.findRecord("second") == 1);
+        TEST_CHECK(file.findRecord("fourth") == size_t(-1));
+        TEST_CHECK(file.getSequence(0) == first);
+        TEST_CHECK(file.getSequence(1).getSize() == 0);
+        TEST_CHECK(file.getSequence(2) == third);
+        TEST_CHECK(file.getSequence(3).getSize() == 0);
+    }
+
+    /* The sequences keep the mapping alive once the file is closed */
+    DNASequence mapped;
+    {
+        PackedSequenceFile file;
+        TEST_CHECK(file.open(path));
+        mapped = file.getSequence(2);
+    }
+    TEST_CHECK(mapped == third);
+
+    /* Ambiguous Nucleotides can not be stored */
+    DNASequence ambiguous("ACGTNNNNACGT");
+    TEST_CHECK(!PackedSequenceFile::write("packed_sequence_file_test_ambiguous.dnap", {"ambiguous"}, {&ambiguous}));
+
+    std::vector<char> bytes = readFile(path);
+    const size_t first_record = sizeof(PackedSequenceFileHeader);
+    TEST_CHECK(bytes.size() > first_record + 3 * sizeof(PackedSequenceFileRecord));
+
+    /* A missing, a too short and a truncated file */
+    PackedSequenceFile file;
+    TEST_CHECK(!file.open("packed_sequence_file_test_missing.dnap"));
+    writeFile("packed_sequence_file_test_short.dnap", std::vector<char>(bytes.begin(), bytes.begin() + 10));
+    TEST_CHECK(!file.open("packed_sequence_file_test_short.dnap"));
+    writeFile("packed_sequence_file_test_short.dnap", std::vector<char>(bytes.begin(), bytes.end() - 1));
+    TEST_CHECK(!file.open("packed_sequence_file_test_short.dnap"));
+    TEST_CHECK(!file.isOpen());
+
+    /* Corrupted header fields */
+    TEST_CHECK(!openPatched(bytes, offsetof(PackedSequenceFileHeader, magic), 0, false));
+    TEST_CHECK(!openPatched(bytes, offsetof(PackedSequenceFileHeader, file_size), bytes.size() + 8, false));
+    TEST_CHECK(!openPatched(bytes, offsetof(PackedSequenceFileHeader, records_offset), 0, false));
+
+    /* More records than the file holds */
+    uint64_t counts;
+    std::memcpy(&counts, bytes.data() + offsetof(PackedSequenceFileHeader, version), sizeof(counts));
+    counts = (counts & 0xFFFFFFFFull) | (uint64_t(0xFFFFFFFF) << 32);
+    TEST_CHECK(!openPatched(bytes, offsetof(PackedSequenceFileHeader, version), counts, false));
+
+    /* Records pointing out of the file, a size whose byte count would wrap around and a misaligned offset */
+    const size_t third_record = first_record + 2 * sizeof(PackedSequenceFileRecord);
+    TEST_CHECK(!openPatched(bytes, third_record + offsetof(PackedSequenceFileRecord, size), 4000, false));
+    TEST_CHECK(!openPatched(bytes, third_record + offsetof(PackedSequenceFileRecord, size), ~uint64_t(0), false));
+    TEST_CHECK(!openPatched(bytes, third_record + offsetof(PackedSequenceFileRecord, data_offset), bytes.size() + 8, false));
+    TEST_CHECK(!openPatched(bytes, third_record + offsetof(PackedSequenceFileRecord, data_offset), 1, false));
+    TEST_CHECK(!openPatched(bytes, third_record + offsetof(PackedSequenceFileRecord, name_size), ~uint64_t(0), false));
+
+    /* A changed Nucleotide is only caught by the checksum */
+    TEST_CHECK(openPatched(bytes, bytes.size() - 8, 0x0123456789ABCDEFull, false));
+    TEST_CHECK(!openPatched(bytes, bytes.size() - 8, 0x0123456789ABCDEFull, true));
+
+    return testResult("packed_sequence_file");
+}
@@ -0,0 +1,32 @@
+#ifndef TEST_CHECKS
+#define TEST_CHECKS
+
+#include <cstdio>
+
+/*
+    * The checks of the test programs, run by ctest.
+    * A failed check prints its file, line and condition and the test keeps going,
+     testResult prints the number of failures and is returned from main (non zero on failure).
+*/
+
+inline int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+
+#define TEST_CHECK(condition)                                                               \
+    do {                                                                                    \
+        if(!(condition)) {                                                                  \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);            \
+            ++testFailures();                                                               \
+        }                                                                                   \
+    } while(0)
+
+
+inline int testResult(const char *name) {
+    printf("%s: %d failed checks\n", name, testFailures());
+    return testFailures() ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,102 @@
+#include "vcf_reader.hpp"
+#include "test_checks.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+    * Parses VCF data lines, well formed and malformed, and checks the records and their variants.
+*/
+
+static std::vector<VcfRecord> readRecords(const std::string &input) {
+    std::istringstream stream(input);
+    VcfReader reader(stream);
+    std::vector<VcfRecord> records;
+    VcfRecord record;
+
+    while(reader.next(record))
+        records.push_back(record);
+    return records;
+}
+
+
+int main() {
+    const std::string header =
+        "##fileformat=VCFv4.2\n"
+        "##contig=<ID=chr1>\n"
+        "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\tS1\tS2\n";
+
+    std::istringstream stream(header +
+        "chr1\t3\trs1\tA\tG\t50\tPASS\t.\tGT\t0|1\t1/1\n"
+        "chr1\t10\t.\tAC\tA,ACGT\t.\t.\tDP=3\tDP:GT\t7:2|0\t9:.|1\r\n"
+        "chr2\t5\t.\tG\t<DEL>,*\t.\t.\t.\tGT:DP\t1:4\t2\n"
+        "chr1\t20\t.\tT\tN\t.\t.\t.\n"
+        "chr1\t21\t.\tT\t.\t.\t.\t.\tGT\t0\t0\n");
+    VcfReader reader(stream);
+    std::vector<VcfRecord> records;
+    VcfRecord record;
+    while(reader.next(record))
+        records.push_back(record);
+
+    TEST_CHECK((reader.getSamples() == std::vector<std::string>{"S1", "S2"}));
+    TEST_CHECK(records.size() == 5);
+    if(records.size() != 5)
+        return testResult("vcf_reader");
+
+    /* Phased and unphased genotypes, 1-based positions */
+    TEST_CHECK(records[0].chromosome == "chr1" && records[0].position == 2);
+    TEST_CHECK(records[0].reference == "A" && (records[0].alternates == std::vector<std::string>{"G"}));
+    TEST_CHECK((records[0].alleles == std::vector<int>{0, 1, 1, 1}));
+
+    /* GT after another FORMAT field, a missing allele and a "\r\n" line ending */
+    TEST_CHECK(records[1].position == 9 && (records[1].alternates == std::vector<std::string>{"A", "ACGT"}));
+    TEST_CHECK((records[1].alleles == std::vector<int>{2, 0, -1, 1}));
+
+    /* Haploid genotypes, symbolic alternates */
+    TEST_CHECK(records[2].chromosome == "chr2");
+    TEST_CHECK((records[2].alleles == std::vector<int>{1, 2}));
+
+    /* No FORMAT column, no alternate */
+    TEST_CHECK(records[3].alleles.empty() && (records[3].alternates == std::vector<std::string>{"N"}));
+    TEST_CHECK(records[4].alternates.empty() && (records[4].alleles == std::vector<int>{0, 0}));
+
+    /* The variants of the haplotypes */
+    Variant variant;
+    TEST_CHECK(!records[0].getVariant(0, variant));
+    TEST_CHECK(records[0].getVariant(1, variant) && variant.position == 2 && variant.alternate == "G");
+    TEST_CHECK(records[1].getVariant(0, variant) && variant.reference == "AC" && variant.alternate == "ACGT");
+    TEST_CHECK(!records[1].getVariant(2, variant));
+    TEST_CHECK(!records[1].getVariant(4, variant));
+    TEST_CHECK(!records[2].getVariant(0, variant) && !records[2].getVariant(1, variant));
+    TEST_CHECK(records[3].getVariant(5, variant) && variant.alternate == "N");
+    TEST_CHECK(!records[4].getVariant(0, variant));
+
+    std::vector<Variant> variants = haplotypeVariants(records, 3);
+    TEST_CHECK(variants.size() == 3 && variants[0].position == 2 && variants[1].alternate == "A" &&
+               variants[2].alternate == "N");
+
+    /* Malformed lines are skipped: no ALT column, a position that is not a number, 0 or with a suffix, no REF */
+    records = readRecords(header +
+        "chr1\t3\t.\tA\n"
+        "chr1\tx\t.\tA\tG\n"
+        "chr1\t0\t.\tA\tG\n"
+        "chr1\t3a\t.\tA\tG\n"
+        "chr1\t-3\t.\tA\tG\n"
+        "chr1\t3\t.\t\tG\n"
+        "\n"
+        "chr1\t4\t.\tA\tT\n");
+    TEST_CHECK(records.size() == 1 && records[0].position == 3 && records[0].alleles.empty());
+
+    /* No header, sites only, and records of a single chromosome */
+    std::istringstream sites("chr1\t1\t.\tA\tG\nchr2\t2\t.\tC\tT\nchr1\t3\t.\tG\tC\n");
+    VcfReader sites_reader(sites);
+    TEST_CHECK(sites_reader.getSamples().empty());
+    records = sites_reader.readChromosome("chr1");
+    TEST_CHECK(records.size() == 2 && records[0].position == 0 && records[1].position == 2);
+
+    TEST_CHECK(readRecords("").empty());
+    TEST_CHECK(readRecords(header).empty());
+
+    return testResult("vcf_reader");
+}
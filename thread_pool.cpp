@@ -0,0 +1,168 @@
+#include "thread_pool.hpp"
+
+/* Set on the threads currently running tasks of a pool, nested loops run serially */
+static thread_local bool in_parallel_loop = false;
+
+struct ThreadPool::Range {
+    std::mutex mutex;
+    size_t begin = 0;
+    size_t end = 0;
+};
+
+
+/* ---------- ThreadPool Methods ---------- */
+
+ThreadPool::ThreadPool(size_t threads) {
+    if(threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if(threads == 0)
+        threads = 1;
+
+    this->m_thread_count = threads;
+    this->m_ranges = std::unique_ptr<Range[]>(new Range[threads]);
+    this->m_task = nullptr;
+    this->m_generation = 0;
+    this->m_running = 0;
+    this->m_stop = false;
+
+    /* Slot 0 belongs to the thread calling parallelFor */
+    for(size_t slot = 1; slot < threads; ++slot)
+        this->m_workers.emplace_back(&ThreadPool::workerLoop, this, slot);
+}
+
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(this->m_mutex);
+        this->m_stop = true;
+    }
+    this->m_start.notify_all();
+
+    for(std::thread &worker : this->m_workers)
+        worker.join();
+}
+
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)> &task) {
+    if(count == 0)
+        return;
+
+    if(in_parallel_loop || this->m_thread_count == 1 || count == 1) {
+        for(size_t i = 0; i < count; ++i)
+            task(i);
+        return;
+    }
+
+    std::lock_guard<std::mutex> loop_lock(this->m_loop_mutex);
+
+    /* Give every thread a contiguous range of the loop */
+    for(size_t slot = 0; slot < this->m_thread_count; ++slot) {
+        std::lock_guard<std::mutex> lock(this->m_ranges[slot].mutex);
+        this->m_ranges[slot].begin = count * slot / this->m_thread_count;
+        this->m_ranges[slot].end = count * (slot + 1) / this->m_thread_count;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->m_mutex);
+        this->m_task = &task;
+        this->m_running = this->m_thread_count;
+        ++this->m_generation;
+    }
+    this->m_start.notify_all();
+
+    this->runTasks(0);
+
+    std::unique_lock<std::mutex> lock(this->m_mutex);
+    this->m_done.wait(lock, [this] { return this->m_running == 0; });
+    this->m_task = nullptr;
+}
+
+
+size_t ThreadPool::getThreadCount() const {
+    return this->m_thread_count;
+}
+
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+
+/* -- Private -- */
+
+void ThreadPool::workerLoop(size_t slot) {
+    size_t generation = 0;
+
+    while(true) {
+        {
+            std::unique_lock<std::mutex> lock(this->m_mutex);
+            this->m_start.wait(lock, [&] { return this->m_stop || this->m_generation != generation; });
+            if(this->m_stop)
+                return;
+            generation = this->m_generation;
+        }
+        this->runTasks(slot);
+    }
+}
+
+
+void ThreadPool::runTasks(size_t slot) {
+    size_t task;
+    bool nested = in_parallel_loop;
+
+    in_parallel_loop = true;
+    while(this->takeTask(slot, task))
+        (*this->m_task)(task);
+    in_parallel_loop = nested;
+
+    std::lock_guard<std::mutex> lock(this->m_mutex);
+    if(--this->m_running == 0)
+        this->m_done.notify_one();
+}
+
+
+/*
+    * Takes the next task of the thread's own range, or steals the upper half of the largest other range.
+*/
+bool ThreadPool::takeTask(size_t slot, size_t &task) {
+    Range &own = this->m_ranges[slot];
+
+    while(true) {
+        {
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if(own.begin < own.end) {
+                task = own.begin++;
+                return true;
+            }
+        }
+
+        size_t victim = slot;
+        size_t largest = 0;
+        for(size_t other = 0; other < this->m_thread_count; ++other) {
+            std::lock_guard<std::mutex> lock(this->m_ranges[other].mutex);
+            size_t remaining = this->m_ranges[other].end - this->m_ranges[other].begin;
+            if(other != slot && remaining > largest) {
+                largest = remaining;
+                victim = other;
+            }
+        }
+        if(largest == 0)
+            return false;
+
+        /* The victim may have progressed meanwhile, steal from whatever is left */
+        size_t begin, end;
+        {
+            std::lock_guard<std::mutex> lock(this->m_ranges[victim].mutex);
+            Range &range = this->m_ranges[victim];
+            if(range.begin >= range.end)
+                continue;
+            begin = range.begin + (range.end - range.begin) / 2;
+            end = range.end;
+            range.end = begin;
+        }
+        std::lock_guard<std::mutex> lock(own.mutex);
+        own.begin = begin;
+        own.end = end;
+    }
+}
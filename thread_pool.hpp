@@ -0,0 +1,58 @@
+#ifndef THREAD_POOL
+#define THREAD_POOL
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+    * A fixed set of worker threads running parallel loops with work stealing.
+    * A loop over [0, count) is split into one contiguous range per thread, every thread runs its
+     own range in ascending order and, once it is done, steals the upper half of the largest
+     remaining range of another thread.
+    * The calling thread takes part in the loop. A loop started from inside a task runs serially
+     on the calling thread, loops started from different threads run one after the other.
+*/
+class ThreadPool {
+public:
+    /* Create a pool of 'threads' threads (the calling thread included), 0 uses one per hardware thread. */
+    ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+
+    /*
+        * Runs task(i) for every i in [0, count) and returns once every task is done.
+    */
+    void parallelFor(size_t count, const std::function<void(size_t)> &task);
+
+    size_t getThreadCount() const;
+
+    /* A pool shared by the library, created on first use with one thread per hardware thread. */
+    static ThreadPool& shared();
+
+private:
+    struct Range;
+
+    void workerLoop(size_t slot);
+    void runTasks(size_t slot);
+    bool takeTask(size_t slot, size_t &task);
+
+    std::vector<std::thread> m_workers;
+    std::unique_ptr<Range[]> m_ranges;
+    size_t m_thread_count;
+
+    /* The running loop, published to the workers under m_mutex */
+    std::mutex m_loop_mutex;
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    const std::function<void(size_t)> *m_task;
+    size_t m_generation;
+    size_t m_running;
+    bool m_stop;
+};
+
+#endif
@@ -0,0 +1,67 @@
+#include "variant.hpp"
+#include "ambiguous_nucleotides.hpp"
+#include "packed_search.hpp"
+
+#include <cstdio>
+
+/* ----- Variant Utility Functions ----- */
+
+DNASequence applyVariants(const DNASequence &reference, const std::vector<Variant> &variants) {
+    const unsigned char *source = reference.getPackedSequence();
+    size_t source_size = reference.getSize();
+    size_t size = source_size;
+    size_t previous_end = 0;
+    PackedPattern pattern;
+
+    /* Validate everything first, so the result is written in one go */
+    for(const Variant &variant : variants) {
+        if(variant.position > source_size || variant.reference.size() > source_size - variant.position) {
+            printf("Variant Error: the variant at position %zu is outside of the reference!\n", variant.position);
+            return DNASequence();
+        }
+        if(variant.position < previous_end) {
+            printf("Variant Error: the variant at position %zu is not sorted or overlaps the previous one!\n",
+                   variant.position);
+            return DNASequence();
+        }
+        if(!packPattern(variant.reference.c_str(), variant.reference.size(), pattern) ||
+           !matchPackedPattern(source, source_size, pattern, variant.position) ||
+           overlapsAmbiguousRun(reference.m_ambiguous, variant.position, variant.position + variant.reference.size())) {
+            printf("Variant Error: the reference of the variant at position %zu does not match the sequence!\n",
+                   variant.position);
+            return DNASequence();
+        }
+        if(validateAmbiguousNucleotides(variant.alternate.c_str(), variant.alternate.size()) != variant.alternate.size()) {
+            printf("Variant Error: the alternate of the variant at position %zu has an invalid Nucleotide value!\n",
+                   variant.position);
+            return DNASequence();
+        }
+
+        previous_end = variant.position + variant.reference.size();
+        size = size - variant.reference.size() + variant.alternate.size();
+    }
+
+    DNASequence result;
+    unsigned char *sequence = reinterpret_cast<unsigned char*>(result.allocateSequence(size));
+    size_t read = 0;
+    size_t write = 0;
+
+    result.m_size = size;
+    if(size % 4)
+        sequence[size / 4] = 0;
+
+    for(const Variant &variant : variants) {
+        copyPackedNucleotides(source, source_size, read, sequence, size, write, variant.position - read);
+        copyAmbiguousRuns(reference.m_ambiguous, read, variant.position, write, result.m_ambiguous);
+        write += variant.position - read;
+
+        packAmbiguousNucleotides(variant.alternate.c_str(), variant.alternate.size(), sequence, size, write,
+                                 result.m_ambiguous);
+        write += variant.alternate.size();
+        read = variant.position + variant.reference.size();
+    }
+    copyPackedNucleotides(source, source_size, read, sequence, size, write, source_size - read);
+    copyAmbiguousRuns(reference.m_ambiguous, read, source_size, write, result.m_ambiguous);
+
+    return result;
+}
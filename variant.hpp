@@ -0,0 +1,34 @@
+#ifndef VARIANT
+#define VARIANT
+
+#include "dna_sequence.hpp"
+
+#include <string>
+#include <vector>
+
+/*
+    * A substitution, insertion or deletion against a reference sequence, written as in a VCF file:
+     the Nucleotides 'reference' starting at 'position' (0-based) are replaced by 'alternate'.
+    * A SNP has a single Nucleotide reference and alternate, an insertion or a deletion usually keeps
+     its preceding (anchor) Nucleotide in both. An empty reference inserts before 'position'.
+*/
+struct Variant {
+    size_t position;
+    std::string reference;
+    std::string alternate;
+};
+
+/*
+    * Returns the reference with the variants applied.
+    * The result is allocated once and built in a single pass over the packed reference: the unchanged
+     stretches between the variants are copied byte-wise (word-wise when they are realigned by an indel)
+     and the alternates are packed in place, so applying any number of indels costs linear time.
+    * The variants must be sorted by position and must not overlap, an insertion may follow a variant ending
+     at its position. Every 'reference' must match the reference sequence and every 'alternate' must be made of
+     valid Nucleotide values, otherwise an error message is printed/output and an empty sequence is returned.
+    * The ambiguous Nucleotides of the reference are kept, those of the alternates are added. A 'reference'
+     covering an ambiguous Nucleotide does not match.
+*/
+DNASequence applyVariants(const DNASequence &reference, const std::vector<Variant> &variants);
+
+#endif
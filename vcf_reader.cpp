@@ -0,0 +1,211 @@
+#include "vcf_reader.hpp"
+#include "ambiguous_nucleotides.hpp"
+
+#include <charconv>
+#include <cstdio>
+#include <string_view>
+
+/* ----- VCF Reader Utility Functions ----- */
+
+/*
+    * Returns the text of 'line' up to the next 'separator' and removes it, with the separator, from 'line'.
+*/
+static inline std::string_view nextField(std::string_view &line, char separator) {
+    size_t end = line.find(separator);
+    std::string_view field = line.substr(0, end);
+
+    line.remove_prefix(end == std::string_view::npos ? line.size() : end + 1);
+    return field;
+}
+
+
+/*
+    * Appends the alleles of a GT value ("0/1", "1|0", "./.", "1") to 'alleles'.
+*/
+static void parseGenotype(std::string_view genotype, std::vector<int> &alleles) {
+    while(!genotype.empty()) {
+        size_t end = genotype.find_first_of("/|");
+        std::string_view allele = genotype.substr(0, end);
+        int value = -1;
+
+        if(std::from_chars(allele.data(), allele.data() + allele.size(), value).ec != std::errc())
+            value = -1;
+        alleles.push_back(value);
+
+        if(end == std::string_view::npos)
+            break;
+        genotype.remove_prefix(end + 1);
+    }
+}
+
+
+std::vector<Variant> haplotypeVariants(const std::vector<VcfRecord> &records, size_t haplotype) {
+    std::vector<Variant> variants;
+    Variant variant;
+
+    for(const VcfRecord &record : records) {
+        if(record.getVariant(haplotype, variant))
+            variants.push_back(variant);
+    }
+    return variants;
+}
+
+
+/* ---------- VcfRecord Methods ---------- */
+
+bool VcfRecord::getVariant(size_t haplotype, Variant &variant) const {
+    int allele = this->alleles.empty() ? 1 : haplotype < this->alleles.size() ? this->alleles[haplotype] : -1;
+
+    if(allele <= 0 || size_t(allele) > this->alternates.size())
+        return false;
+
+    const std::string &alternate = this->alternates[allele - 1];
+    if(validateAmbiguousNucleotides(alternate.c_str(), alternate.size()) != alternate.size())
+        return false;
+
+    variant.position = this->position;
+    variant.reference = this->reference;
+    variant.alternate = alternate;
+    return true;
+}
+
+
+/* ---------- VcfReader Methods ---------- */
+
+VcfReader::VcfReader(const std::string &path) : m_file(path), m_stream(m_file) {
+    if(!m_file)
+        printf("VcfReader Error: could not open '%s'!\n", path.c_str());
+
+    this->m_line_number = 0;
+    this->m_pending = false;
+    this->readHeader();
+}
+
+
+VcfReader::VcfReader(std::istream &stream) : m_stream(stream) {
+    this->m_line_number = 0;
+    this->m_pending = false;
+    this->readHeader();
+}
+
+
+VcfReader::~VcfReader() {}
+
+
+bool VcfReader::next(VcfRecord &record) {
+    while(this->m_pending || std::getline(this->m_stream, this->m_line)) {
+        if(!this->m_pending)
+            ++this->m_line_number;
+        this->m_pending = false;
+
+        if(!this->m_line.empty() && this->m_line.back() == '\r')
+            this->m_line.pop_back();
+        if(this->m_line.empty() || this->m_line[0] == '#')
+            continue;
+
+        if(this->parseRecord(record))
+            return true;
+        printf("VcfReader Error: line %zu is not a valid VCF record, skipping it!\n", this->m_line_number);
+    }
+    return false;
+}
+
+
+std::vector<VcfRecord> VcfReader::readChromosome(const std::string &chromosome) {
+    std::vector<VcfRecord> records;
+    VcfRecord record;
+
+    while(this->next(record)) {
+        if(record.chromosome == chromosome)
+            records.push_back(std::move(record));
+    }
+    return records;
+}
+
+
+const std::vector<std::string>& VcfReader::getSamples() const {
+    return this->m_samples;
+}
+
+
+/* -- Private -- */
+
+/*
+    * Reads the lines starting with '#', the first data line is kept for the first call to next.
+*/
+void VcfReader::readHeader() {
+    while(std::getline(this->m_stream, this->m_line)) {
+        ++this->m_line_number;
+        if(!this->m_line.empty() && this->m_line.back() == '\r')
+            this->m_line.pop_back();
+
+        if(this->m_line.compare(0, 6, "#CHROM") == 0) {
+            std::string_view line(this->m_line);
+
+            /* CHROM POS ID REF ALT QUAL FILTER INFO FORMAT, then the samples */
+            for(size_t column = 0; !line.empty(); ++column) {
+                std::string_view field = nextField(line, '\t');
+                if(column >= 9)
+                    this->m_samples.emplace_back(field);
+            }
+        }
+        else if(this->m_line.empty() || this->m_line[0] != '#') {
+            this->m_pending = true;
+            return;
+        }
+    }
+}
+
+
+bool VcfReader::parseRecord(VcfRecord &record) {
+    std::string_view line(this->m_line);
+    std::string_view chromosome = nextField(line, '\t');
+    std::string_view position = nextField(line, '\t');
+    nextField(line, '\t');
+    std::string_view reference = nextField(line, '\t');
+
+    if(line.empty())
+        return false;
+
+    std::string_view alternates = nextField(line, '\t');
+    size_t pos = 0;
+    auto parsed = std::from_chars(position.data(), position.data() + position.size(), pos);
+    if(parsed.ec != std::errc() || parsed.ptr != position.data() + position.size() || pos == 0 || reference.empty())
+        return false;
+
+    record.chromosome.assign(chromosome);
+    record.position = pos - 1;
+    record.reference.assign(reference);
+    record.alternates.clear();
+    record.alleles.clear();
+
+    while(!alternates.empty() && alternates != ".")
+        record.alternates.emplace_back(nextField(alternates, ','));
+
+    /* QUAL FILTER INFO, then the position of GT in FORMAT */
+    for(int column = 0; column < 3; ++column)
+        nextField(line, '\t');
+
+    std::string_view format = nextField(line, '\t');
+    size_t gt = 0;
+    bool has_gt = false;
+    for(; !format.empty(); ++gt) {
+        if(nextField(format, ':') == "GT") {
+            has_gt = true;
+            break;
+        }
+    }
+    if(!has_gt)
+        return true;
+
+    while(!line.empty()) {
+        std::string_view sample = nextField(line, '\t');
+        size_t field = 0;
+
+        for(; field < gt && !sample.empty(); ++field)
+            nextField(sample, ':');
+        std::string_view genotype = field == gt ? nextField(sample, ':') : std::string_view();
+        parseGenotype(genotype.empty() ? "." : genotype, record.alleles);
+    }
+    return true;
+}
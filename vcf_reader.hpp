@@ -0,0 +1,79 @@
+#ifndef VCF_READER
+#define VCF_READER
+
+#include "variant.hpp"
+
+#include <fstream>
+#include <istream>
+#include <string>
+#include <vector>
+
+/*
+    * A VCF data line, the columns after ALT other than the genotypes are not kept.
+    * 'position' is 0-based (the POS column minus one), 'alternates' are the comma separated ALT alleles.
+    * 'alleles' holds the GT allele of every haplotype, sample after sample ("0|1" gives two haplotypes):
+     0 is the reference, i the i-th alternate and -1 a missing allele ('.').
+     It is empty when the file has no samples or the record has no GT field.
+*/
+struct VcfRecord {
+    std::string chromosome;
+    size_t position;
+    std::string reference;
+    std::vector<std::string> alternates;
+    std::vector<int> alleles;
+
+    /*
+        * Sets 'variant' to the alternate carried by haplotype number 'haplotype'.
+        * Without genotypes the first alternate is used.
+        * Returns false if the haplotype carries the reference, a missing allele or a symbolic
+         alternate ('*', "<DEL>", ...), which can not be applied. N and the IUPAC codes are kept.
+    */
+    bool getVariant(size_t haplotype, Variant &variant) const;
+};
+
+/*
+    * Reads the subset of VCF needed to build sequences: CHROM, POS, REF, ALT and the GT field of the samples.
+    * The meta-information lines ("##...") are skipped, the sample names come from the "#CHROM" header line.
+    * A malformed data line is skipped with an error message.
+*/
+class VcfReader {
+public:
+    /* Reads the file at 'path', an error message is printed if it can not be opened. */
+    VcfReader(const std::string &path);
+
+    /* Reads from 'stream', which must outlive the reader. */
+    VcfReader(std::istream &stream);
+
+    ~VcfReader();
+
+    /*
+        * Reads the next record into 'record'.
+        * Returns false once there are no more records.
+    */
+    bool next(VcfRecord &record);
+
+    /* Reads every remaining record of the chromosome, the other records are skipped. */
+    std::vector<VcfRecord> readChromosome(const std::string &chromosome);
+
+    /* The sample names, read with the header when the reader is created */
+    const std::vector<std::string>& getSamples() const;
+
+private:
+    void readHeader();
+    bool parseRecord(VcfRecord &record);
+
+    std::ifstream m_file;
+    std::istream &m_stream;
+    std::string m_line;
+    size_t m_line_number;
+    bool m_pending;
+    std::vector<std::string> m_samples;
+};
+
+/*
+    * Returns the variants carried by haplotype number 'haplotype' in the records, ready for applyVariants.
+    * The records must be sorted by position, as they are in a VCF file.
+*/
+std::vector<Variant> haplotypeVariants(const std::vector<VcfRecord> &records, size_t haplotype);
+
+#endif